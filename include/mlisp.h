@@ -1,7 +1,9 @@
 #if defined(MLISP_NOINCLUDE)
-    typedef struct mpc_parser_t mpc_parser_t;
     typedef struct mpc_err_t mpc_err_t;
-    typedef struct mpc_ast_t mpc_ast_t;
+
+    // Syntax errors of the reader (see parser.h)
+    char* mpc_err_string(mpc_err_t* e);
+    void mpc_err_delete(mpc_err_t* e);
 #else
     #include "mpc.h"
 #endif
@@ -12,8 +14,19 @@
     #include "utils.h"
 #endif
 
+#include "alloc.h"
+#include "bignum.h"
+#include "vector.h"
+#include "sequence.h"
+#include "dict.h"
+#include "array.h"
+#include "gc.h"
+#include "image.h"
+#include "cache.h"
 #include "parser.h"
+#include "symbol.h"
 #include "builtins/builtin.h"
 #include "eval.h"
+#include "vm.h"
 #include "lenv.h"
 #include "lval.h"
@@ -0,0 +1,245 @@
+#include <stdint.h>
+
+#include "utils.h"
+#include "alloc.h"
+
+#if defined _WIN32
+    #include <malloc.h>
+    #define slab_memalign(size) _aligned_malloc(size, size)
+    #define slab_memfree(ptr)   _aligned_free(ptr)
+#else
+    #define slab_memalign(size) aligned_alloc(size, size)
+    #define slab_memfree(ptr)   free(ptr)
+#endif
+
+
+/// The number of size classes.
+#define ALLOC_CLASS_COUNT (ALLOC_MAX_SIZE / ALLOC_CLASS_STEP)
+
+struct lpool;
+
+/// A slab: a header followed by the objects of one size class.
+typedef struct lslab {
+    struct lslab* next;     ///< The next slab of the pool.
+    struct lslab* partial;  ///< The next slab with free objects.
+    struct lpool* pool;     ///< The pool the slab belongs to.
+    void* free;             ///< The free list of this slab.
+    size_t live;            ///< The number of objects in use.
+    size_t bump;            ///< The number of objects ever handed out.
+    bool listed;            ///< Whether the slab is current or in the partial list.
+} lslab;
+
+/// All slabs of a size class.
+typedef struct lpool {
+    size_t size;        ///< The object size.
+    size_t capacity;    ///< The number of objects per slab.
+    lslab* slabs;       ///< All slabs of this pool.
+    lslab* current;     ///< The slab to allocate from.
+    lslab* partial;     ///< Slabs that got objects freed after they were full.
+} lpool;
+
+/// The size of the slab header, rounded up to keep the objects aligned.
+static const size_t SLAB_HEADER_SIZE = (sizeof(lslab) + ALLOC_CLASS_STEP - 1)
+                                       / ALLOC_CLASS_STEP * ALLOC_CLASS_STEP;
+
+static lpool pools[ALLOC_CLASS_COUNT];
+
+#if defined DEBUG
+    static long slab_count = 0;
+    static long released_count = 0;
+#endif
+
+
+/// Get the size class of an object size.
+static size_t size_class(size_t size) {
+    return (size - 1) / ALLOC_CLASS_STEP;
+}
+
+/// Get the slab containing an object.
+static lslab* slab_of(void* ptr) {
+    return (lslab*) ((uintptr_t) ptr & ~((uintptr_t) ALLOC_SLAB_SIZE - 1));
+}
+
+/// Whether a slab has objects left to hand out.
+static bool slab_available(lpool* pool, lslab* slab) {
+    return slab->free != NULL || slab->bump < pool->capacity;
+}
+
+/// Allocate a new slab and make it the pool's current slab.
+static lslab* slab_new(lpool* pool) {
+    lslab* slab = slab_memalign(ALLOC_SLAB_SIZE);
+    if (!slab) {
+        die("[FATAL ERROR] Out of memory, slab allocation failed!\n");
+    }
+
+#if defined DEBUG
+    slab_count += 1;
+#endif
+
+    slab->pool    = pool;
+    slab->free    = NULL;
+    slab->live    = 0;
+    slab->bump    = 0;
+    slab->listed  = true;
+    slab->partial = NULL;
+    slab->next    = pool->slabs;
+    pool->slabs   = slab;
+
+    return slab;
+}
+
+/// Find a slab with free objects, allocating a new one if needed.
+static lslab* pool_slab(lpool* pool) {
+    lslab* slab = pool->current;
+    if (slab && slab_available(pool, slab)) {
+        return slab;
+    }
+
+    // The current slab is full. It will be listed again once an
+    // object in it is freed.
+    if (slab) {
+        slab->listed = false;
+    }
+
+    if (pool->partial) {
+        slab = pool->partial;
+        pool->partial = slab->partial;
+    } else {
+        slab = slab_new(pool);
+    }
+
+    pool->current = slab;
+    return slab;
+}
+
+static void* pool_alloc(lpool* pool) {
+    lslab* slab = pool_slab(pool);
+    void* ptr;
+
+    if (slab->free) {
+        ptr = slab->free;
+        slab->free = *(void**) ptr;
+    } else {
+        ptr = (char*) slab + SLAB_HEADER_SIZE + slab->bump * pool->size;
+        slab->bump++;
+    }
+
+    slab->live++;
+    return ptr;
+}
+
+static void pool_free(lpool* pool, void* ptr) {
+    lslab* slab = slab_of(ptr);
+    ASSERTF(slab->pool == pool, "freeing %p with the wrong size", ptr);
+
+    *(void**) ptr = slab->free;
+    slab->free = ptr;
+    slab->live--;
+
+    // The slab was full: make it available again
+    if (!slab->listed) {
+        slab->listed  = true;
+        slab->partial = pool->partial;
+        pool->partial = slab;
+    }
+}
+
+static lpool* get_pool(size_t size) {
+    lpool* pool = &pools[size_class(size)];
+
+    if (pool->size == 0) {
+        pool->size = (size_class(size) + 1) * ALLOC_CLASS_STEP;
+        pool->capacity = (ALLOC_SLAB_SIZE - SLAB_HEADER_SIZE) / pool->size;
+    }
+
+    return pool;
+}
+
+void* lalloc(size_t size) {
+    if (size == 0) {
+        return NULL;
+    } else if (size > ALLOC_MAX_SIZE) {
+        return xmalloc(size);
+    }
+
+    return pool_alloc(get_pool(size));
+}
+
+void lfree(void* ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    } else if (size > ALLOC_MAX_SIZE) {
+        xfree(ptr);
+        return;
+    }
+
+    pool_free(get_pool(size), ptr);
+}
+
+void* lrealloc(void* ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) {
+        return lalloc(new_size);
+    } else if (new_size == 0) {
+        lfree(ptr, old_size);
+        return NULL;
+    }
+
+    if (old_size > ALLOC_MAX_SIZE && new_size > ALLOC_MAX_SIZE) {
+        return xrealloc(ptr, new_size);
+    } else if (old_size <= ALLOC_MAX_SIZE && new_size <= ALLOC_MAX_SIZE
+               && size_class(old_size) == size_class(new_size)) {
+        return ptr;
+    }
+
+    void* moved = lalloc(new_size);
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    lfree(ptr, old_size);
+
+    return moved;
+}
+
+void lalloc_reset(void) {
+    for (size_t c = 0; c < ALLOC_CLASS_COUNT; c++) {
+        lpool* pool = &pools[c];
+        lslab** link = &pool->slabs;
+
+        pool->partial = NULL;
+
+        // Release empty slabs, rebuild the partial list from the others
+        while (*link) {
+            lslab* slab = *link;
+
+            if (slab->live == 0 && slab != pool->current) {
+                *link = slab->next;
+                slab_memfree(slab);
+#if defined DEBUG
+                released_count += 1;
+#endif
+                continue;
+            }
+
+            if (slab != pool->current) {
+                slab->listed = slab_available(pool, slab);
+                if (slab->listed) {
+                    slab->partial = pool->partial;
+                    pool->partial = slab;
+                }
+            }
+
+            link = &slab->next;
+        }
+    }
+}
+
+void lalloc_end_eval(void) {
+#if defined ALLOC_ARENA
+    lalloc_reset();
+#endif
+}
+
+#if defined DEBUG
+    void lalloc_print_stats(void) {
+        printf("Number of allocated slabs:     %ld\n", slab_count);
+        printf("Number of released slabs:      %ld\n", released_count);
+    }
+#endif
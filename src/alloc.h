@@ -0,0 +1,84 @@
+/**
+ * \file    alloc.h
+ * \brief   Slab allocator for small objects (#lval nodes, value arrays).
+ *
+ * Small allocations are grouped in size classes of 16 bytes. Each size class
+ * hands out objects from slabs (big, aligned memory blocks) and keeps the
+ * freed objects in a free list, so allocating and freeing an object is just
+ * a pointer swap. Bigger allocations are passed to #xmalloc.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stddef.h>
+#endif
+
+#include "config.h"
+
+
+/// The size of a slab in bytes. Slabs are aligned to their size.
+#define ALLOC_SLAB_SIZE 16384
+
+/// The granularity of the size classes in bytes.
+#define ALLOC_CLASS_STEP 16
+
+/// The biggest object size served from a slab.
+#define ALLOC_MAX_SIZE 256
+
+
+/**
+ * Allocate memory for a small object.
+ *
+ * The memory won't be initialized. This function is guaranteed to return a
+ * valid pointer (or `NULL` if `size` is 0).
+ *
+ * \param size  The size of the memory to allocate.
+ *
+ * \returns A pointer to the allocated memory.
+ */
+void* lalloc(size_t size);
+
+/**
+ * Free memory allocated by #lalloc.
+ *
+ * \param ptr   The memory to free (may be `NULL`).
+ * \param size  The size that was passed to #lalloc.
+ */
+void lfree(void* ptr, size_t size);
+
+/**
+ * Resize memory allocated by #lalloc.
+ *
+ * If both sizes belong to the same size class, the memory isn't moved.
+ *
+ * \param ptr       The memory to resize (may be `NULL`).
+ * \param old_size  The current size of the memory block.
+ * \param new_size  The new size of the memory block.
+ *
+ * \returns A pointer to the resized memory (**might be moved!**)
+ */
+void* lrealloc(void* ptr, size_t old_size, size_t new_size);
+
+/**
+ * Release memory of the current evaluation.
+ *
+ * Return all slabs that don't contain any living object to the system. This
+ * is always safe to call, objects still in use are never touched. In arena
+ * mode (see #ALLOC_ARENA) this is done after every top-level evaluation so the
+ * temporaries of one evaluation are released at once.
+ */
+void lalloc_reset(void);
+
+/**
+ * Release memory after a top-level evaluation if arena mode is enabled.
+ *
+ * \see lalloc_reset
+ */
+void lalloc_end_eval(void);
+
+#if defined DEBUG
+    /**
+     * Print some allocator statistics.
+     */
+    void lalloc_print_stats(void);
+#endif
@@ -0,0 +1,263 @@
+#include <string.h>
+
+#include "utils.h"
+#include "alloc.h"
+#include "lval.h"
+#include "array.h"
+
+/// The number of bits of the index used by each level.
+#define LEVEL_BITS 5
+
+/// The number of children of a node.
+#define WIDTH (1 << LEVEL_BITS)
+
+/// Get the slot of an index at a level.
+#define SLOT(index, shift) ((size_t) ((index) >> (shift)) & (WIDTH - 1))
+
+/// A node of the trie, its slots are children or items in the leaves.
+typedef struct larray_node {
+    size_t refcount;            ///< The number of arrays and nodes sharing
+                                ///< this node.
+    union {
+        struct larray_node* child;
+        lval* item;
+    } slots[WIDTH];             ///< The children or items, `NULL` if unused.
+} larray_node;
+
+/// Get the number of indices of a trie with its root at `shift`.
+static inline uint64_t capacity(unsigned shift) {
+    return (uint64_t) 1 << (shift + LEVEL_BITS);
+}
+
+/// Allocate a node with empty slots.
+static larray_node* node_new(void) {
+    larray_node* node = lalloc(sizeof(larray_node));
+    memset(node, 0, sizeof(larray_node));
+    node->refcount = 1;
+
+    return node;
+}
+
+/// Drop a reference to a node and delete it if it was the last one.
+static void node_del(larray_node* node, unsigned shift) {
+    if (--node->refcount > 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < WIDTH; i++) {
+        if (shift == 0 && node->slots[i].item) {
+            lval_del(node->slots[i].item);
+        } else if (shift > 0 && node->slots[i].child) {
+            node_del(node->slots[i].child, shift - LEVEL_BITS);
+        }
+    }
+
+    lfree(node, sizeof(larray_node));
+}
+
+/**
+ * Get a node that may be modified.
+ *
+ * \param node  The node (the caller's reference is moved to the result) or
+ *              `NULL`.
+ * \param shift The level of the node.
+ *
+ * \returns The node itself if it isn't shared, a copy or a new node
+ *          otherwise.
+ */
+static larray_node* node_own(larray_node* node, unsigned shift) {
+    if (node == NULL) {
+        return node_new();
+    } else if (node->refcount == 1) {
+        return node;
+    }
+
+    larray_node* copy = lalloc(sizeof(larray_node));
+    memcpy(copy, node, sizeof(larray_node));
+    copy->refcount = 1;
+
+    for (size_t i = 0; i < WIDTH; i++) {
+        if (shift == 0 && copy->slots[i].item) {
+            lval_ref(copy->slots[i].item);
+        } else if (shift > 0 && copy->slots[i].child) {
+            copy->slots[i].child->refcount++;
+        }
+    }
+
+    node->refcount--;
+    return copy;
+}
+
+/**
+ * Store an item below a node.
+ *
+ * \param node  The node (the caller's reference is moved to the result) or
+ *              `NULL`.
+ * \param shift The level of the node.
+ * \param index The index of the item in the trie.
+ * \param value The item (consumed).
+ *
+ * \returns The node replacing `node`.
+ */
+static larray_node* node_set(larray_node* node, unsigned shift, uint64_t index, lval* value) {
+    node = node_own(node, shift);
+    size_t slot = SLOT(index, shift);
+
+    if (shift == 0) {
+        // The slot may hold an item outside the window of a slice
+        if (node->slots[slot].item) {
+            lval_del(node->slots[slot].item);
+        }
+        node->slots[slot].item = value;
+    } else {
+        node->slots[slot].child = node_set(node->slots[slot].child, shift - LEVEL_BITS, index, value);
+    }
+
+    return node;
+}
+
+/// Call a function for each item below a node.
+static void node_each(larray_node* node, unsigned shift, void (*func)(lval*)) {
+    for (size_t i = 0; i < WIDTH; i++) {
+        if (shift == 0 && node->slots[i].item) {
+            func(node->slots[i].item);
+        } else if (shift > 0 && node->slots[i].child) {
+            node_each(node->slots[i].child, shift - LEVEL_BITS, func);
+        }
+    }
+}
+
+/// Make the root the child in `slot` of a new root one level higher.
+static void grow(larray* array, size_t slot) {
+    if (array->root) {
+        larray_node* root = node_new();
+        root->slots[slot].child = array->root;
+        array->root = root;
+    }
+
+    array->start += (uint64_t) slot << (array->shift + LEVEL_BITS);
+    array->shift += LEVEL_BITS;
+}
+
+
+larray* larray_new(void) {
+    larray* array = xmalloc(sizeof(larray));
+    array->count = 0;
+    array->start = 0;
+    array->shift = 0;
+    array->root  = NULL;
+
+    return array;
+}
+
+larray* larray_copy(larray* array) {
+    ASSERT_NOT_NULL(array);
+
+    larray* copy = xmalloc(sizeof(larray));
+    memcpy(copy, array, sizeof(larray));
+
+    if (copy->root) {
+        copy->root->refcount++;
+    }
+
+    return copy;
+}
+
+void larray_del(larray* array) {
+    ASSERT_NOT_NULL(array);
+
+    if (array->root) {
+        node_del(array->root, array->shift);
+    }
+    xfree(array);
+}
+
+lval* larray_get(larray* array, size_t index) {
+    ASSERT_NOT_NULL(array);
+    ASSERTF(index < array->count, "array index out of range");
+
+    uint64_t position = array->start + index;
+    larray_node* node = array->root;
+
+    for (unsigned shift = array->shift; shift > 0; shift -= LEVEL_BITS) {
+        node = node->slots[SLOT(position, shift)].child;
+    }
+
+    return node->slots[SLOT(position, 0)].item;
+}
+
+void larray_set(larray* array, size_t index, lval* value) {
+    ASSERT_NOT_NULL(array);
+    ASSERTF(index < array->count, "array index out of range");
+
+    array->root = node_set(array->root, array->shift, array->start + index, value);
+}
+
+void larray_push(larray* array, lval* value) {
+    ASSERT_NOT_NULL(array);
+
+    while (array->start + array->count >= capacity(array->shift)) {
+        grow(array, 0);
+    }
+
+    array->root = node_set(array->root, array->shift, array->start + array->count, value);
+    array->count++;
+}
+
+void larray_prepend(larray* array, lval* value) {
+    ASSERT_NOT_NULL(array);
+
+    // Keep room on both sides
+    while (array->start == 0) {
+        grow(array, WIDTH / 2);
+    }
+
+    array->start--;
+    array->root = node_set(array->root, array->shift, array->start, value);
+    array->count++;
+}
+
+void larray_slice(larray* array, size_t start, size_t end) {
+    ASSERT_NOT_NULL(array);
+    ASSERTF(start <= end && end <= array->count, "array slice out of range");
+
+    array->start += start;
+    array->count  = end - start;
+
+    if (array->count == 0) {
+        if (array->root) {
+            node_del(array->root, array->shift);
+        }
+        array->start = 0;
+        array->shift = 0;
+        array->root  = NULL;
+        return;
+    }
+
+    // Drop the levels above the lowest node holding the whole window
+    uint64_t first = array->start;
+    uint64_t last  = array->start + array->count - 1;
+
+    while (array->shift > 0 && (first >> array->shift) == (last >> array->shift)) {
+        size_t slot = SLOT(first, array->shift);
+        larray_node* child = array->root->slots[slot].child;
+
+        child->refcount++;
+        node_del(array->root, array->shift);
+
+        array->root   = child;
+        array->start -= (uint64_t) slot << array->shift;
+        array->shift -= LEVEL_BITS;
+        first = array->start;
+        last  = array->start + array->count - 1;
+    }
+}
+
+void larray_each(larray* array, void (*func)(lval*)) {
+    ASSERT_NOT_NULL(array);
+    ASSERT_NOT_NULL(func);
+
+    if (array->root) {
+        node_each(array->root, array->shift, func);
+    }
+}
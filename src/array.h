@@ -0,0 +1,119 @@
+/**
+ * \file    array.h
+ * \brief   Persistent arrays.
+ *
+ * An array holds its items in the leaves of a trie: each level of the trie
+ * uses five bits of an item's index to select one of 32 children. Getting,
+ * updating, appending and prepending an item take O(log32 n) steps, and a
+ * slice only moves the window of indices the array uses.
+ *
+ * Nodes are reference counted and shared between arrays: copying an array
+ * only shares its root, and an update copies just the nodes on the path to
+ * the changed item, so the copies made when a shared value is modified (see
+ * #lval_unshare) stay cheap. Nodes that aren't shared are updated in place.
+ *
+ * The window of an array can grow in both directions: when it reaches the
+ * start or the end of the trie, the root becomes a child of a new root one
+ * level higher. Like the slices of a list, a slice keeps the items outside
+ * of its window, as long as it shares them with another array.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stddef.h>
+    #include <stdint.h>
+#endif
+
+#include "config.h"
+
+
+// Forward declarations
+struct lval;
+struct larray_node;
+
+/// A persistent array.
+typedef struct larray {
+    size_t count;               ///< The number of items.
+    uint64_t start;             ///< The index of the first item in the trie.
+    unsigned shift;             ///< The position of the bits of the indices
+                                ///< used by the root, 0 if it's a leaf.
+    struct larray_node* root;   ///< The root of the trie, `NULL` if empty.
+} larray;
+
+
+/**
+ * Create an empty array.
+ *
+ * \returns The array. Has to be deleted with #larray_del!
+ */
+larray* larray_new(void);
+
+/**
+ * Copy an array, sharing all items.
+ *
+ * \param array The array to copy.
+ *
+ * \returns The copy. Has to be deleted with #larray_del!
+ */
+larray* larray_copy(larray* array);
+
+/**
+ * Delete an array, dropping the references to the items it doesn't share.
+ *
+ * \param array The array to delete.
+ */
+void larray_del(larray* array);
+
+/**
+ * Get an item.
+ *
+ * \param array The array.
+ * \param index The index of the item, less than the number of items.
+ *
+ * \returns The item (not referenced).
+ */
+struct lval* larray_get(larray* array, size_t index);
+
+/**
+ * Replace an item.
+ *
+ * \param array The array, which must not be shared.
+ * \param index The index of the item, less than the number of items.
+ * \param value The new item (consumed).
+ */
+void larray_set(larray* array, size_t index, struct lval* value);
+
+/**
+ * Add an item after the last one.
+ *
+ * \param array The array, which must not be shared.
+ * \param value The item (consumed).
+ */
+void larray_push(larray* array, struct lval* value);
+
+/**
+ * Add an item before the first one.
+ *
+ * \param array The array, which must not be shared.
+ * \param value The item (consumed).
+ */
+void larray_prepend(larray* array, struct lval* value);
+
+/**
+ * Keep a range of the items.
+ *
+ * \param array The array, which must not be shared.
+ * \param start The index of the first item to keep.
+ * \param end   The index after the last item to keep, not less than `start`
+ *              and not greater than the number of items.
+ */
+void larray_slice(larray* array, size_t start, size_t end);
+
+/**
+ * Call a function for each item an array holds a reference to, including
+ * the items outside of its window (like the garbage collector needs to).
+ *
+ * \param array The array.
+ * \param func  The function to call.
+ */
+void larray_each(larray* array, void (*func)(struct lval*));
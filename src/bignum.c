@@ -0,0 +1,538 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "utils.h"
+#include "bignum.h"
+
+
+/// The base of the digits of a big integer.
+#define DIGIT_BASE ((uint64_t) 1 << 32)
+
+/// The biggest power of ten that fits a digit, used for decimal conversion.
+#define DECIMAL_BASE 1000000000u
+
+/// The number of decimal digits in #DECIMAL_BASE.
+#define DECIMAL_DIGITS 9
+
+
+// ------------------------------------------------------------------------------
+// Magnitudes: digits in base 2^32, least significant first
+
+/// Get the number of digits of a magnitude without leading zeros.
+static size_t mag_len(const uint32_t* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+/// Compare two magnitudes without leading zeros.
+static int mag_cmp(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (na != nb) {
+        return na < nb ? -1 : 1;
+    }
+
+    for (size_t i = na; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+/// Compute `out = a + b`, `out` has room for `max(na, nb) + 1` digits.
+static void mag_add(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+    if (na < nb) {
+        const uint32_t* tmp = a; a = b; b = tmp;
+        size_t ntmp = na; na = nb; nb = ntmp;
+    }
+
+    uint64_t carry = 0;
+    size_t i = 0;
+
+    for (; i < nb; i++) {
+        uint64_t sum = (uint64_t) a[i] + b[i] + carry;
+        out[i] = (uint32_t) sum;
+        carry = sum >> 32;
+    }
+    for (; i < na; i++) {
+        uint64_t sum = (uint64_t) a[i] + carry;
+        out[i] = (uint32_t) sum;
+        carry = sum >> 32;
+    }
+
+    out[na] = (uint32_t) carry;
+}
+
+/// Compute `out = a - b` for `a >= b` and `na >= nb`, `out` may be `a`.
+static void mag_sub(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+    uint64_t borrow = 0;
+
+    for (size_t i = 0; i < na; i++) {
+        uint64_t diff = (uint64_t) a[i] - (i < nb ? b[i] : 0) - borrow;
+        out[i] = (uint32_t) diff;
+        borrow = (diff >> 32) & 1;
+    }
+}
+
+/// Add `b` to the `n` digits of `out` in place, the sum has to fit.
+static void mag_add_to(uint32_t* out, size_t n, const uint32_t* b, size_t nb) {
+    uint64_t carry = 0;
+    size_t i = 0;
+
+    for (; i < nb; i++) {
+        uint64_t sum = (uint64_t) out[i] + b[i] + carry;
+        out[i] = (uint32_t) sum;
+        carry = sum >> 32;
+    }
+    for (; carry && i < n; i++) {
+        uint64_t sum = (uint64_t) out[i] + carry;
+        out[i] = (uint32_t) sum;
+        carry = sum >> 32;
+    }
+}
+
+/// Compute `out = a * b` with the schoolbook method, `out` has room for
+/// `na + nb` digits.
+static void mag_mul_school(const uint32_t* a, size_t na, const uint32_t* b, size_t nb,
+                           uint32_t* out) {
+    memset(out, 0, sizeof(uint32_t) * (na + nb));
+
+    for (size_t i = 0; i < na; i++) {
+        uint64_t carry = 0;
+        if (a[i] == 0) {
+            continue;
+        }
+
+        for (size_t j = 0; j < nb; j++) {
+            uint64_t product = (uint64_t) a[i] * b[j] + out[i + j] + carry;
+            out[i + j] = (uint32_t) product;
+            carry = product >> 32;
+        }
+        out[i + nb] = (uint32_t) carry;
+    }
+}
+
+/**
+ * Compute `out = a * b`, `out` has room for `na + nb` digits.
+ *
+ * Splits both operands at half of the longer one: with `a = a1 B^m + a0` and
+ * `b = b1 B^m + b0`, the product is `z2 B^2m + z1 B^m + z0` where `z0 = a0 b0`,
+ * `z2 = a1 b1` and `z1 = (a0 + a1)(b0 + b1) - z0 - z2` takes one
+ * multiplication instead of two. If `b` is shorter than the split, `b` is
+ * multiplied with both halves of `a` instead.
+ */
+static void mag_mul(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+    if (na < nb) {
+        const uint32_t* tmp = a; a = b; b = tmp;
+        size_t ntmp = na; na = nb; nb = ntmp;
+    }
+
+    if (nb < BIGNUM_KARATSUBA_THRESHOLD) {
+        mag_mul_school(a, na, b, nb, out);
+        return;
+    }
+
+    size_t m = na / 2;
+
+    if (nb <= m) {
+        uint32_t* high = xmalloc(sizeof(uint32_t) * (na - m + nb));
+
+        mag_mul(a, m, b, nb, out);
+        memset(out + m + nb, 0, sizeof(uint32_t) * (na - m));
+
+        mag_mul(a + m, na - m, b, nb, high);
+        mag_add_to(out + m, na + nb - m, high, mag_len(high, na - m + nb));
+
+        xfree(high);
+        return;
+    }
+
+    // z0 and z2 are written to the low and high digits of the product
+    mag_mul(a, m, b, m, out);
+    mag_mul(a + m, na - m, b + m, nb - m, out + 2 * m);
+
+    size_t nsa = na - m + 1;
+    size_t nsb = (nb - m > m ? nb - m : m) + 1;
+    uint32_t* sa = xmalloc(sizeof(uint32_t) * nsa);
+    uint32_t* sb = xmalloc(sizeof(uint32_t) * nsb);
+    uint32_t* z1 = xmalloc(sizeof(uint32_t) * (nsa + nsb));
+
+    mag_add(a, m, a + m, na - m, sa);
+    mag_add(b, m, b + m, nb - m, sb);
+    mag_mul(sa, nsa, sb, nsb, z1);
+
+    mag_sub(z1, nsa + nsb, out, mag_len(out, 2 * m), z1);
+    mag_sub(z1, nsa + nsb, out + 2 * m, mag_len(out + 2 * m, na + nb - 2 * m), z1);
+    mag_add_to(out + m, na + nb - m, z1, mag_len(z1, nsa + nsb));
+
+    xfree(sa);
+    xfree(sb);
+    xfree(z1);
+}
+
+/// Divide the `n` digits of `a` by `divisor` in place, return the remainder.
+static uint32_t mag_div_digit(uint32_t* a, size_t n, uint32_t divisor) {
+    uint64_t remainder = 0;
+
+    for (size_t i = n; i-- > 0;) {
+        uint64_t current = (remainder << 32) | a[i];
+        a[i] = (uint32_t) (current / divisor);
+        remainder = current % divisor;
+    }
+
+    return (uint32_t) remainder;
+}
+
+/**
+ * Divide two magnitudes with Knuth's algorithm D.
+ *
+ * \param u     The dividend, `nu >= nv`.
+ * \param v     The divisor without leading zeros.
+ * \param q     [out] The quotient, room for `nu - nv + 1` digits.
+ * \param r     [out] The remainder, room for `nv` digits.
+ */
+static void mag_divmod(const uint32_t* u, size_t nu, const uint32_t* v, size_t nv,
+                       uint32_t* q, uint32_t* r) {
+    if (nv == 1) {
+        memcpy(q, u, sizeof(uint32_t) * nu);
+        r[0] = mag_div_digit(q, nu, v[0]);
+        return;
+    }
+
+    // Shift both so the divisor's top digit has its highest bit set, this
+    // keeps the estimates of the quotient's digits off by at most two
+    int shift = 0;
+    while (((v[nv - 1] << shift) & 0x80000000u) == 0) {
+        shift++;
+    }
+
+    uint32_t* vn = xmalloc(sizeof(uint32_t) * nv);
+    uint32_t* un = xmalloc(sizeof(uint32_t) * (nu + 1));
+
+    for (size_t i = nv - 1; i > 0; i--) {
+        vn[i] = (v[i] << shift) | (shift ? v[i - 1] >> (32 - shift) : 0);
+    }
+    vn[0] = v[0] << shift;
+
+    un[nu] = shift ? u[nu - 1] >> (32 - shift) : 0;
+    for (size_t i = nu - 1; i > 0; i--) {
+        un[i] = (u[i] << shift) | (shift ? u[i - 1] >> (32 - shift) : 0);
+    }
+    un[0] = u[0] << shift;
+
+    for (size_t j = nu - nv + 1; j-- > 0;) {
+        // Estimate the digit from the top two digits
+        uint64_t top = ((uint64_t) un[j + nv] << 32) | un[j + nv - 1];
+        uint64_t qhat = top / vn[nv - 1];
+        uint64_t rhat = top % vn[nv - 1];
+
+        while (qhat >= DIGIT_BASE || qhat * vn[nv - 2] > ((rhat << 32) | un[j + nv - 2])) {
+            qhat--;
+            rhat += vn[nv - 1];
+            if (rhat >= DIGIT_BASE) {
+                break;
+            }
+        }
+
+        // Multiply and subtract
+        int64_t borrow = 0;
+        int64_t diff;
+        for (size_t i = 0; i < nv; i++) {
+            uint64_t product = qhat * vn[i];
+            diff = (int64_t) un[i + j] - borrow - (int64_t) (product & 0xFFFFFFFFu);
+            un[i + j] = (uint32_t) diff;
+            borrow = (int64_t) (product >> 32) - (diff >> 32);
+        }
+        diff = (int64_t) un[j + nv] - borrow;
+        un[j + nv] = (uint32_t) diff;
+
+        q[j] = (uint32_t) qhat;
+
+        // The estimate was one too big, add the divisor back
+        if (diff < 0) {
+            q[j]--;
+
+            uint64_t carry = 0;
+            for (size_t i = 0; i < nv; i++) {
+                uint64_t sum = (uint64_t) un[i + j] + vn[i] + carry;
+                un[i + j] = (uint32_t) sum;
+                carry = sum >> 32;
+            }
+            un[j + nv] += (uint32_t) carry;
+        }
+    }
+
+    for (size_t i = 0; i < nv; i++) {
+        r[i] = (un[i] >> shift) | (shift ? un[i + 1] << (32 - shift) : 0);
+    }
+
+    xfree(vn);
+    xfree(un);
+}
+
+
+// ------------------------------------------------------------------------------
+// Big integers
+
+/// Allocate a positive big integer with room for `count` digits.
+static lbig* big_new(size_t count) {
+    lbig* x = xmalloc(sizeof(lbig) + sizeof(uint32_t) * count);
+    x->negative = false;
+    x->count = count;
+
+    return x;
+}
+
+/// Drop the leading zeros of a big integer, zero is never negative.
+static lbig* big_trim(lbig* x) {
+    x->count = mag_len(x->digits, x->count);
+    if (x->count == 0) {
+        x->negative = false;
+    }
+
+    return x;
+}
+
+lbig* lbig_from_int(PRECISION_INT value) {
+    uint64_t magnitude = value < 0 ? (uint64_t) 0 - (uint64_t) value : (uint64_t) value;
+
+    lbig* x = big_new(2);
+    x->negative = value < 0;
+    x->digits[0] = (uint32_t) magnitude;
+    x->digits[1] = (uint32_t) (magnitude >> 32);
+
+    return big_trim(x);
+}
+
+lbig* lbig_from_float(PRECISION_FLOAT value) {
+    ASSERTF(isfinite(value), "Not a finite float: %f", value);
+
+    // Dividing integral floats by the digit base is exact
+    PRECISION_FLOAT magnitude = fabs(trunc(value));
+    int exponent;
+    frexp(magnitude, &exponent);
+
+    size_t count = exponent > 0 ? (size_t) exponent / 32 + 1 : 1;
+    lbig* x = big_new(count);
+    x->negative = value < 0;
+
+    for (size_t i = 0; i < count; i++) {
+        PRECISION_FLOAT digit = fmod(magnitude, (PRECISION_FLOAT) DIGIT_BASE);
+        x->digits[i] = (uint32_t) digit;
+        magnitude = (magnitude - digit) / (PRECISION_FLOAT) DIGIT_BASE;
+    }
+
+    return big_trim(x);
+}
+
+lbig* lbig_from_str(char* str, size_t length) {
+    bool negative = length > 0 && str[0] == '-';
+    if (negative) {
+        str++;
+        length--;
+    }
+
+    if (length == 0) {
+        return NULL;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (str[i] < '0' || str[i] > '9') {
+            return NULL;
+        }
+    }
+
+    // A digit holds more than nine decimal digits
+    lbig* x = big_new(length / DECIMAL_DIGITS + 1);
+    x->count = 0;
+
+    // Multiply by 10^9 and add the next nine decimal digits
+    size_t pos = 0;
+    size_t chunk_length = length % DECIMAL_DIGITS ? length % DECIMAL_DIGITS : DECIMAL_DIGITS;
+
+    while (pos < length) {
+        uint64_t chunk = 0;
+        uint64_t factor = 1;
+        for (size_t i = 0; i < chunk_length; i++) {
+            chunk = chunk * 10 + (uint64_t) (str[pos + i] - '0');
+            factor *= 10;
+        }
+
+        uint64_t carry = chunk;
+        for (size_t i = 0; i < x->count; i++) {
+            uint64_t product = (uint64_t) x->digits[i] * factor + carry;
+            x->digits[i] = (uint32_t) product;
+            carry = product >> 32;
+        }
+        if (carry) {
+            x->digits[x->count++] = (uint32_t) carry;
+        }
+
+        pos += chunk_length;
+        chunk_length = DECIMAL_DIGITS;
+    }
+
+    x->negative = negative;
+    return big_trim(x);
+}
+
+lbig* lbig_copy(lbig* x) {
+    ASSERT_NOT_NULL(x);
+
+    lbig* copy = big_new(x->count);
+    copy->negative = x->negative;
+    memcpy(copy->digits, x->digits, sizeof(uint32_t) * x->count);
+
+    return copy;
+}
+
+void lbig_del(lbig* x) {
+    xfree(x);
+}
+
+bool lbig_to_int(lbig* x, PRECISION_INT* result) {
+    if (x->count > 2) {
+        return false;
+    }
+
+    uint64_t magnitude = 0;
+    for (size_t i = x->count; i-- > 0;) {
+        magnitude = (magnitude << 32) | x->digits[i];
+    }
+
+    if (!x->negative && magnitude <= (uint64_t) PRECISION_INT_MAX) {
+        *result = (PRECISION_INT) magnitude;
+        return true;
+    } else if (x->negative && magnitude <= (uint64_t) PRECISION_INT_MAX + 1) {
+        *result = magnitude == (uint64_t) PRECISION_INT_MAX + 1
+                  ? PRECISION_INT_MIN : -(PRECISION_INT) magnitude;
+        return true;
+    }
+
+    return false;
+}
+
+PRECISION_FLOAT lbig_to_float(lbig* x) {
+    PRECISION_FLOAT value = 0;
+
+    for (size_t i = x->count; i-- > 0;) {
+        value = value * (PRECISION_FLOAT) DIGIT_BASE + x->digits[i];
+    }
+
+    return x->negative ? -value : value;
+}
+
+char* lbig_to_str(lbig* x) {
+    if (x->count == 0) {
+        return strdup("0");
+    }
+
+    // Split off nine decimal digits at a time, least significant first
+    size_t count = x->count;
+    uint32_t* rest = xmalloc(sizeof(uint32_t) * count);
+    memcpy(rest, x->digits, sizeof(uint32_t) * count);
+
+    uint32_t* chunks = xmalloc(sizeof(uint32_t) * (count * 2 + 1));
+    size_t chunk_count = 0;
+
+    while (count > 0) {
+        chunks[chunk_count++] = mag_div_digit(rest, count, DECIMAL_BASE);
+        count = mag_len(rest, count);
+    }
+
+    char* buffer = xmalloc(chunk_count * DECIMAL_DIGITS + 2);
+    char* pos = buffer;
+
+    if (x->negative) {
+        *pos++ = '-';
+    }
+
+    pos += sprintf(pos, "%u", (unsigned) chunks[chunk_count - 1]);
+    for (size_t i = chunk_count - 1; i-- > 0;) {
+        pos += sprintf(pos, "%09u", (unsigned) chunks[i]);
+    }
+
+    xfree(rest);
+    xfree(chunks);
+
+    return buffer;
+}
+
+int lbig_cmp(lbig* x, lbig* y) {
+    if (x->negative != y->negative) {
+        return x->negative ? -1 : 1;
+    }
+
+    int order = mag_cmp(x->digits, x->count, y->digits, y->count);
+    return x->negative ? -order : order;
+}
+
+/// Compute `x + y` or `x - y` from the magnitudes and signs.
+static lbig* big_add(lbig* x, lbig* y, bool subtract) {
+    bool y_negative = y->negative != subtract;
+    lbig* result;
+
+    if (x->negative == y_negative) {
+        result = big_new((x->count > y->count ? x->count : y->count) + 1);
+        mag_add(x->digits, x->count, y->digits, y->count, result->digits);
+        result->negative = x->negative;
+    } else if (mag_cmp(x->digits, x->count, y->digits, y->count) >= 0) {
+        result = big_new(x->count);
+        mag_sub(x->digits, x->count, y->digits, y->count, result->digits);
+        result->negative = x->negative;
+    } else {
+        result = big_new(y->count);
+        mag_sub(y->digits, y->count, x->digits, x->count, result->digits);
+        result->negative = y_negative;
+    }
+
+    return big_trim(result);
+}
+
+lbig* lbig_add(lbig* x, lbig* y) {
+    return big_add(x, y, false);
+}
+
+lbig* lbig_sub(lbig* x, lbig* y) {
+    return big_add(x, y, true);
+}
+
+lbig* lbig_mul(lbig* x, lbig* y) {
+    if (x->count == 0 || y->count == 0) {
+        return big_new(0);
+    }
+
+    lbig* result = big_new(x->count + y->count);
+    mag_mul(x->digits, x->count, y->digits, y->count, result->digits);
+    result->negative = x->negative != y->negative;
+
+    return big_trim(result);
+}
+
+lbig* lbig_divmod(lbig* x, lbig* y, lbig** remainder) {
+    ASSERTF(y->count > 0, "Division of a big integer by zero");
+
+    if (mag_cmp(x->digits, x->count, y->digits, y->count) < 0) {
+        *remainder = lbig_copy(x);
+        return big_new(0);
+    }
+
+    lbig* quotient = big_new(x->count - y->count + 1);
+    *remainder = big_new(y->count);
+    mag_divmod(x->digits, x->count, y->digits, y->count, quotient->digits, (*remainder)->digits);
+
+    quotient->negative = x->negative != y->negative;
+    (*remainder)->negative = x->negative;
+
+    big_trim(*remainder);
+    return big_trim(quotient);
+}
+
+lbig* lbig_neg(lbig* x) {
+    lbig* result = lbig_copy(x);
+    result->negative = x->count > 0 && !x->negative;
+
+    return result;
+}
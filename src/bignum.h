@@ -0,0 +1,149 @@
+/**
+ * \file    bignum.h
+ * \brief   Arbitrary-precision integers.
+ *
+ * Integers that don't fit #PRECISION_INT are stored as big integers: a sign
+ * and the digits of the magnitude in base 2^32, least significant first,
+ * without leading zeros. Big integers are never modified after they have
+ * been created, all operations return new ones.
+ *
+ * Multiplication switches from the schoolbook method to Karatsuba's method
+ * for operands of #BIGNUM_KARATSUBA_THRESHOLD digits and more. Division uses
+ * Knuth's algorithm D.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stdbool.h>
+    #include <stddef.h>
+    #include <stdint.h>
+#endif
+
+#include "config.h"
+
+
+/// An arbitrary-precision integer.
+typedef struct lbig {
+    bool negative;      ///< Whether the number is negative, never for zero.
+    size_t count;       ///< The number of digits, zero for zero.
+    uint32_t digits[];  ///< The digits in base 2^32, least significant first.
+} lbig;
+
+
+/**
+ * Create a big integer from an integer.
+ *
+ * \param value     The value.
+ * \returns The big integer. Has to be deleted with #lbig_del!
+ */
+lbig* lbig_from_int(PRECISION_INT value);
+
+/**
+ * Create a big integer from the integral part of a float.
+ *
+ * \param value     The value, it has to be finite.
+ * \returns The big integer. Has to be deleted with #lbig_del!
+ */
+lbig* lbig_from_float(PRECISION_FLOAT value);
+
+/**
+ * Create a big integer from its decimal representation.
+ *
+ * \param str       The digits, optionally preceded by a minus sign.
+ * \param length    The number of characters.
+ *
+ * \returns The big integer or `NULL` if the string isn't a decimal integer.
+ */
+lbig* lbig_from_str(char* str, size_t length);
+
+/**
+ * Copy a big integer.
+ *
+ * \param x The big integer to copy.
+ * \returns The copy.
+ */
+lbig* lbig_copy(lbig* x);
+
+/**
+ * Delete a big integer.
+ *
+ * \param x The big integer to delete.
+ */
+void lbig_del(lbig* x);
+
+/**
+ * Get the value of a big integer as #PRECISION_INT, if it fits.
+ *
+ * \param x             The big integer.
+ * \param result [out]  The value, only set if it fits.
+ *
+ * \returns Whether the value fits.
+ */
+bool lbig_to_int(lbig* x, PRECISION_INT* result);
+
+/**
+ * Get the (rounded) value of a big integer as float.
+ *
+ * \param x The big integer.
+ * \returns The value, infinite if it's too big.
+ */
+PRECISION_FLOAT lbig_to_float(lbig* x);
+
+/**
+ * Get the decimal representation of a big integer.
+ *
+ * \param x The big integer.
+ * \returns The digits, preceded by a minus sign if it's negative. Has to be
+ *          cleaned up!
+ */
+char* lbig_to_str(lbig* x);
+
+/**
+ * Compare two big integers.
+ *
+ * \returns A negative number, zero or a positive number if `x` is less than,
+ *          equal to or greater than `y`.
+ */
+int lbig_cmp(lbig* x, lbig* y);
+
+/**
+ * Add two big integers.
+ *
+ * \returns The sum, a new big integer.
+ */
+lbig* lbig_add(lbig* x, lbig* y);
+
+/**
+ * Subtract two big integers.
+ *
+ * \returns The difference, a new big integer.
+ */
+lbig* lbig_sub(lbig* x, lbig* y);
+
+/**
+ * Multiply two big integers.
+ *
+ * \returns The product, a new big integer.
+ */
+lbig* lbig_mul(lbig* x, lbig* y);
+
+/**
+ * Divide two big integers.
+ *
+ * Like the division of C integers, the quotient is rounded towards zero and
+ * the remainder has the sign of `x`.
+ *
+ * \param x                 The dividend.
+ * \param y                 The divisor, must not be zero.
+ * \param remainder [out]   The remainder, a new big integer.
+ *
+ * \returns The quotient, a new big integer.
+ */
+lbig* lbig_divmod(lbig* x, lbig* y, lbig** remainder);
+
+/**
+ * Negate a big integer.
+ *
+ * \returns The negated value, a new big integer.
+ */
+lbig* lbig_neg(lbig* x);
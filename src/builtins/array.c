@@ -0,0 +1,100 @@
+#include <lval.h>
+#include <array.h>
+#include "builtin.h"
+
+lval* builtin_array(lenv* env, lval* node) {
+    UNUSED(env);
+
+    // The items are either the arguments or the items of a single list
+    lval* items = node;
+    if (node->count == 1 && node->values[0]->type == LVAL_QEXPR) {
+        items = node->values[0];
+    }
+
+    larray* array = larray_new();
+    for_item(items, {
+        larray_push(array, lval_ref(item));
+    });
+
+    lval_del(node);
+    return lval_array(array);
+}
+
+lval* builtin_array_set(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("array-set", node, 3);
+    LASSERT_ARG_TYPE("array-set", node, 0, LVAL_ARRAY);
+    LASSERT_ARG_TYPE("array-set", node, 1, LVAL_INT);
+
+    PRECISION_INT index = node->values[1]->integer;
+    size_t count = node->values[0]->array->count;
+
+    LASSERT(node, index >= 0 && (uint64_t) index < count,
+            "Function 'array-set' passed index %lld out of range, the array has %zu items.",
+            (long long) index, count);
+
+    lval* array = lval_pop(node, 0);
+    lval* value = lval_pop(node, 1);
+    lval_del(node);
+
+    // A shared array only copies the nodes on the path to the item
+    array = lval_unshare(array);
+    larray_set(array->array, (size_t) index, value);
+
+    return array;
+}
+
+lval* builtin_array_push(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("array-push", node, 2);
+    LASSERT_ARG_TYPE("array-push", node, 0, LVAL_ARRAY);
+
+    lval* array = lval_unshare(lval_pop(node, 0));
+    larray_push(array->array, lval_take(node, 0));
+
+    return array;
+}
+
+lval* builtin_array_slice(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("array-slice", node, 3);
+    LASSERT_ARG_TYPE("array-slice", node, 0, LVAL_ARRAY);
+    LASSERT_ARG_TYPE("array-slice", node, 1, LVAL_INT);
+    LASSERT_ARG_TYPE("array-slice", node, 2, LVAL_INT);
+
+    size_t count = node->values[0]->array->count;
+    PRECISION_INT start = node->values[1]->integer;
+    PRECISION_INT end   = node->values[2]->integer;
+
+    LASSERT(node, start >= 0 && start <= end && (uint64_t) end <= count,
+            "Function 'array-slice' passed range [%lld, %lld) out of range, the array has %zu items.",
+            (long long) start, (long long) end, count);
+
+    lval* array = lval_unshare(lval_take(node, 0));
+    larray_slice(array->array, (size_t) start, (size_t) end);
+
+    return array;
+}
+
+lval* builtin_array_list(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("array-list", node, 1);
+    LASSERT_ARG_TYPE("array-list", node, 0, LVAL_ARRAY);
+
+    larray* array = node->values[0]->array;
+    lval** values = xmalloc(LVAL_PTR_SIZE * (array->count + 1));
+    for (size_t i = 0; i < array->count; i++) {
+        values[i] = lval_ref(larray_get(array, i));
+    }
+
+    lval* list = lval_sexpr_from(values, array->count);
+    list->type = LVAL_QEXPR;
+    xfree(values);
+
+    lval_del(node);
+    return list;
+}
@@ -3,6 +3,7 @@
 
 void builtins_init(lenv* env) {
     builtin_create(env, builtin_eval,    "eval");
+    builtin_create(env, builtin_quote,   "quote");
     builtin_create(env, builtin_load,    "load");
     builtin_create(env, builtin_print,   "print");
     builtin_create(env, builtin_println, "println");
@@ -15,6 +16,16 @@ void builtins_init(lenv* env) {
     builtin_create(env, builtin_tail, "tail");
     builtin_create(env, builtin_join, "join");
     builtin_create(env, builtin_cons, "cons");
+    builtin_create(env, builtin_len, "len");
+    builtin_create(env, builtin_nth, "nth");
+    builtin_create(env, builtin_last, "last");
+    builtin_create(env, builtin_reverse, "reverse");
+    builtin_create(env, builtin_take, "take");
+    builtin_create(env, builtin_drop, "drop");
+    builtin_create(env, builtin_elem, "elem?");
+    builtin_create(env, builtin_map, "map");
+    builtin_create(env, builtin_filter, "filter");
+    builtin_create(env, builtin_foldl, "foldl");
 
     // Math functions
     builtin_create(env, builtin_add, "+");
@@ -35,6 +46,60 @@ void builtins_init(lenv* env) {
     builtin_create(env, builtin_not, "not");
     builtin_create(env, builtin_if, "if");
 
+    // Vectors
+    builtin_create(env, builtin_vec,       "vec");
+    builtin_create(env, builtin_vec_list,  "vec-list");
+    builtin_create(env, builtin_vec_len,   "vec-len");
+    builtin_create(env, builtin_vec_get,   "vec-get");
+    builtin_create(env, builtin_vec_slice, "vec-slice");
+    builtin_create(env, builtin_vec_add,   "v+");
+    builtin_create(env, builtin_vec_sub,   "v-");
+    builtin_create(env, builtin_vec_mul,   "v*");
+    builtin_create(env, builtin_vec_div,   "v/");
+    builtin_create(env, builtin_vec_mod,   "v%");
+    builtin_create(env, builtin_vec_gt,    "v>");
+    builtin_create(env, builtin_vec_ge,    "v>=");
+    builtin_create(env, builtin_vec_lt,    "v<");
+    builtin_create(env, builtin_vec_le,    "v<=");
+    builtin_create(env, builtin_vec_eq,    "v==");
+    builtin_create(env, builtin_vec_ne,    "v!=");
+    builtin_create(env, builtin_vec_sum,   "vec-sum");
+    builtin_create(env, builtin_vec_dot,   "vec-dot");
+    builtin_create(env, builtin_vec_min,   "vec-min");
+    builtin_create(env, builtin_vec_max,   "vec-max");
+
+    // Strings
+    builtin_create(env, builtin_concat,     "concat");
+    builtin_create(env, builtin_substr,     "substr");
+    builtin_create(env, builtin_split,      "split");
+    builtin_create(env, builtin_find,       "find");
+    builtin_create(env, builtin_str_len,    "str-len");
+    builtin_create(env, builtin_str_to_num, "str->num");
+
+    // Sequences
+    builtin_create(env, builtin_range,       "range");
+    builtin_create(env, builtin_lines,       "lines");
+    builtin_create(env, builtin_lazy_map,    "lazy-map");
+    builtin_create(env, builtin_lazy_filter, "lazy-filter");
+    builtin_create(env, builtin_take_while,  "take-while");
+    builtin_create(env, builtin_realize,     "realize");
+
+    // Hash maps and sets
+    builtin_create(env, builtin_dict,      "dict");
+    builtin_create(env, builtin_dict_get,  "dict-get");
+    builtin_create(env, builtin_dict_put,  "dict-put");
+    builtin_create(env, builtin_dict_keys, "dict-keys");
+    builtin_create(env, builtin_set,       "set");
+    builtin_create(env, builtin_set_add,   "set-add");
+    builtin_create(env, builtin_set_has,   "set-has?");
+
+    // Arrays
+    builtin_create(env, builtin_array,       "array");
+    builtin_create(env, builtin_array_set,   "array-set");
+    builtin_create(env, builtin_array_push,  "array-push");
+    builtin_create(env, builtin_array_slice, "array-slice");
+    builtin_create(env, builtin_array_list,  "array-list");
+
     // Functions and scopes
     builtin_create(env, builtin_lambda, "lambda");
     builtin_create(env, builtin_def, "def");
@@ -43,6 +108,10 @@ void builtins_init(lenv* env) {
 #if defined DEBUG
      builtin_create(env, builtin_debug_stats, "debug_stats");
 #endif
+
+#if defined MLISP_GC
+    builtin_create(env, builtin_gc_stats, "gc_stats");
+#endif
 }
 
 void builtin_create(lenv* env, lbuiltin func, char* name) {
@@ -73,6 +73,22 @@
             "Function '%s' passed incorrect argument types. Expected %s, got %s.", \
             name, lval_str_type(etype), lval_str_type(node->values[i]->type));
 
+/**
+ * Assert that the `i`-th argument is a number (an integer or a float).
+ */
+#define LASSERT_ARG_NUMBER(name, node, i) \
+    LASSERT(node, lval_is_number(node->values[i]), \
+            "Function '%s' passed incorrect argument types. Expected number, got %s.", \
+            name, lval_str_type(node->values[i]->type));
+
+/**
+ * Get the value of a number as float, like #lval_to_float but without a call
+ * for floats and plain integers.
+ */
+#define FLOAT_VALUE(node) \
+    ((node)->type == LVAL_NUM ? (node)->num \
+     : (node)->type == LVAL_INT ? (PRECISION_FLOAT) (node)->integer : lval_to_float(node))
+
 /**
  * Assert that the `i`-th argument is not an empty list.
  */
@@ -168,6 +184,40 @@ lval* builtin_error(lenv* env, lval* node);
  */
 lval* builtin_eval(lenv* env, lval* node);
 
+/**
+ * Get the expression evaluated by `eval`.
+ *
+ * Check the arguments like #builtin_eval, but don't evaluate the expression.
+ * Used to evaluate `eval` in tail position (see #eval_call).
+ *
+ * \param node  The list to evaluate.
+ *
+ * \returns The list as S-Expression or an error.
+ */
+lval* builtin_eval_expr(lval* node);
+
+/**
+ * Return the argument.
+ *
+ * Called as `(quote expr)`, the expression isn't evaluated (see #eval_sexpr),
+ * so `quote` returns it as written: `(quote (+ 1 x))` is `{+ 1 x}`.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The expression.
+ *
+ * \returns The expression, a S-Expression as Q-Expression.
+ */
+lval* builtin_quote(lenv* env, lval* node);
+
+/**
+ * Get the value of a quoted expression (see #builtin_quote).
+ *
+ * \param expr  The expression (consumed).
+ *
+ * \returns The expression, a S-Expression as Q-Expression.
+ */
+lval* builtin_quote_expr(lval* expr);
+
 
 /**
  * Add two numbers.
@@ -304,24 +354,507 @@ lval* builtin_not(lenv* env, lval* node);
  */
 lval* builtin_if(lenv* env, lval* node);
 
+/**
+ * Select the branch evaluated by `if`.
+ *
+ * Check the arguments like #builtin_if, but don't evaluate the branch. Used to
+ * evaluate `if` in tail position (see #eval_call).
+ *
+ * \param node  The condition and the branches.
+ *
+ * \returns The selected branch as S-Expression (empty if there's no else
+ *          branch) or an error.
+ */
+lval* builtin_if_branch(lval* node);
+
 
 /**
- * SHORT_DESCR
+ * Create a vector of numbers.
+ *
+ * The vector holds integers if all numbers are integers fitting
+ * #PRECISION_INT, floats otherwise.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The numbers or a single Q-Expression of numbers.
+ *
+ * \returns The vector.
+ */
+lval* builtin_vec(lenv* env, lval* node);
+
+/**
+ * Get the items of a vector as list.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The vector.
+ *
+ * \returns A Q-Expression of the items.
+ */
+lval* builtin_vec_list(lenv* env, lval* node);
+
+/**
+ * Get the number of items of a vector.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The vector.
+ *
+ * \returns The number of items.
+ */
+lval* builtin_vec_len(lenv* env, lval* node);
+
+/**
+ * Get an item of a vector.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The vector and the (zero-based) index.
+ *
+ * \returns The item.
+ */
+lval* builtin_vec_get(lenv* env, lval* node);
+
+/**
+ * Get a range of the items of a vector.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The vector, the index of the first item and the index after
+ *              the last item.
+ *
+ * \returns A vector of the items.
+ */
+lval* builtin_vec_slice(lenv* env, lval* node);
+
+/**
+ * Add the items of two vectors, or a number to each item of a vector.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  Two vectors of the same length, or a vector and a number.
+ *
+ * \returns A vector of the sums.
+ */
+lval* builtin_vec_add(lenv* env, lval* node);
+
+/**
+ * Subtract the items of two vectors, see #builtin_vec_add.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  Two vectors of the same length, or a vector and a number.
+ *
+ * \returns A vector of the differences.
+ */
+lval* builtin_vec_sub(lenv* env, lval* node);
+
+/**
+ * Multiply the items of two vectors, see #builtin_vec_add.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  Two vectors of the same length, or a vector and a number.
+ *
+ * \returns A vector of the products.
+ */
+lval* builtin_vec_mul(lenv* env, lval* node);
+
+/**
+ * Divide the items of two vectors, see #builtin_vec_add.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  Two vectors of the same length, or a vector and a number.
+ *
+ * \returns A vector of the quotients.
+ */
+lval* builtin_vec_div(lenv* env, lval* node);
+
+/**
+ * Calculate the modulo of the items of two vectors, see #builtin_vec_add.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  Two vectors of the same length, or a vector and a number.
+ *
+ * \returns A vector of the remainders.
+ */
+lval* builtin_vec_mod(lenv* env, lval* node);
+
+/**
+ * a > b for each pair of items of two vectors, see #builtin_vec_add.
  *
  * \param env   The environment where to run this function.
  * \param node  The arguments.
  *
- * \returns RETURN_VALUE
+ * \returns An integer vector, 1 where the comparison is true, 0 otherwise.
  */
-lval* builtin_head(lenv* env, lval* node);
+lval* builtin_vec_gt(lenv* env, lval* node);
 
 /**
- * SHORT_DESCR
+ * a >= b for each pair of items, see #builtin_vec_gt.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The arguments.
+ */
+lval* builtin_vec_ge(lenv* env, lval* node);
+
+/**
+ * a < b for each pair of items, see #builtin_vec_gt.
  *
  * \param env   The environment where to run this function.
  * \param node  The arguments.
+ */
+lval* builtin_vec_lt(lenv* env, lval* node);
+
+/**
+ * a <= b for each pair of items, see #builtin_vec_gt.
  *
- * \returns RETURN_VALUE
+ * \param env   The environment where to run this function.
+ * \param node  The arguments.
+ */
+lval* builtin_vec_le(lenv* env, lval* node);
+
+/**
+ * a == b for each pair of items, see #builtin_vec_gt. Unlike `==`, floats are
+ * compared exactly.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The arguments.
+ */
+lval* builtin_vec_eq(lenv* env, lval* node);
+
+/**
+ * a != b for each pair of items, see #builtin_vec_eq.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The arguments.
+ */
+lval* builtin_vec_ne(lenv* env, lval* node);
+
+/**
+ * Add up the items of a vector.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The vector.
+ *
+ * \returns The sum, exact for integer vectors.
+ */
+lval* builtin_vec_sum(lenv* env, lval* node);
+
+/**
+ * Compute the dot product of two vectors.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  Two vectors of the same length.
+ *
+ * \returns The sum of the products of their items, exact for integer vectors.
+ */
+lval* builtin_vec_dot(lenv* env, lval* node);
+
+/**
+ * Get the smallest item of a vector.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The vector, not empty.
+ *
+ * \returns The item.
+ */
+lval* builtin_vec_min(lenv* env, lval* node);
+
+/**
+ * Get the biggest item of a vector.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The vector, not empty.
+ *
+ * \returns The item.
+ */
+lval* builtin_vec_max(lenv* env, lval* node);
+
+
+/**
+ * Join strings.
+ *
+ * Extending a string repeatedly (like `(= {s} (concat s x))`) takes amortized
+ * linear time in total, see #lval_str_concat.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The strings.
+ *
+ * \returns A string of the characters of all strings.
+ */
+lval* builtin_concat(lenv* env, lval* node);
+
+/**
+ * Get a range of the characters of a string.
+ *
+ * Indices count bytes, not (UTF-8) characters.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The string, the index of the first character and optionally
+ *              the index after the last one (default: the end).
+ *
+ * \returns The substring, sharing the characters of the string.
+ */
+lval* builtin_substr(lenv* env, lval* node);
+
+/**
+ * Split a string at each occurrence of a separator.
+ *
+ * Given an index and a list instead, splits the list (see
+ * #builtin_split_list).
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The string and the separator, not empty.
+ *
+ * \returns A Q-Expression of the parts, one more than there are separators.
+ */
+lval* builtin_split(lenv* env, lval* node);
+
+/**
+ * Find the first occurrence of a string in another one.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The string, the string to find and optionally the index
+ *              where to start searching.
+ *
+ * \returns The index of the occurrence or -1 if there's none.
+ */
+lval* builtin_find(lenv* env, lval* node);
+
+/**
+ * Get the length of a string.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The string.
+ *
+ * \returns The number of bytes.
+ */
+lval* builtin_str_len(lenv* env, lval* node);
+
+/**
+ * Read a number from a string.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The string, a number like in source text, optionally preceded
+ *              by a minus sign.
+ *
+ * \returns The number.
+ */
+lval* builtin_str_to_num(lenv* env, lval* node);
+
+
+/**
+ * Create a lazy range of integers.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The end, the start and the end, or the start, the end and a
+ *              step other than 0 (default: 0 and 1).
+ *
+ * \returns The sequence of the integers from the start up to (or, with a
+ *          negative step, down to) the end, excluding it.
+ */
+lval* builtin_range(lenv* env, lval* node);
+
+/**
+ * Create a lazy sequence of the lines of a file.
+ *
+ * The file is read when the sequence is consumed, a line at a time.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The name of the file.
+ *
+ * \returns The sequence of the lines, without their line breaks.
+ */
+lval* builtin_lines(lenv* env, lval* node);
+
+/**
+ * Lazily apply a function to each item of a sequence.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The function and the sequence or a list.
+ *
+ * \returns The sequence of the results.
+ */
+lval* builtin_lazy_map(lenv* env, lval* node);
+
+/**
+ * Lazily select the items of a sequence a function returns true for.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The function, returning a number, and the sequence or a list.
+ *
+ * \returns The sequence of the selected items.
+ */
+lval* builtin_lazy_filter(lenv* env, lval* node);
+
+/**
+ * Lazily take the items of a sequence until a function returns false.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The function, returning a number, and the sequence or a list.
+ *
+ * \returns The sequence of the items before the first one rejected.
+ */
+lval* builtin_take_while(lenv* env, lval* node);
+
+/**
+ * Consume a sequence.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The sequence, or a list which is returned as is.
+ *
+ * \returns A Q-Expression of the items, or the first error.
+ */
+lval* builtin_realize(lenv* env, lval* node);
+
+
+/**
+ * Create a hash map.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  Keys, each followed by its value, or a single Q-Expression of
+ *              them. Later entries replace earlier ones with an equal key.
+ *
+ * \returns The hash map.
+ */
+lval* builtin_dict(lenv* env, lval* node);
+
+/**
+ * Look up the value of a key in a hash map.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The hash map, the key and optionally the value to return if
+ *              the key isn't found.
+ *
+ * \returns The value, or an error if the key isn't found and there's no
+ *          default.
+ */
+lval* builtin_dict_get(lenv* env, lval* node);
+
+/**
+ * Add an entry to a hash map or replace the value of a key.
+ *
+ * Takes logarithmic time, the result shares all other entries with the
+ * hash map.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The hash map, the key and the value.
+ *
+ * \returns The updated hash map.
+ */
+lval* builtin_dict_put(lenv* env, lval* node);
+
+/**
+ * Get the keys of a hash map or the items of a set.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The hash map or set.
+ *
+ * \returns A Q-Expression of the keys, in no particular order.
+ */
+lval* builtin_dict_keys(lenv* env, lval* node);
+
+/**
+ * Create a hash set.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The items, or a single Q-Expression of them. Duplicates are
+ *              only kept once.
+ *
+ * \returns The set.
+ */
+lval* builtin_set(lenv* env, lval* node);
+
+/**
+ * Add an item to a set.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The set and the item.
+ *
+ * \returns The updated set, sharing all other items with the set.
+ */
+lval* builtin_set_add(lenv* env, lval* node);
+
+/**
+ * Check whether a set has an item, or a hash map a key.
+ *
+ * Takes constant time on average.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The set or hash map and the item.
+ *
+ * \returns 1 if it has the item, 0 otherwise.
+ */
+lval* builtin_set_has(lenv* env, lval* node);
+
+
+/**
+ * Create an array.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The items, or a single Q-Expression of them.
+ *
+ * \returns The array.
+ */
+lval* builtin_array(lenv* env, lval* node);
+
+/**
+ * Replace an item of an array.
+ *
+ * Takes logarithmic time, the result shares all other items with the array.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The array, the (zero-based) index and the new item.
+ *
+ * \returns The updated array.
+ */
+lval* builtin_array_set(lenv* env, lval* node);
+
+/**
+ * Add an item after the last one of an array.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The array and the item.
+ *
+ * \returns The longer array, sharing the items of the array.
+ */
+lval* builtin_array_push(lenv* env, lval* node);
+
+/**
+ * Get a range of the items of an array.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The array, the index of the first item and the index after
+ *              the last one.
+ *
+ * \returns An array sharing the items.
+ */
+lval* builtin_array_slice(lenv* env, lval* node);
+
+/**
+ * Get the items of an array as a list.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The array.
+ *
+ * \returns A Q-Expression of the items.
+ */
+lval* builtin_array_list(lenv* env, lval* node);
+
+
+/**
+ * Get the first item of a list or an array.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The list or array, not empty.
+ *
+ * \returns A list or array of the first item.
+ */
+lval* builtin_head(lenv* env, lval* node);
+
+/**
+ * Get all items of a list or an array but the first one.
+ *
+ * Takes constant time on lists and logarithmic time on arrays, the result
+ * shares the items.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The list or array, not empty.
+ *
+ * \returns A list or array of the other items.
  */
 lval* builtin_tail(lenv* env, lval* node);
 
@@ -336,25 +869,148 @@ lval* builtin_tail(lenv* env, lval* node);
 lval* builtin_list(lenv* env, lval* node);
 
 /**
- * SHORT_DESCR
+ * Join lists or arrays.
+ *
+ * Arrays are joined by adding the items of the shorter array to the longer
+ * one.
  *
  * \param env   The environment where to run this function.
- * \param node  The arguments.
+ * \param node  The lists, or the arrays.
  *
- * \returns RETURN_VALUE
+ * \returns A list or array of the items of all arguments.
  */
 lval* builtin_join(lenv* env, lval* node);
 
 /**
- * SHORT_DESCR
+ * Add a value in front of a list or an array.
  *
  * \param env   The environment where to run this function.
- * \param node  The arguments.
+ * \param node  The value and the list or array.
  *
- * \returns RETURN_VALUE
+ * \returns The list or array starting with the value.
  */
 lval* builtin_cons(lenv* env, lval* node);
 
+/**
+ * Split a list at an index.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The index and the list, not shorter than the index.
+ *
+ * \returns A Q-Expression of the items before the index and the items
+ *          from the index on.
+ */
+lval* builtin_split_list(lenv* env, lval* node);
+
+/**
+ * Get the first items of a list.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The number of items and the list, not shorter than that.
+ *
+ * \returns A Q-Expression of the items.
+ */
+lval* builtin_take(lenv* env, lval* node);
+
+/**
+ * Drop the first items of a list.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The number of items and the list, not shorter than that.
+ *
+ * \returns A Q-Expression of the remaining items, sharing the list's
+ *          storage.
+ */
+lval* builtin_drop(lenv* env, lval* node);
+
+/**
+ * Get the number of items of a list or an array, or of the entries of a hash
+ * map or set.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The list, array, hash map or set.
+ *
+ * \returns The number of items.
+ */
+lval* builtin_len(lenv* env, lval* node);
+
+/**
+ * Evaluate an item of a list, like `1st`, or get an item of an array.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The (zero-based) index and the list or array.
+ *
+ * \returns The value of the item.
+ */
+lval* builtin_nth(lenv* env, lval* node);
+
+/**
+ * Evaluate the last item of a list, or get the last item of an array.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The list or array, not empty.
+ *
+ * \returns The value of the item.
+ */
+lval* builtin_last(lenv* env, lval* node);
+
+/**
+ * Reverse the items of a list.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The list.
+ *
+ * \returns A Q-Expression of the items in reverse order.
+ */
+lval* builtin_reverse(lenv* env, lval* node);
+
+/**
+ * Check whether a value equals the value of an item of a list.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The value and the list.
+ *
+ * \returns 1 if an item is equal, 0 otherwise.
+ */
+lval* builtin_elem(lenv* env, lval* node);
+
+/**
+ * Apply a function to the value of each item of a list.
+ *
+ * The function is called directly, without building and evaluating a
+ * S-Expression for each item.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The function and the list.
+ *
+ * \returns A Q-Expression of the results, or the first error.
+ */
+lval* builtin_map(lenv* env, lval* node);
+
+/**
+ * Select the items of a list for whose value a function returns true.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The function, returning a number, and the list.
+ *
+ * \returns A Q-Expression of the selected items, or the first error.
+ */
+lval* builtin_filter(lenv* env, lval* node);
+
+/**
+ * Combine the values of the items of a list from left to right.
+ *
+ * A sequence is consumed item by item, without building a list.
+ *
+ * \param env   The environment where to run this function.
+ * \param node  The function taking the result so far and a value, the
+ *              initial value and the list or the sequence.
+ *
+ * \returns The last result, the initial value for an empty list, or the
+ *          first error.
+ */
+lval* builtin_foldl(lenv* env, lval* node);
+
 
 /**
  * SHORT_DESCR
@@ -398,3 +1054,18 @@ lval* builtin_lambda(lenv* env, lval* node);
      */
     lval* builtin_debug_stats(lenv* env, lval* node);
 #endif
+
+#if defined MLISP_GC
+    /**
+     * Get the statistics of the garbage collector.
+     *
+     * \param env   The environment where to run this function.
+     * \param node  No arguments.
+     *
+     * \returns A Q-Expression with the number of collections, the total and
+     *          longest pause in ms, the live bytes after the last collection,
+     *          the current heap size and the size triggering the next
+     *          collection.
+     */
+    lval* builtin_gc_stats(lenv* env, lval* node);
+#endif
@@ -2,43 +2,84 @@
 #include "builtin.h"
 
 
-lval* builtin_ord(lenv* env, lval* node, char* op) {
+/// The orders of two numbers, comparisons accept a combination of them.
+typedef enum num_order {
+    ORDER_LT = 1,   ///< The first number is less than the second.
+    ORDER_EQ = 2,   ///< The numbers are equal.
+    ORDER_GT = 4    ///< The first number is greater than the second.
+} num_order;
+
+/// Get the order of two values, 0 if they are unordered (not a number).
+#define ORDER(x, y) (((x) < (y)) | FLOAT_EQ(x, y) << 1 | ((x) > (y)) << 2)
+
+/**
+ * Compare two numbers.
+ *
+ * Integers (big ones, too) are compared exactly, floats are compared with
+ * integers exactly, too (see #lval_num_cmp).
+ *
+ * \param a     The first number.
+ * \param b     The second number.
+ *
+ * \returns The #num_order of the numbers, 0 if one of them is not a number.
+ */
+static inline int num_ord(lval* a, lval* b) {
+    if (a->type == LVAL_INT && b->type == LVAL_INT) {
+        return ORDER(a->integer, b->integer);
+    }
+
+    if (a->type == LVAL_NUM && b->type == LVAL_NUM) {
+        return ORDER(a->num, b->num);
+    }
+
+    int order = lval_num_cmp(a, b);
+    return order == LVAL_UNORDERED ? 0 : ORDER(order, 0);
+}
+
+/**
+ * Check whether numbers are ordered.
+ *
+ * \param env       The environment.
+ * \param node      The numbers.
+ * \param op        The name of the comparison.
+ * \param orders    The #num_order of all neighbours accepted by the
+ *                  comparison.
+ *
+ * \returns 1 if the numbers are ordered, 0 otherwise.
+ */
+lval* builtin_ord(lenv* env, lval* node, char* op, int orders) {
     UNUSED(env);
 
     // Check argument count
     LASSERT_MIN_ARG_COUNT(op, node, 2);
 
-    // Ensure all arguments are numbers
+    // Ensure all arguments are numbers, once for all comparisons
+    bool integers = true;
     for_item(node, {
-        LASSERT_ARG_TYPE(op, node, i, LVAL_NUM);
+        LASSERT_ARG_NUMBER(op, node, i);
+        integers &= item->type == LVAL_INT;
     });
 
-    lval* x = lval_pop(node, 0);
-    PRECISION_INT result = 1;
-
-    while (node->count > 0) {
-        lval* y = lval_pop(node, 0);
+    bool result = true;
 
-        if      (strncmp(op, ">",  2) == 0) { result &= (x->num >  y->num); }
-        else if (strncmp(op, ">=", 2) == 0) { result &= (x->num >= y->num); }
-        else if (strncmp(op, "<",  2) == 0) { result &= (x->num <  y->num); }
-        else if (strncmp(op, "<=", 2) == 0) { result &= (x->num <= y->num); }
-
-        x->num = y->num;
-
-        lval_del(y);
+    if (integers) {
+        for (size_t i = 1; result && i < node->count; i++) {
+            result = orders & ORDER(node->values[i - 1]->integer, node->values[i]->integer);
+        }
+    } else {
+        for (size_t i = 1; result && i < node->count; i++) {
+            result = orders & num_ord(node->values[i - 1], node->values[i]);
+        }
     }
 
     lval_del(node);
-
-    x->num = result;
-    return x;
+    return lval_int(result);
 }
 
-lval* builtin_gt(lenv* env, lval* node) { return builtin_ord(env, node, ">");  }
-lval* builtin_ge(lenv* env, lval* node) { return builtin_ord(env, node, ">="); }
-lval* builtin_lt(lenv* env, lval* node) { return builtin_ord(env, node, "<");  }
-lval* builtin_le(lenv* env, lval* node) { return builtin_ord(env, node, "<="); }
+lval* builtin_gt(lenv* env, lval* node) { return builtin_ord(env, node, ">",  ORDER_GT); }
+lval* builtin_ge(lenv* env, lval* node) { return builtin_ord(env, node, ">=", ORDER_GT | ORDER_EQ); }
+lval* builtin_lt(lenv* env, lval* node) { return builtin_ord(env, node, "<",  ORDER_LT); }
+lval* builtin_le(lenv* env, lval* node) { return builtin_ord(env, node, "<=", ORDER_LT | ORDER_EQ); }
 
 lval* builtin_cmp(lenv* env, lval* node, char* op) {
     UNUSED(env);
@@ -55,7 +96,7 @@ lval* builtin_cmp(lenv* env, lval* node, char* op) {
     else                            { ASSERTF(0, "Invalid op in builtin_cmp: %s", op); }
 
     lval_del(node);
-    return lval_num(result);
+    return lval_int(result);
 }
 
 lval* builtin_eq(lenv* env, lval* node) { return builtin_cmp(env, node, "=="); }
@@ -65,46 +106,48 @@ lval* builtin_and(lenv* env, lval* node) {
     UNUSED(env);
 
     LASSERT_ARG_COUNT("and", node, 2);
-    LASSERT_ARG_TYPE("and", node, 0, LVAL_NUM);
-    LASSERT_ARG_TYPE("and", node, 1, LVAL_NUM);
+    LASSERT_ARG_NUMBER("and", node, 0);
+    LASSERT_ARG_NUMBER("and", node, 1);
 
-    PRECISION_INT result = node->values[0]->num && node->values[1]->num;
+    PRECISION_INT result = !lval_is_zero(node->values[0]) && !lval_is_zero(node->values[1]);
     lval_del(node);
 
-    return lval_num(result);
+    return lval_int(result);
 }
 
 lval* builtin_or(lenv* env, lval* node) {
     UNUSED(env);
 
     LASSERT_ARG_COUNT("or", node, 2);
-    LASSERT_ARG_TYPE("or", node, 0, LVAL_NUM);
-    LASSERT_ARG_TYPE("or", node, 1, LVAL_NUM);
+    LASSERT_ARG_NUMBER("or", node, 0);
+    LASSERT_ARG_NUMBER("or", node, 1);
 
-    PRECISION_INT result = node->values[0]->num || node->values[1]->num;
+    PRECISION_INT result = !lval_is_zero(node->values[0]) || !lval_is_zero(node->values[1]);
     lval_del(node);
 
-    return lval_num(result);
+    return lval_int(result);
 }
 
 lval* builtin_not(lenv* env, lval* node) {
     UNUSED(env);
 
     LASSERT_ARG_COUNT("not", node, 1);
-    LASSERT_ARG_TYPE("not", node, 0, LVAL_NUM);
+    LASSERT_ARG_NUMBER("not", node, 0);
 
-    PRECISION_INT result = !node->values[0]->num;
+    PRECISION_INT result = lval_is_zero(node->values[0]);
     lval_del(node);
 
-    return lval_num(result);
+    return lval_int(result);
 }
 
 lval* builtin_if(lenv* env, lval* node) {
-    UNUSED(env);
+    return eval(env, builtin_if_branch(node));
+}
 
+lval* builtin_if_branch(lval* node) {
     LASSERT_MIN_ARG_COUNT("if", node, 2);
     LASSERT_MAX_ARG_COUNT("if", node, 3);
-    LASSERT_ARG_TYPE("if", node, 0, LVAL_NUM);
+    LASSERT_ARG_NUMBER("if", node, 0);
     LASSERT_ARG_TYPE("if", node, 1, LVAL_QEXPR);
 
     if (node->count == 3) {
@@ -114,7 +157,7 @@ lval* builtin_if(lenv* env, lval* node) {
     lval* branch;
 
     // Check condition and choose branch
-    if (node->values[0]->num) {
+    if (!lval_is_zero(node->values[0])) {
         branch = lval_pop(node, 1);
     } else if (node->count == 3) {
         branch = lval_pop(node, 2);
@@ -125,6 +168,7 @@ lval* builtin_if(lenv* env, lval* node) {
 
     lval_del(node);
 
+    branch = lval_unshare(branch);
     branch->type = LVAL_SEXPR;
-    return eval(env, branch);
+    return branch;
 }
@@ -0,0 +1,137 @@
+#include <lval.h>
+#include <dict.h>
+#include "builtin.h"
+
+/**
+ * Assert that the `i`-th argument is a hash map or a set.
+ */
+#define LASSERT_ARG_DICT_OR_SET(name, node, i) \
+    LASSERT(node, node->values[i]->type == LVAL_DICT || node->values[i]->type == LVAL_SET, \
+            "Function '%s' passed incorrect argument types. Expected %s or %s, got %s.", \
+            name, lval_str_type(LVAL_DICT), lval_str_type(LVAL_SET), \
+            lval_str_type(node->values[i]->type));
+
+lval* builtin_dict(lenv* env, lval* node) {
+    UNUSED(env);
+
+    // The keys and values are either the arguments or the items of a single
+    // list, like the items of a set
+    lval* items = node;
+    if (node->count == 1 && node->values[0]->type == LVAL_QEXPR) {
+        items = node->values[0];
+    }
+
+    LASSERT(node, items->count % 2 == 0,
+            "Function 'dict' passed a key without a value.");
+
+    ldict* dict = ldict_new();
+    for (size_t i = 0; i < items->count; i += 2) {
+        ldict_put(dict, lval_ref(items->values[i]), lval_ref(items->values[i + 1]));
+    }
+
+    lval_del(node);
+    return lval_dict(dict, false);
+}
+
+lval* builtin_dict_get(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_MIN_ARG_COUNT("dict-get", node, 2);
+    LASSERT_MAX_ARG_COUNT("dict-get", node, 3);
+    LASSERT_ARG_TYPE("dict-get", node, 0, LVAL_DICT);
+
+    lval* value;
+    bool found = ldict_find(node->values[0]->dict, node->values[1], &value);
+
+    LASSERT(node, found || node->count == 3,
+            "Function 'dict-get' passed a key that isn't in the dictionary.");
+
+    value = lval_ref(found ? value : node->values[2]);
+    lval_del(node);
+
+    return value;
+}
+
+lval* builtin_dict_put(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("dict-put", node, 3);
+    LASSERT_ARG_TYPE("dict-put", node, 0, LVAL_DICT);
+
+    lval* dict  = lval_pop(node, 0);
+    lval* key   = lval_pop(node, 0);
+    lval* value = lval_pop(node, 0);
+    lval_del(node);
+
+    // A shared dictionary only copies the nodes on the path to the key
+    dict = lval_unshare(dict);
+    ldict_put(dict->dict, key, value);
+
+    return dict;
+}
+
+lval* builtin_dict_keys(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("dict-keys", node, 1);
+    LASSERT_ARG_DICT_OR_SET("dict-keys", node, 0);
+
+    lval* keys = lval_qexpr();
+    ldict_iter iter;
+    lval* key;
+    lval* value;
+
+    ldict_iter_init(&iter, node->values[0]->dict);
+    while (ldict_iter_next(&iter, &key, &value)) {
+        keys = lval_add(keys, lval_ref(key));
+    }
+
+    lval_del(node);
+    return keys;
+}
+
+lval* builtin_set(lenv* env, lval* node) {
+    UNUSED(env);
+
+    // The items are either the arguments or the items of a single list
+    lval* items = node;
+    if (node->count == 1 && node->values[0]->type == LVAL_QEXPR) {
+        items = node->values[0];
+    }
+
+    ldict* set = ldict_new();
+    for_item(items, {
+        ldict_put(set, lval_ref(item), NULL);
+    });
+
+    lval_del(node);
+    return lval_dict(set, true);
+}
+
+lval* builtin_set_add(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("set-add", node, 2);
+    LASSERT_ARG_TYPE("set-add", node, 0, LVAL_SET);
+
+    lval* set  = lval_pop(node, 0);
+    lval* item = lval_pop(node, 0);
+    lval_del(node);
+
+    set = lval_unshare(set);
+    ldict_put(set->dict, item, NULL);
+
+    return set;
+}
+
+lval* builtin_set_has(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("set-has?", node, 2);
+    LASSERT_ARG_DICT_OR_SET("set-has?", node, 0);
+
+    bool found = ldict_find(node->values[0]->dict, node->values[1], NULL);
+    lval_del(node);
+
+    return lval_int(found);
+}
@@ -1,34 +1,56 @@
 #include <lval.h>
+#include <eval.h>
 #include "builtin.h"
 
+/**
+ * Get the first item or all other items of an array.
+ *
+ * \param name  The name of the function.
+ * \param node  The array.
+ * \param head  Whether to keep the first item or the others.
+ *
+ * \returns An array sharing the items.
+ */
+static lval* array_head_tail(char* name, lval* node, bool head) {
+    LASSERT(node, node->values[0]->array->count > 0, "Function '%s' passed empty array.", name);
+
+    lval* array = lval_unshare(lval_take(node, 0));
+    larray_slice(array->array, head ? 0 : 1, head ? 1 : array->array->count);
+
+    return array;
+}
+
 lval* builtin_head(lenv* env, lval* node) {
     UNUSED(env);
 
     LASSERT_ARG_COUNT("head", node, 1);
+    if (node->values[0]->type == LVAL_ARRAY) {
+        return array_head_tail("head", node, true);
+    }
     LASSERT_ARG_TYPE("head", node, 0, LVAL_QEXPR);
     LASSERT_ARG_NOT_EMPTY_LIST("head", node, 0);
 
     lval* qexpr = lval_take(node, 0);
 
-    // Delete all elements that are not head and return
-    while (qexpr->count > 1) {
-        lval_del(lval_pop(qexpr, 1));
-    }
+    // Share the first element instead of deleting all the others
+    lval* head = lval_add(lval_qexpr(), lval_ref(qexpr->values[0]));
+    lval_del(qexpr);
 
-    return qexpr;
+    return head;
 }
 
 lval* builtin_tail(lenv* env, lval* node) {
     UNUSED(env);
 
     LASSERT_ARG_COUNT("tail", node, 1);
+    if (node->values[0]->type == LVAL_ARRAY) {
+        return array_head_tail("tail", node, false);
+    }
     LASSERT_ARG_TYPE("tail", node, 0, LVAL_QEXPR);
     LASSERT_ARG_NOT_EMPTY_LIST("tail", node, 0);
 
-    lval* qexpr = lval_take(node, 0);
-    lval_del(lval_pop(qexpr, 0));
-
-    return qexpr;
+    // A slice sharing the values, nothing is copied
+    return lval_drop(lval_take(node, 0), 1);
 }
 
 lval* builtin_list(lenv* env, lval* node) {
@@ -38,9 +60,53 @@ lval* builtin_list(lenv* env, lval* node) {
     return node;
 }
 
+/**
+ * Join arrays.
+ *
+ * The items of the shorter array are added to the longer one, the result
+ * shares the items of the longer array.
+ *
+ * \param node  The arrays, at least one.
+ *
+ * \returns The joined array.
+ */
+static lval* join_arrays(lval* node) {
+    for_item(node, {
+        LASSERT_ARG_TYPE("join", node, i, LVAL_ARRAY);
+    });
+
+    lval* joined = lval_pop(node, 0);
+
+    while (node->count) {
+        lval* next = lval_pop(node, 0);
+
+        if (next->array->count > joined->array->count) {
+            next = lval_unshare(next);
+            for (size_t i = joined->array->count; i > 0; i--) {
+                larray_prepend(next->array, lval_ref(larray_get(joined->array, i - 1)));
+            }
+            lval_del(joined);
+            joined = next;
+        } else {
+            joined = lval_unshare(joined);
+            for (size_t i = 0; i < next->array->count; i++) {
+                larray_push(joined->array, lval_ref(larray_get(next->array, i)));
+            }
+            lval_del(next);
+        }
+    }
+
+    lval_del(node);
+    return joined;
+}
+
 lval* builtin_join(lenv* env, lval* node) {
     UNUSED(env);
 
+    if (node->count > 0 && node->values[0]->type == LVAL_ARRAY) {
+        return join_arrays(node);
+    }
+
     for_item(node, {
         LASSERT_ARG_TYPE("join", node, i, LVAL_QEXPR);
     });
@@ -58,15 +124,365 @@ lval* builtin_cons(lenv* env, lval* node) {
     UNUSED(env);
 
     LASSERT_ARG_COUNT("cons", node, 2);
-    LASSERT_ARG_TYPE("cons", node, 1, LVAL_QEXPR);
+    if (node->values[1]->type != LVAL_ARRAY) {
+        LASSERT_ARG_TYPE("cons", node, 1, LVAL_QEXPR);
+    }
 
     lval* value = lval_pop(node, 0);
     lval* list = lval_pop(node, 0);
+    lval_del(node);
+
+    if (list->type == LVAL_ARRAY) {
+        list = lval_unshare(list);
+        larray_prepend(list->array, value);
+        return list;
+    }
+
+    // A shared list only gets copied if there's no room in front of it
+    return lval_prepend(list, value);
+}
+
+/**
+ * Get the value of an item like `1st` does: by evaluating it.
+ *
+ * \param env   The environment in which to evaluate the item.
+ * \param item  The item (shared).
+ *
+ * \returns The value.
+ */
+static lval* item_value(lenv* env, lval* item) {
+    return eval(env, lval_ref(item));
+}
+
+/**
+ * Check the arguments of a list function taking an index and a list.
+ *
+ * \param name  The name of the function.
+ * \param node  The arguments.
+ * \param end   Whether the index after the last item is valid.
+ *
+ * \returns `NULL` if the arguments are valid, an error otherwise (`node` is
+ *          deleted then).
+ */
+static lval* check_index(char* name, lval* node, bool end) {
+    LASSERT_ARG_COUNT(name, node, 2);
+    LASSERT_ARG_TYPE(name, node, 0, LVAL_INT);
+    LASSERT_ARG_TYPE(name, node, 1, LVAL_QEXPR);
+
+    PRECISION_INT index = node->values[0]->integer;
+    size_t count = node->values[1]->count;
+
+    LASSERT(node, index >= 0 && (uint64_t) index < count + end,
+            "Function '%s' passed index %lld out of range, the list has %zu items.",
+            name, (long long) index, count);
+
+    return NULL;
+}
+
+/// Create a list of the first `count` items of a list, sharing them.
+static lval* list_front(lval* list, size_t count) {
+    lval* front = lval_qexpr();
+    for (size_t i = 0; i < count; i++) {
+        front = lval_add(front, lval_ref(list->values[i]));
+    }
+
+    return front;
+}
+
+lval* builtin_split_list(lenv* env, lval* node) {
+    UNUSED(env);
+
+    lval* error = check_index("split", node, true);
+    if (error) {
+        return error;
+    }
+
+    size_t index = (size_t) node->values[0]->integer;
+    lval* list = lval_take(node, 1);
+
+    // The back is a slice sharing the values
+    lval* parts = lval_add(lval_qexpr(), list_front(list, index));
+    return lval_add(parts, lval_drop(list, index));
+}
+
+lval* builtin_take(lenv* env, lval* node) {
+    UNUSED(env);
+
+    lval* error = check_index("take", node, true);
+    if (error) {
+        return error;
+    }
+
+    lval* front = list_front(node->values[1], (size_t) node->values[0]->integer);
+    lval_del(node);
+
+    return front;
+}
+
+lval* builtin_drop(lenv* env, lval* node) {
+    UNUSED(env);
+
+    lval* error = check_index("drop", node, true);
+    if (error) {
+        return error;
+    }
+
+    size_t count = (size_t) node->values[0]->integer;
+
+    // A slice sharing the values, nothing is copied
+    return lval_drop(lval_take(node, 1), count);
+}
+
+lval* builtin_len(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("len", node, 1);
+
+    lval* arg = node->values[0];
+    size_t count;
+
+    if (arg->type == LVAL_QEXPR) {
+        count = arg->count;
+    } else if (arg->type == LVAL_ARRAY) {
+        count = arg->array->count;
+    } else if (arg->type == LVAL_DICT || arg->type == LVAL_SET) {
+        count = arg->dict->count;
+    } else {
+        LERROR(node, "Function 'len' passed incorrect argument types. Expected %s, got %s.",
+               lval_str_type(LVAL_QEXPR), lval_str_type(arg->type));
+    }
+
+    lval_del(node);
+    return lval_int((PRECISION_INT) count);
+}
 
-    lval* container = lval_qexpr();
-    container = lval_add(container, value);
-    container = lval_join(container, list);
+/// Get an item of an array as it is, it's not evaluated like an item of a list.
+static lval* array_nth(lval* node) {
+    LASSERT_ARG_TYPE("nth", node, 0, LVAL_INT);
+
+    PRECISION_INT index = node->values[0]->integer;
+    larray* array = node->values[1]->array;
+
+    LASSERT(node, index >= 0 && (uint64_t) index < array->count,
+            "Function 'nth' passed index %lld out of range, the array has %zu items.",
+            (long long) index, array->count);
+
+    lval* item = lval_ref(larray_get(array, (size_t) index));
+    lval_del(node);
+
+    return item;
+}
+
+lval* builtin_nth(lenv* env, lval* node) {
+    if (node->count == 2 && node->values[1]->type == LVAL_ARRAY) {
+        return array_nth(node);
+    }
+
+    lval* error = check_index("nth", node, false);
+    if (error) {
+        return error;
+    }
+
+    lval* value = item_value(env, node->values[1]->values[node->values[0]->integer]);
+    lval_del(node);
+
+    return value;
+}
+
+lval* builtin_last(lenv* env, lval* node) {
+    LASSERT_ARG_COUNT("last", node, 1);
+    if (node->values[0]->type == LVAL_ARRAY) {
+        larray* array = node->values[0]->array;
+        LASSERT(node, array->count > 0, "Function 'last' passed empty array.");
+
+        lval* item = lval_ref(larray_get(array, array->count - 1));
+        lval_del(node);
+        return item;
+    }
+    LASSERT_ARG_TYPE("last", node, 0, LVAL_QEXPR);
+    LASSERT_ARG_NOT_EMPTY_LIST("last", node, 0);
+
+    lval* list = node->values[0];
+    lval* value = item_value(env, list->values[list->count - 1]);
+    lval_del(node);
+
+    return value;
+}
+
+lval* builtin_reverse(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("reverse", node, 1);
+    LASSERT_ARG_TYPE("reverse", node, 0, LVAL_QEXPR);
+
+    lval* list = node->values[0];
+    lval** values = xmalloc(LVAL_PTR_SIZE * (list->count + 1));
+    for (size_t i = 0; i < list->count; i++) {
+        values[i] = lval_ref(list->values[list->count - 1 - i]);
+    }
+
+    lval* reversed = lval_sexpr_from(values, list->count);
+    reversed->type = LVAL_QEXPR;
+    xfree(values);
+
+    lval_del(node);
+    return reversed;
+}
+
+lval* builtin_elem(lenv* env, lval* node) {
+    LASSERT_ARG_COUNT("elem?", node, 2);
+    LASSERT_ARG_TYPE("elem?", node, 1, LVAL_QEXPR);
+
+    lval* x = node->values[0];
+    lval* found = NULL;
+
+    for_item(node->values[1], {
+        lval* value = item_value(env, item);
+        if (value->type == LVAL_ERR) {
+            found = value;
+            break;
+        }
+
+        bool equal = lval_eq(x, value);
+        lval_del(value);
+
+        if (equal) {
+            found = lval_int(1);
+            break;
+        }
+    });
+
+    lval_del(node);
+    return found ? found : lval_int(0);
+}
+
+lval* builtin_map(lenv* env, lval* node) {
+    LASSERT_ARG_COUNT("map", node, 2);
+    LASSERT_ARG_TYPE("map", node, 0, LVAL_FUNC);
+    LASSERT_ARG_TYPE("map", node, 1, LVAL_QEXPR);
+
+    lval* func = node->values[0];
+    lval* results = lval_qexpr();
+
+    for_item(node->values[1], {
+        lval* result = item_value(env, item);
+        if (result->type != LVAL_ERR) {
+            result = eval_apply(env, func, &result, 1);
+        }
+
+        if (result->type == LVAL_ERR) {
+            lval_del(results); lval_del(node);
+            return result;
+        }
+
+        results = lval_add(results, result);
+    });
+
+    lval_del(node);
+    return results;
+}
+
+lval* builtin_filter(lenv* env, lval* node) {
+    LASSERT_ARG_COUNT("filter", node, 2);
+    LASSERT_ARG_TYPE("filter", node, 0, LVAL_FUNC);
+    LASSERT_ARG_TYPE("filter", node, 1, LVAL_QEXPR);
+
+    lval* func = node->values[0];
+    lval* kept = lval_qexpr();
+
+    for_item(node->values[1], {
+        lval* result = item_value(env, item);
+        if (result->type != LVAL_ERR) {
+            result = eval_apply(env, func, &result, 1);
+        }
+
+        // Conditions are numbers, like the ones of 'if'
+        if (result->type != LVAL_ERR && !lval_is_number(result)) {
+            lval* error = lval_err("Function 'filter' passed a function returning %s, expected number.",
+                                   lval_str_type(result->type));
+            lval_del(result);
+            result = error;
+        }
+
+        if (result->type == LVAL_ERR) {
+            lval_del(kept); lval_del(node);
+            return result;
+        }
+
+        // The items are kept as they are, not their values
+        if (!lval_is_zero(result)) {
+            kept = lval_add(kept, lval_ref(item));
+        }
+        lval_del(result);
+    });
+
+    lval_del(node);
+    return kept;
+}
+
+/**
+ * Combine the items of a sequence from left to right, pulling them one at a
+ * time.
+ *
+ * \param env   The environment.
+ * \param func  The function taking the result so far and an item.
+ * \param acc   The initial value (consumed).
+ * \param seq   The sequence.
+ *
+ * \returns The last result or the first error.
+ */
+static lval* fold_seq(lenv* env, lval* func, lval* acc, lval* seq) {
+    lseq_iter* iter = lseq_iter_new(seq);
+    lval* item;
+
+    while ((item = lseq_iter_next(env, iter))) {
+        if (item->type == LVAL_ERR) {
+            lval_del(acc);
+            acc = item;
+            break;
+        }
+
+        acc = eval_apply(env, func, (lval*[]) {acc, item}, 2);
+        if (acc->type == LVAL_ERR) {
+            break;
+        }
+    }
+
+    lseq_iter_del(iter);
+    return acc;
+}
+
+lval* builtin_foldl(lenv* env, lval* node) {
+    LASSERT_ARG_COUNT("foldl", node, 3);
+    LASSERT_ARG_TYPE("foldl", node, 0, LVAL_FUNC);
+    LASSERT(node, node->values[2]->type == LVAL_QEXPR || node->values[2]->type == LVAL_SEQ,
+            "Function 'foldl' passed incorrect argument types. Expected %s or %s, got %s.",
+            lval_str_type(LVAL_QEXPR), lval_str_type(LVAL_SEQ),
+            lval_str_type(node->values[2]->type));
+
+    lval* func = node->values[0];
+    lval* acc  = lval_ref(node->values[1]);
+
+    if (node->values[2]->type == LVAL_SEQ) {
+        acc = fold_seq(env, func, acc, node->values[2]);
+        lval_del(node);
+        return acc;
+    }
+
+    for_item(node->values[2], {
+        lval* value = item_value(env, item);
+        if (value->type == LVAL_ERR) {
+            lval_del(acc);
+            acc = value;
+            break;
+        }
+
+        acc = eval_apply(env, func, (lval*[]) {acc, value}, 2);
+        if (acc->type == LVAL_ERR) {
+            break;
+        }
+    });
 
     lval_del(node);
-    return container;
+    return acc;
 }
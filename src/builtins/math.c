@@ -9,45 +9,277 @@ lval* builtin_mul(lenv* env, lval* node) { return builtin_op(env, node, '*'); }
 lval* builtin_div(lenv* env, lval* node) { return builtin_op(env, node, '/'); }
 lval* builtin_mod(lenv* env, lval* node) { return builtin_op(env, node, '%'); }
 
+/**
+ * Apply an operator to two big integers.
+ *
+ * \param op        The operator: `+`, `-`, `*`, `/` or `%`.
+ * \param x         The first operand (consumed).
+ * \param y         The second operand, not zero for `/` and `%`.
+ *
+ * \returns The result or `NULL` if a division has a remainder, then `x` is
+ *          kept.
+ */
+static lbig* big_op(char op, lbig* x, lbig* y) {
+    lbig* result;
+    lbig* remainder;
+
+    switch (op) {
+        case '+': result = lbig_add(x, y); break;
+        case '-': result = lbig_sub(x, y); break;
+        case '*': result = lbig_mul(x, y); break;
+
+        case '/':
+            result = lbig_divmod(x, y, &remainder);
+            if (remainder->count > 0) {
+                lbig_del(remainder);
+                lbig_del(result);
+                return NULL;
+            }
+            lbig_del(remainder);
+            break;
+
+        case '%':
+            lbig_del(lbig_divmod(x, y, &result));
+            break;
+
+        default:
+            ASSERTF(0, "Invalid op in big_op: %c", op);
+            return NULL;
+    }
+
+    lbig_del(x);
+    return result;
+}
+
+/**
+ * Apply an operator to two integers.
+ *
+ * \param op            The operator: `+`, `-`, `*`, `/` or `%`.
+ * \param x             The first operand.
+ * \param y             The second operand, not zero for `/` and `%`.
+ * \param result [out]  The result, only set if it's an integer.
+ *
+ * \returns Whether the result is an integer. It isn't if it overflows, then
+ *          it has to be computed with big integers, or if a division has a
+ *          remainder, then it has to be computed with floats.
+ */
+static inline bool int_op(char op, PRECISION_INT x, PRECISION_INT y, PRECISION_INT* result) {
+    switch (op) {
+        case '+':
+            if ((y > 0 && x > PRECISION_INT_MAX - y) || (y < 0 && x < PRECISION_INT_MIN - y)) {
+                return false;
+            }
+            *result = x + y;
+            return true;
+
+        case '-':
+            if ((y < 0 && x > PRECISION_INT_MAX + y) || (y > 0 && x < PRECISION_INT_MIN + y)) {
+                return false;
+            }
+            *result = x - y;
+            return true;
+
+        case '*':
+            // Products of factors fitting 32 bits always fit, the others need
+            // a division to check
+            if (((uint64_t) x + 0x80000000u > 0xFFFFFFFFu || (uint64_t) y + 0x80000000u > 0xFFFFFFFFu)
+                    && (x > 0 ? (y > 0 ? x > PRECISION_INT_MAX / y : y < PRECISION_INT_MIN / x)
+                              : (y > 0 ? x < PRECISION_INT_MIN / y : (x != 0 && y < PRECISION_INT_MAX / x)))) {
+                return false;
+            }
+            *result = x * y;
+            return true;
+
+        case '/':
+            if ((x == PRECISION_INT_MIN && y == -1) || x % y != 0) {
+                return false;
+            }
+            *result = x / y;
+            return true;
+
+        case '%':
+            *result = y == -1 ? 0 : x % y;
+            return true;
+
+        default:
+            ASSERTF(0, "Invalid op in int_op: %c", op);
+            return false;
+    }
+}
+
+/**
+ * Add or subtract plain integers.
+ *
+ * Sums the upper and lower 32 bits of the values apart: neither sum can
+ * overflow for less than 2^31 values, so the loop doesn't have to check each
+ * addition and has no branches. Only the result is checked.
+ *
+ * \param values        The integers, all of type #LVAL_INT.
+ * \param count         The number of integers, less than 2^31.
+ * \param subtract      Whether to subtract the rest from the first one.
+ * \param result [out]  The result, only set if it fits.
+ *
+ * \returns Whether the result fits #PRECISION_INT.
+ */
+static bool int_sum(lval** values, size_t count, bool subtract, PRECISION_INT* result) {
+    int64_t high = 0;
+    int64_t low  = 0;
+
+    for (size_t i = 1; i < count; i++) {
+        PRECISION_INT value = values[i]->integer;
+        high += value >> 32;
+        low  += value & 0xFFFFFFFF;
+    }
+
+    if (subtract) {
+        high = -high;
+        low  = -low;
+    }
+
+    high += values[0]->integer >> 32;
+    low  += values[0]->integer & 0xFFFFFFFF;
+
+    // Carry the lower sum's excess into the upper one
+    high += low / 0x100000000;
+    low  %= 0x100000000;
+    if (low < 0) {
+        low += 0x100000000;
+        high--;
+    }
+
+    if (high < -0x80000000LL || high > 0x7FFFFFFF) {
+        return false;
+    }
+
+    *result = high * 0x100000000 + low;
+    return true;
+}
+
 lval* builtin_op(lenv* env, lval* node, char op) {
     UNUSED(env);
 
     char name[2]; name[0] = op; name[1] = '\0';
 
-    // Ensure all arguments are numbers
+    // Ensure all arguments are numbers, once for all operations
+    bool integers = true;
     for_item(node, {
-        LASSERT_ARG_TYPE(name, node, i, LVAL_NUM);
+        LASSERT_ARG_NUMBER(name, node, i);
+        integers &= item->type == LVAL_INT;
     });
 
-    lval* x = lval_pop(node, 0);
-
-    // If no arguments and op == '-', do unary negation
-    if ((op == '-') && node->count == 0) {
-        x->num *= -1;
+    PRECISION_INT sum;
+    if (integers && (op == '+' || (op == '-' && node->count > 1))
+            && node->count < 0x80000000u && int_sum(node->values, node->count, op == '-', &sum)) {
+        lval_del(node);
+        return lval_int(sum);
     }
 
-    while (node->count > 0) {
-        lval* y = lval_pop(node, 0);
+    // Compute on plain numbers, only the result is a new object
+    PRECISION_FLOAT x = lval_to_float(node->values[0]);
+    size_t i = 1;
+    lbig* big = NULL;
+
+    // Integers stay integers as long as the operands are integers: as plain
+    // numbers while the results fit, as big integers afterwards. The rest is
+    // computed with floats.
+    if (node->values[0]->type == LVAL_INT) {
+        PRECISION_INT n = node->values[0]->integer;
+        bool exact = true;
+
+        if ((op == '-') && node->count == 1) {
+            exact = int_op('-', 0, n, &n);
+        }
+
+        for (; exact && i < node->count && node->values[i]->type == LVAL_INT; i++) {
+            PRECISION_INT y = node->values[i]->integer;
+
+            if ((op == '/' || op == '%') && y == 0) {
+                lval_del(node);
+                return lval_err("Division by zero");
+            }
 
-        if      (op == '+') { x->num += y->num; }
-        else if (op == '-') { x->num -= y->num; }
-        else if (op == '*') { x->num *= y->num; }
-        else if (op == '/' || op == '%') {
-            if (fcmp(y->num, 0)) {
-                lval_del(x); lval_del(y);
-                x = lval_err("Division by zero");
+            if (!int_op(op, n, y, &n)) {
+                exact = false;
                 break;
             }
+        }
+
+        if (exact && i == node->count) {
+            lval_del(node);
+            return lval_int(n);
+        }
+
+        if (!exact || node->values[i]->type == LVAL_BIG) {
+            big = lbig_from_int(n);
+        } else {
+            x = (PRECISION_FLOAT) n;
+        }
+    } else if (node->values[0]->type == LVAL_BIG) {
+        big = lbig_copy(node->values[0]->big);
+    }
+
+    if (big) {
+        if ((op == '-') && node->count == 1) {
+            lbig* negated = lbig_neg(big);
+            lbig_del(big);
+            lval_del(node);
+            return lval_big(negated);
+        }
+
+        for (; i < node->count && lval_is_integer(node->values[i]); i++) {
+            lbig* y = lval_to_big(node->values[i]);
+
+            if ((op == '/' || op == '%') && y->count == 0) {
+                lbig_del(y);
+                lbig_del(big);
+                lval_del(node);
+                return lval_err("Division by zero");
+            }
+
+            lbig* result = big_op(op, big, y);
+            lbig_del(y);
 
-            switch (op) {
-                case '%': x->num = fmod(x->num, y->num); break;
-                case '/': x->num /= y->num; break;
+            if (!result) {
+                break;
             }
+            big = result;
+        }
+
+        if (i == node->count) {
+            lval_del(node);
+            return lval_big(big);
         }
 
-        lval_del(y);
+        x = lbig_to_float(big);
+        lbig_del(big);
+    }
+
+    // If no arguments and op == '-', do unary negation
+    if ((op == '-') && node->count == 1) {
+        x *= -1;
+    }
+
+    // One loop per operation, the operation isn't checked for each value
+    switch (op) {
+        case '+': for (; i < node->count; i++) { x += FLOAT_VALUE(node->values[i]); } break;
+        case '-': for (; i < node->count; i++) { x -= FLOAT_VALUE(node->values[i]); } break;
+        case '*': for (; i < node->count; i++) { x *= FLOAT_VALUE(node->values[i]); } break;
+
+        case '/':
+        case '%':
+            for (; i < node->count; i++) {
+                PRECISION_FLOAT y = FLOAT_VALUE(node->values[i]);
+
+                if (fcmp(y, 0)) {
+                    lval_del(node);
+                    return lval_err("Division by zero");
+                }
+
+                x = op == '/' ? x / y : fmod(x, y);
+            }
+            break;
     }
 
     lval_del(node);
-    return x;
+    return lval_num(x);
 }
@@ -1,37 +1,81 @@
+#include "alloc.h"
 #include "lval.h"
 #include "parser.h"
 #include "eval.h"
+#include "gc.h"
+#include "cache.h"
 #include "builtin.h"
 
+/**
+ * Evaluate a top-level expression of a loaded file.
+ *
+ * \param env   The environment.
+ * \param node  The arguments of `load`, kept alive while collecting.
+ * \param expr  The expression to evaluate.
+ */
+static void load_eval(lenv* env, lval* node, lval* expr) {
+    UNUSED(node);
+
+    lval* result = eval(env, expr);
+
+    // Handle errors
+    if (result->type == LVAL_ERR) {
+        lval_println(env, result);
+    }
+    lval_del(result);
+
+    lalloc_end_eval();
+
+    // Only collects when loading from the top level
+    gc_root_env(env); gc_root(node);
+    gc_safepoint();
+    gc_unroot(node); gc_unroot_env(env);
+}
+
 lval* builtin_load(lenv* env, lval* node) {
     LASSERT_ARG_COUNT("load", node, 1);
     LASSERT_ARG_TYPE("load", node, 0, LVAL_STR);
 
-    mpc_result_t r;
-    char* filename = node->values[0]->str;
+    mpc_err_t* error = NULL;
+    char* filename = lval_str_cstr(node->values[0]);
+    lval* expr;
 
-    // TODO: Move to parse.c
-    if (mpc_parse_contents(filename, parser_get(), &r)) {
-        // Read contents
-        lval* expr = parse_tree(r.output);
-        mpc_ast_delete(r.output);
+    // Skip the reader if the file didn't change since it was cached
+    lcache* cache = cache_open(filename);
+    if (cache && cache_hit(cache)) {
+        while ((expr = cache_next(cache))) {
+            load_eval(env, node, expr);
+        }
 
-        // Evaluate each expression
-        while (expr->count) {
-            lval* result = eval(env, lval_pop(expr, 0));
+        cache_close(cache, false);
+        lval_del(node);
+        return lval_sexpr();
+    }
 
-            // Handle errors
-            if (result->type == LVAL_ERR) {
-                lval_println(env, result);
+    // Read, evaluate and free one expression at a time
+    lstream* stream = parse_stream_open(filename, &error);
+    if (stream) {
+        while ((expr = parse_stream_next(stream, &error))) {
+            if (cache) {
+                cache_add(cache, expr);
             }
-            lval_del(result);
+
+            load_eval(env, node, expr);
         }
 
-        lval_del(expr); lval_del(node);
+        parse_stream_close(stream);
+    }
+
+    if (cache) {
+        cache_close(cache, error == NULL);
+    }
+
+    if (error == NULL) {
+        lval_del(node);
         return lval_sexpr();
     } else {
-        char* error_message = mpc_err_string(r.error);
-        mpc_err_delete(r.error);
+        char* error_message = mpc_err_string(error);
+        mpc_err_delete(error);
         // Remove trailing \n
         error_message[strlen(error_message) - 1] = ' ';
         lval* err;
@@ -86,7 +130,7 @@ lval* builtin_error(lenv* env, lval* node) {
     LASSERT_ARG_COUNT("error", node, 1);
     LASSERT_ARG_TYPE("error", node, 0, LVAL_STR);
 
-    lval* err = lval_err(node->values[0]->str);
+    lval* err = lval_err(lval_str_cstr(node->values[0]));
 
     lval_del(node);
     return err;
@@ -94,21 +138,67 @@ lval* builtin_error(lenv* env, lval* node) {
 }
 
 lval* builtin_eval(lenv* env, lval* node) {
+    return eval(env, builtin_eval_expr(node));
+}
+
+lval* builtin_eval_expr(lval* node) {
     LASSERT_ARG_COUNT("eval", node, 1);
     LASSERT_ARG_TYPE("eval", node, 0, LVAL_QEXPR);
 
-    lval* qexpr = lval_take(node, 0);
+    lval* qexpr = lval_unshare(lval_take(node, 0));
     qexpr->type = LVAL_SEXPR;
 
-    return eval(env, qexpr);
+    return qexpr;
+}
+
+lval* builtin_quote(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("quote", node, 1);
+
+    return builtin_quote_expr(lval_take(node, 0));
+}
+
+lval* builtin_quote_expr(lval* expr) {
+    if (expr->type == LVAL_SEXPR) {
+        expr = lval_unshare(expr);
+        expr->type = LVAL_QEXPR;
+    }
+
+    return expr;
 }
 
 #if defined DEBUG
     lval* builtin_debug_stats(lenv* env, lval* node) {
         UNUSED(env);
         lval_print_stats();
+        lalloc_print_stats();
+        cache_print_stats();
+#if defined MLISP_GC
+        gc_print_stats();
+#endif
 
         lval_del(node);
         return lval_sexpr();
     }
 #endif
+
+#if defined MLISP_GC
+    lval* builtin_gc_stats(lenv* env, lval* node) {
+        UNUSED(env);
+        lval_del(node);
+
+        gc_stats stats;
+        gc_get_stats(&stats);
+
+        lval* result = lval_qexpr();
+        lval_add(result, lval_int((PRECISION_INT) stats.collections));
+        lval_add(result, lval_num(stats.pause_total));
+        lval_add(result, lval_num(stats.pause_max));
+        lval_add(result, lval_int((PRECISION_INT) stats.live_bytes));
+        lval_add(result, lval_int((PRECISION_INT) stats.heap_bytes));
+        lval_add(result, lval_int((PRECISION_INT) stats.threshold));
+
+        return result;
+    }
+#endif
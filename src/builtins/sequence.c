@@ -0,0 +1,111 @@
+#include <lval.h>
+#include <sequence.h>
+#include "builtin.h"
+
+lval* builtin_range(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_MIN_ARG_COUNT("range", node, 1);
+    LASSERT_MAX_ARG_COUNT("range", node, 3);
+    for_item(node, {
+        LASSERT_ARG_TYPE("range", node, i, LVAL_INT);
+    });
+
+    // (range end), (range start end) or (range start end step)
+    PRECISION_INT start = node->count > 1 ? node->values[0]->integer : 0;
+    PRECISION_INT end   = node->values[node->count > 1 ? 1 : 0]->integer;
+    PRECISION_INT step  = node->count > 2 ? node->values[2]->integer : 1;
+
+    LASSERT(node, step != 0, "Function 'range' passed step 0.");
+
+    lval_del(node);
+    return lval_seq(lseq_range(start, end, step));
+}
+
+lval* builtin_lines(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("lines", node, 1);
+    LASSERT_ARG_TYPE("lines", node, 0, LVAL_STR);
+
+    // The file is opened when the sequence is consumed
+    lval* seq = lval_seq(lseq_new(LSEQ_LINES, lval_ref(node->values[0]), NULL));
+    lval_del(node);
+
+    return seq;
+}
+
+/**
+ * Create a stage applying a function to the items of a sequence or a list.
+ *
+ * \param node  The function and the sequence or the list.
+ * \param name  The name of the builtin.
+ * \param kind  The kind of the stage.
+ *
+ * \returns The sequence.
+ */
+static lval* stage(lval* node, char* name, lseq_kind kind) {
+    LASSERT_ARG_COUNT(name, node, 2);
+    LASSERT_ARG_TYPE(name, node, 0, LVAL_FUNC);
+    LASSERT(node, node->values[1]->type == LVAL_SEQ || node->values[1]->type == LVAL_QEXPR,
+            "Function '%s' passed incorrect argument types. Expected %s or %s, got %s.",
+            name, lval_str_type(LVAL_SEQ), lval_str_type(LVAL_QEXPR),
+            lval_str_type(node->values[1]->type));
+
+    lval* source = lval_ref(node->values[1]);
+    if (source->type == LVAL_QEXPR) {
+        source = lval_seq(lseq_new(LSEQ_LIST, source, NULL));
+    }
+
+    lval* seq = lval_seq(lseq_new(kind, source, lval_ref(node->values[0])));
+    lval_del(node);
+
+    return seq;
+}
+
+lval* builtin_lazy_map(lenv* env, lval* node) {
+    UNUSED(env);
+    return stage(node, "lazy-map", LSEQ_MAP);
+}
+
+lval* builtin_lazy_filter(lenv* env, lval* node) {
+    UNUSED(env);
+    return stage(node, "lazy-filter", LSEQ_FILTER);
+}
+
+lval* builtin_take_while(lenv* env, lval* node) {
+    UNUSED(env);
+    return stage(node, "take-while", LSEQ_TAKE_WHILE);
+}
+
+lval* builtin_realize(lenv* env, lval* node) {
+    LASSERT_ARG_COUNT("realize", node, 1);
+    LASSERT(node, node->values[0]->type == LVAL_SEQ || node->values[0]->type == LVAL_QEXPR,
+            "Function 'realize' passed incorrect argument types. Expected %s or %s, got %s.",
+            lval_str_type(LVAL_SEQ), lval_str_type(LVAL_QEXPR),
+            lval_str_type(node->values[0]->type));
+
+    if (node->values[0]->type == LVAL_QEXPR) {
+        lval* list = lval_ref(node->values[0]);
+        lval_del(node);
+        return list;
+    }
+
+    lseq_iter* iter = lseq_iter_new(node->values[0]);
+    lval* list = lval_qexpr();
+    lval* item;
+
+    while ((item = lseq_iter_next(env, iter))) {
+        if (item->type == LVAL_ERR) {
+            lval_del(list);
+            list = item;
+            break;
+        }
+        list = lval_add(list, item);
+    }
+
+    lseq_iter_del(iter);
+    lval_del(node);
+
+    return list;
+}
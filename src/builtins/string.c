@@ -0,0 +1,185 @@
+#include <lval.h>
+#include <parser.h>
+#include "builtin.h"
+
+/**
+ * Find the first occurrence of a string in another one.
+ *
+ * \param str           The characters to search.
+ * \param length        The number of characters to search.
+ * \param needle        The characters to find.
+ * \param needle_len    The number of characters to find, at least one.
+ *
+ * \returns The first occurrence or `NULL` if there's none.
+ */
+static char* find(char* str, size_t length, char* needle, size_t needle_len) {
+    if (needle_len > length) {
+        return NULL;
+    }
+
+    char* last = str + length - needle_len;
+
+    // Only compare where the first character matches
+    for (char* pos = str; pos <= last; pos++) {
+        pos = memchr(pos, needle[0], (size_t) (last - pos) + 1);
+
+        if (pos == NULL) {
+            return NULL;
+        } else if (memcmp(pos + 1, needle + 1, needle_len - 1) == 0) {
+            return pos;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Get an optional index argument of a string function.
+ *
+ * \param node      The arguments.
+ * \param i         The index of the argument.
+ * \param fallback  The index if the argument is missing.
+ * \param index     [out] The index.
+ *
+ * \returns Whether the argument is missing or an integer.
+ */
+static bool index_arg(lval* node, size_t i, PRECISION_INT fallback, PRECISION_INT* index) {
+    if (node->count <= i) {
+        *index = fallback;
+        return true;
+    }
+
+    if (node->values[i]->type != LVAL_INT) {
+        return false;
+    }
+
+    *index = node->values[i]->integer;
+    return true;
+}
+
+lval* builtin_concat(lenv* env, lval* node) {
+    UNUSED(env);
+
+    for_item(node, {
+        LASSERT_ARG_TYPE("concat", node, i, LVAL_STR);
+    });
+
+    if (node->count == 0) {
+        lval_del(node);
+        return lval_str("");
+    }
+
+    lval* str = lval_str_concat(node->values, node->count);
+    lval_del(node);
+
+    return str;
+}
+
+lval* builtin_substr(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_MIN_ARG_COUNT("substr", node, 2);
+    LASSERT_MAX_ARG_COUNT("substr", node, 3);
+    LASSERT_ARG_TYPE("substr", node, 0, LVAL_STR);
+    LASSERT_ARG_TYPE("substr", node, 1, LVAL_INT);
+
+    lval* str = node->values[0];
+    PRECISION_INT start = node->values[1]->integer;
+    PRECISION_INT end;
+
+    LASSERT(node, index_arg(node, 2, (PRECISION_INT) str->length, &end),
+            "Function 'substr' passed incorrect argument types. Expected %s, got %s.",
+            lval_str_type(LVAL_INT), lval_str_type(node->values[2]->type));
+    LASSERT(node, start >= 0 && start <= end && (uint64_t) end <= str->length,
+            "Function 'substr' passed range [%lld, %lld) out of range, the string has %zu characters.",
+            (long long) start, (long long) end, str->length);
+
+    lval* sub = lval_str_sub(str, (size_t) start, (size_t) (end - start));
+    lval_del(node);
+
+    return sub;
+}
+
+lval* builtin_split(lenv* env, lval* node) {
+    if (node->count > 0 && node->values[0]->type == LVAL_INT) {
+        return builtin_split_list(env, node);
+    }
+
+    LASSERT_ARG_COUNT("split", node, 2);
+    LASSERT_ARG_TYPE("split", node, 0, LVAL_STR);
+    LASSERT_ARG_TYPE("split", node, 1, LVAL_STR);
+
+    lval* str = node->values[0];
+    lval* sep = node->values[1];
+
+    LASSERT(node, sep->length > 0, "Function 'split' passed empty separator.");
+
+    // The parts share the characters of the string
+    lval* parts = lval_qexpr();
+    char* end = str->str + str->length;
+    char* part = str->str;
+
+    for (char* pos; (pos = find(part, (size_t) (end - part), sep->str, sep->length)); part = pos + sep->length) {
+        parts = lval_add(parts, lval_str_sub(str, (size_t) (part - str->str), (size_t) (pos - part)));
+    }
+    parts = lval_add(parts, lval_str_sub(str, (size_t) (part - str->str), (size_t) (end - part)));
+
+    lval_del(node);
+    return parts;
+}
+
+lval* builtin_find(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_MIN_ARG_COUNT("find", node, 2);
+    LASSERT_MAX_ARG_COUNT("find", node, 3);
+    LASSERT_ARG_TYPE("find", node, 0, LVAL_STR);
+    LASSERT_ARG_TYPE("find", node, 1, LVAL_STR);
+
+    lval* str    = node->values[0];
+    lval* needle = node->values[1];
+    PRECISION_INT start;
+
+    LASSERT(node, index_arg(node, 2, 0, &start),
+            "Function 'find' passed incorrect argument types. Expected %s, got %s.",
+            lval_str_type(LVAL_INT), lval_str_type(node->values[2]->type));
+    LASSERT(node, start >= 0 && (uint64_t) start <= str->length,
+            "Function 'find' passed index %lld out of range, the string has %zu characters.",
+            (long long) start, str->length);
+
+    PRECISION_INT index = start;
+    if (needle->length > 0) {
+        char* pos = find(str->str + start, str->length - (size_t) start, needle->str, needle->length);
+        index = pos ? pos - str->str : -1;
+    }
+
+    lval_del(node);
+    return lval_int(index);
+}
+
+lval* builtin_str_len(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("str-len", node, 1);
+    LASSERT_ARG_TYPE("str-len", node, 0, LVAL_STR);
+
+    lval* length = lval_int((PRECISION_INT) node->values[0]->length);
+    lval_del(node);
+
+    return length;
+}
+
+lval* builtin_str_to_num(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("str->num", node, 1);
+    LASSERT_ARG_TYPE("str->num", node, 0, LVAL_STR);
+
+    lval* str = node->values[0];
+    lval* num = parse_number(str->str, str->length);
+
+    LASSERT(node, num != NULL, "Function 'str->num' passed a string that isn't a number.");
+
+    lval_del(node);
+    return num;
+}
@@ -0,0 +1,364 @@
+#include <lval.h>
+#include "builtin.h"
+
+/**
+ * Assert that the `i`-th argument is a vector or a number.
+ */
+#define LASSERT_ARG_VECTOR_OR_NUMBER(name, node, i) \
+    LASSERT(node, node->values[i]->type == LVAL_VEC || lval_is_number(node->values[i]), \
+            "Function '%s' passed incorrect argument types. Expected vector or number, got %s.", \
+            name, lval_str_type(node->values[i]->type));
+
+/**
+ * Get the items of an operand of an element-wise operation.
+ *
+ * \param node  A vector or a number.
+ *
+ * \returns The vector's items or a new vector with the number as single item,
+ *          big integers are rounded to floats.
+ */
+static lvec* operand(lval* node) {
+    if (node->type == LVAL_VEC) {
+        return node->vec;
+    }
+
+    lvec* vec = lvec_new(node->type == LVAL_INT, 1);
+    if (vec->integers) {
+        vec->ints[0] = node->integer;
+    } else {
+        vec->floats[0] = lval_to_float(node);
+    }
+
+    return vec;
+}
+
+/**
+ * Check the operands of an element-wise operation.
+ *
+ * \param name  The name of the operation.
+ * \param node  The arguments.
+ *
+ * \returns `NULL` if they are valid, an error otherwise (`node` is deleted
+ *          then).
+ */
+static lval* check_operands(char* name, lval* node) {
+    LASSERT_ARG_COUNT(name, node, 2);
+    LASSERT_ARG_VECTOR_OR_NUMBER(name, node, 0);
+    LASSERT_ARG_VECTOR_OR_NUMBER(name, node, 1);
+
+    lval* x = node->values[0];
+    lval* y = node->values[1];
+
+    LASSERT(node, x->type == LVAL_VEC || y->type == LVAL_VEC,
+            "Function '%s' passed incorrect argument types. Expected at least one vector.", name);
+    LASSERT(node, x->type != LVAL_VEC || y->type != LVAL_VEC || x->vec->count == y->vec->count,
+            "Function '%s' passed vectors of different lengths: %zu and %zu.",
+            name, x->vec->count, y->vec->count);
+
+    return NULL;
+}
+
+/**
+ * Apply an operator to each pair of items of two vectors, or of a vector and
+ * a number.
+ *
+ * \param env   The environment.
+ * \param node  The operands.
+ * \param name  The name of the operation.
+ * \param op    The operator: `+`, `-`, `*`, `/` or `%`.
+ *
+ * \returns A vector of the results.
+ */
+static lval* builtin_vec_op(lenv* env, lval* node, char* name, char op) {
+    UNUSED(env);
+
+    lval* error = check_operands(name, node);
+    if (error) {
+        return error;
+    }
+
+    lvec* x = operand(node->values[0]);
+    lvec* y = operand(node->values[1]);
+    lvec* result = lvec_arith(op, x, y);
+
+    if (x != node->values[0]->vec) {
+        lvec_del(x);
+    }
+    if (y != node->values[1]->vec) {
+        lvec_del(y);
+    }
+    lval_del(node);
+
+    return result ? lval_vec(result) : lval_err("Division by zero");
+}
+
+lval* builtin_vec_add(lenv* env, lval* node) { return builtin_vec_op(env, node, "v+", '+'); }
+lval* builtin_vec_sub(lenv* env, lval* node) { return builtin_vec_op(env, node, "v-", '-'); }
+lval* builtin_vec_mul(lenv* env, lval* node) { return builtin_vec_op(env, node, "v*", '*'); }
+lval* builtin_vec_div(lenv* env, lval* node) { return builtin_vec_op(env, node, "v/", '/'); }
+lval* builtin_vec_mod(lenv* env, lval* node) { return builtin_vec_op(env, node, "v%", '%'); }
+
+/**
+ * Compare each pair of items of two vectors, or of a vector and a number.
+ *
+ * \param env       The environment.
+ * \param node      The operands.
+ * \param name      The name of the comparison.
+ * \param orders    The #lvec_order of the items accepted by the comparison.
+ *
+ * \returns An integer vector, 1 where the items are ordered and 0 otherwise.
+ */
+static lval* builtin_vec_ord(lenv* env, lval* node, char* name, int orders) {
+    UNUSED(env);
+
+    lval* error = check_operands(name, node);
+    if (error) {
+        return error;
+    }
+
+    lvec* x = operand(node->values[0]);
+    lvec* y = operand(node->values[1]);
+    lvec* result = lvec_compare(x, y, orders);
+
+    if (x != node->values[0]->vec) {
+        lvec_del(x);
+    }
+    if (y != node->values[1]->vec) {
+        lvec_del(y);
+    }
+    lval_del(node);
+
+    return lval_vec(result);
+}
+
+lval* builtin_vec_lt(lenv* env, lval* node) { return builtin_vec_ord(env, node, "v<", LVEC_LT); }
+lval* builtin_vec_gt(lenv* env, lval* node) { return builtin_vec_ord(env, node, "v>", LVEC_GT); }
+lval* builtin_vec_eq(lenv* env, lval* node) { return builtin_vec_ord(env, node, "v==", LVEC_EQ); }
+
+lval* builtin_vec_le(lenv* env, lval* node) {
+    return builtin_vec_ord(env, node, "v<=", LVEC_LT | LVEC_EQ);
+}
+
+lval* builtin_vec_ge(lenv* env, lval* node) {
+    return builtin_vec_ord(env, node, "v>=", LVEC_GT | LVEC_EQ);
+}
+
+lval* builtin_vec_ne(lenv* env, lval* node) {
+    return builtin_vec_ord(env, node, "v!=", LVEC_LT | LVEC_GT);
+}
+
+lval* builtin_vec(lenv* env, lval* node) {
+    UNUSED(env);
+
+    // The items are either the arguments or the items of a single list
+    lval* items = node;
+    if (node->count == 1 && node->values[0]->type == LVAL_QEXPR) {
+        items = node->values[0];
+    }
+
+    bool integers = true;
+    for_item(items, {
+        LASSERT(node, lval_is_number(item),
+                "Function 'vec' passed incorrect argument types. Expected number, got %s.",
+                lval_str_type(item->type));
+        integers &= item->type == LVAL_INT;
+    });
+
+    lvec* vec = lvec_new(integers, items->count);
+    for_item(items, {
+        if (integers) {
+            vec->ints[i] = item->integer;
+        } else {
+            vec->floats[i] = FLOAT_VALUE(item);
+        }
+    });
+
+    lval_del(node);
+    return lval_vec(vec);
+}
+
+/// Create a number from an item of a vector.
+static lval* vec_item(lvec* vec, size_t index) {
+    return vec->integers ? lval_int(vec->ints[index]) : lval_num(vec->floats[index]);
+}
+
+lval* builtin_vec_list(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("vec-list", node, 1);
+    LASSERT_ARG_TYPE("vec-list", node, 0, LVAL_VEC);
+
+    lvec* vec = node->values[0]->vec;
+    lval** values = xmalloc(LVAL_PTR_SIZE * (vec->count + 1));
+    for (size_t i = 0; i < vec->count; i++) {
+        values[i] = vec_item(vec, i);
+    }
+
+    lval* list = lval_sexpr_from(values, vec->count);
+    list->type = LVAL_QEXPR;
+    xfree(values);
+
+    lval_del(node);
+    return list;
+}
+
+lval* builtin_vec_len(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("vec-len", node, 1);
+    LASSERT_ARG_TYPE("vec-len", node, 0, LVAL_VEC);
+
+    lval* count = lval_int((PRECISION_INT) node->values[0]->vec->count);
+    lval_del(node);
+
+    return count;
+}
+
+lval* builtin_vec_get(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("vec-get", node, 2);
+    LASSERT_ARG_TYPE("vec-get", node, 0, LVAL_VEC);
+    LASSERT_ARG_TYPE("vec-get", node, 1, LVAL_INT);
+
+    lvec* vec = node->values[0]->vec;
+    PRECISION_INT index = node->values[1]->integer;
+
+    LASSERT(node, index >= 0 && (uint64_t) index < vec->count,
+            "Function 'vec-get' passed index %lld out of range, the vector has %zu items.",
+            (long long) index, vec->count);
+
+    lval* item = vec_item(vec, (size_t) index);
+    lval_del(node);
+
+    return item;
+}
+
+lval* builtin_vec_slice(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("vec-slice", node, 3);
+    LASSERT_ARG_TYPE("vec-slice", node, 0, LVAL_VEC);
+    LASSERT_ARG_TYPE("vec-slice", node, 1, LVAL_INT);
+    LASSERT_ARG_TYPE("vec-slice", node, 2, LVAL_INT);
+
+    lvec* vec = node->values[0]->vec;
+    PRECISION_INT start = node->values[1]->integer;
+    PRECISION_INT end   = node->values[2]->integer;
+
+    LASSERT(node, start >= 0 && start <= end && (uint64_t) end <= vec->count,
+            "Function 'vec-slice' passed range [%lld, %lld) out of range, the vector has %zu items.",
+            (long long) start, (long long) end, vec->count);
+
+    lvec* slice = lvec_slice(vec, (size_t) start, (size_t) end);
+    lval_del(node);
+
+    return lval_vec(slice);
+}
+
+/**
+ * Add up the items (or their products) of integer vectors with big integers,
+ * when the sum doesn't fit #PRECISION_INT.
+ *
+ * \param x The items.
+ * \param y The factors of the items or `NULL`.
+ *
+ * \returns The sum.
+ */
+static lval* big_sum(lvec* x, lvec* y) {
+    lbig* sum = lbig_from_int(0);
+
+    for (size_t i = 0; i < x->count; i++) {
+        lbig* item = lbig_from_int(x->ints[i]);
+
+        if (y) {
+            lbig* factor = lbig_from_int(y->ints[i]);
+            lbig* product = lbig_mul(item, factor);
+            lbig_del(factor);
+            lbig_del(item);
+            item = product;
+        }
+
+        lbig* next = lbig_add(sum, item);
+        lbig_del(sum);
+        lbig_del(item);
+        sum = next;
+    }
+
+    return lval_big(sum);
+}
+
+lval* builtin_vec_sum(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("vec-sum", node, 1);
+    LASSERT_ARG_TYPE("vec-sum", node, 0, LVAL_VEC);
+
+    lvec* vec = node->values[0]->vec;
+    lval* sum;
+
+    if (vec->integers) {
+        PRECISION_INT result;
+        sum = lvec_int_sum(vec, &result) ? lval_int(result) : big_sum(vec, NULL);
+    } else {
+        sum = lval_num(lvec_float_sum(vec));
+    }
+
+    lval_del(node);
+    return sum;
+}
+
+lval* builtin_vec_dot(lenv* env, lval* node) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT("vec-dot", node, 2);
+    LASSERT_ARG_TYPE("vec-dot", node, 0, LVAL_VEC);
+    LASSERT_ARG_TYPE("vec-dot", node, 1, LVAL_VEC);
+
+    lvec* x = node->values[0]->vec;
+    lvec* y = node->values[1]->vec;
+
+    LASSERT(node, x->count == y->count,
+            "Function 'vec-dot' passed vectors of different lengths: %zu and %zu.",
+            x->count, y->count);
+
+    lval* dot;
+
+    if (x->integers && y->integers) {
+        PRECISION_INT result;
+        dot = lvec_int_dot(x, y, &result) ? lval_int(result) : big_sum(x, y);
+    } else {
+        dot = lval_num(lvec_float_dot(x, y));
+    }
+
+    lval_del(node);
+    return dot;
+}
+
+/**
+ * Get the smallest or the biggest item of a vector.
+ *
+ * \param env   The environment.
+ * \param node  The vector.
+ * \param name  The name of the function.
+ * \param max   Whether to get the biggest item.
+ *
+ * \returns The item.
+ */
+static lval* builtin_vec_extreme(lenv* env, lval* node, char* name, bool max) {
+    UNUSED(env);
+
+    LASSERT_ARG_COUNT(name, node, 1);
+    LASSERT_ARG_TYPE(name, node, 0, LVAL_VEC);
+
+    lvec* vec = node->values[0]->vec;
+    LASSERT(node, vec->count > 0, "Function '%s' passed empty vector.", name);
+
+    lval* item = vec_item(vec, lvec_extreme(vec, max));
+    lval_del(node);
+
+    return item;
+}
+
+lval* builtin_vec_min(lenv* env, lval* node) { return builtin_vec_extreme(env, node, "vec-min", false); }
+lval* builtin_vec_max(lenv* env, lval* node) { return builtin_vec_extreme(env, node, "vec-max", true); }
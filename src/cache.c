@@ -0,0 +1,689 @@
+#if ! defined _WIN32
+    // For realpath (an XSI extension), mkdir, mmap and getpid
+    #define _XOPEN_SOURCE 700
+
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <stdint.h>
+
+#include "utils.h"
+#include "symbol.h"
+#include "lenv.h"
+#include "cache.h"
+
+
+/// The magic bytes at the beginning of an entry.
+#define CACHE_MAGIC "MLISPCE3"
+
+/// The initial value of a FNV-1a hash.
+#define HASH_OFFSET 14695981039346656037ull
+
+/// The multiplier of a FNV-1a hash.
+#define HASH_PRIME 1099511628211ull
+
+/// The tags of the encoded values.
+typedef enum ctag {
+    CACHE_SEXPR,    ///< A S-Expression: its length and items.
+    CACHE_QEXPR,    ///< A Q-Expression: its length and items.
+    CACHE_SYM,      ///< A symbol: its index in the symbol table.
+    CACHE_INT,      ///< An integer: zigzag encoded.
+    CACHE_BIG,      ///< A big integer: the length and decimal digits.
+    CACHE_NUM,      ///< A float number: its 8 bytes.
+    CACHE_STR       ///< A string: its length and characters.
+} ctag;
+
+/// Map an interned name to its index in the symbol table.
+KHASH_MAP_INIT_INT64(cache, size_t)
+
+/// A growable buffer holding an encoded entry.
+typedef struct cbuffer {
+    char* data;         ///< The bytes.
+    size_t length;      ///< The number of bytes.
+    size_t capacity;    ///< The number of bytes that fit in.
+} cbuffer;
+
+/// The state of decoding an entry.
+typedef struct ccursor {
+    unsigned char* pos; ///< The next byte to decode.
+    unsigned char* end; ///< The end of the entry.
+    char** symbols;     ///< The interned names of the symbol table.
+    size_t symbol_count;///< The number of symbols.
+} ccursor;
+
+/// An entry of the cache being read or written (see #cache_open).
+struct lcache {
+    char* key;          ///< The path, modification time, size and hash of
+                        ///< the file.
+    char* filename;     ///< The file of the entry.
+
+    // Reading
+    bool hit;           ///< Whether the entry matches the file.
+    unsigned char* data;///< The contents of the entry.
+    ccursor cursor;     ///< The next expression to decode.
+    size_t remaining;   ///< The number of expressions not decoded yet.
+
+    // Writing
+    bool encodable;     ///< Whether all expressions could be encoded.
+    size_t count;       ///< The number of expressions encoded.
+    cbuffer body;       ///< The encoded expressions.
+    cbuffer names;      ///< The names of the symbol table.
+    khash_t(cache)* symbols; ///< The index of each symbol name.
+};
+
+/// Whether loaded files are cached.
+static bool enabled = false;
+
+/// The statistics of the cache.
+static cache_stats stats = {0, 0, 0};
+
+
+/// Continue a FNV-1a hash with `length` bytes.
+static uint64_t hash_bytes(uint64_t hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char) data[i]) * HASH_PRIME;
+    }
+
+    return hash;
+}
+
+/// Append bytes to a buffer.
+static void put_bytes(cbuffer* buffer, const void* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    if (buffer->length + length > buffer->capacity) {
+        buffer->capacity = 2 * (buffer->length + length);
+        buffer->data = xrealloc(buffer->data, buffer->capacity);
+    }
+
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+/// Append an unsigned number, 7 bits per byte.
+static void put_varint(cbuffer* buffer, uint64_t value) {
+    unsigned char bytes[10];
+    size_t n = 0;
+
+    do {
+        bytes[n++] = (unsigned char) ((value & 0x7f) | (value > 0x7f ? 0x80 : 0));
+        value >>= 7;
+    } while (value);
+
+    put_bytes(buffer, bytes, n);
+}
+
+/// Append a tag followed by a number.
+static void put_tagged(cbuffer* buffer, ctag tag, uint64_t value) {
+    unsigned char byte = (unsigned char) tag;
+    put_bytes(buffer, &byte, 1);
+    put_varint(buffer, value);
+}
+
+/**
+ * Encode a value read from a file.
+ *
+ * \param buffer    The buffer to append to.
+ * \param symbols   The index of each symbol encoded so far.
+ * \param names     The buffer of the symbol table.
+ * \param node      The value.
+ *
+ * \returns Whether the value could be encoded (it contains no functions or
+ *          errors).
+ */
+static bool encode(cbuffer* buffer, khash_t(cache)* symbols, cbuffer* names, lval* node) {
+    switch (node->type) {
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            put_tagged(buffer, node->type == LVAL_SEXPR ? CACHE_SEXPR : CACHE_QEXPR,
+                       node->count);
+
+            for_item(node, {
+                if (!encode(buffer, symbols, names, item)) {
+                    return false;
+                }
+            });
+            return true;
+        case LVAL_SYM: {
+            int ret;
+            khiter_t k = kh_put(cache, symbols, (khint64_t) (uintptr_t) node->sym, &ret);
+            if (ret != 0) {
+                kh_value(symbols, k) = kh_size(symbols) - 1;
+                put_bytes(names, node->sym, strlen(node->sym) + 1);
+            }
+
+            put_tagged(buffer, CACHE_SYM, kh_value(symbols, k));
+            return true;
+        }
+        case LVAL_INT:
+            put_tagged(buffer, CACHE_INT,
+                       ((uint64_t) node->integer << 1) ^ (uint64_t) (node->integer >> 63));
+            return true;
+        case LVAL_BIG: {
+            char* digits = lbig_to_str(node->big);
+            size_t length = strlen(digits);
+            put_tagged(buffer, CACHE_BIG, length);
+            put_bytes(buffer, digits, length);
+            xfree(digits);
+            return true;
+        }
+        case LVAL_NUM: {
+            unsigned char byte = CACHE_NUM;
+            put_bytes(buffer, &byte, 1);
+            put_bytes(buffer, &node->num, sizeof(node->num));
+            return true;
+        }
+        case LVAL_STR: {
+            put_tagged(buffer, CACHE_STR, node->length);
+            put_bytes(buffer, node->str, node->length);
+            return true;
+        }
+        case LVAL_FUNC:
+        case LVAL_VEC:
+        case LVAL_SEQ:
+        case LVAL_DICT:
+        case LVAL_SET:
+        case LVAL_ARRAY:
+        case LVAL_ERR:
+        default:
+            return false;
+    }
+}
+
+/// Decode an unsigned number, `false` if it's truncated.
+static bool get_varint(ccursor* cursor, uint64_t* value) {
+    *value = 0;
+
+    for (unsigned shift = 0; cursor->pos < cursor->end && shift < 64; shift += 7) {
+        unsigned char byte = *cursor->pos++;
+        *value |= (uint64_t) (byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Skip a value without decoding it.
+ *
+ * \returns Whether the value is valid.
+ */
+static bool skip(ccursor* cursor) {
+    if (cursor->pos >= cursor->end) {
+        return false;
+    }
+
+    ctag tag = (ctag) *cursor->pos++;
+    uint64_t value;
+
+    if (tag == CACHE_NUM) {
+        if ((size_t) (cursor->end - cursor->pos) < sizeof(PRECISION_FLOAT)) {
+            return false;
+        }
+
+        cursor->pos += sizeof(PRECISION_FLOAT);
+        return true;
+    }
+
+    if (!get_varint(cursor, &value)) {
+        return false;
+    }
+
+    switch (tag) {
+        case CACHE_SEXPR:
+        case CACHE_QEXPR:
+            for (uint64_t i = 0; i < value; i++) {
+                if (!skip(cursor)) {
+                    return false;
+                }
+            }
+            return true;
+        case CACHE_SYM:
+            return value < cursor->symbol_count;
+        case CACHE_INT:
+            return true;
+        case CACHE_BIG:
+            if (value > (uint64_t) (cursor->end - cursor->pos)) {
+                return false;
+            }
+
+            // Only digits with an optional sign, see lbig_from_str
+            for (uint64_t i = 0; i < value; i++) {
+                char c = (char) cursor->pos[i];
+                if (!(c >= '0' && c <= '9') && !(c == '-' && i == 0 && value > 1)) {
+                    return false;
+                }
+            }
+
+            cursor->pos += value;
+            return value > 0;
+        case CACHE_STR:
+            if (value > (uint64_t) (cursor->end - cursor->pos)) {
+                return false;
+            }
+
+            cursor->pos += value;
+            return true;
+        case CACHE_NUM:
+        default:
+            return false;
+    }
+}
+
+/// Decode a value checked by #skip.
+static lval* decode(ccursor* cursor) {
+    ctag tag = (ctag) *cursor->pos++;
+    uint64_t value;
+    lval* node;
+
+    if (tag == CACHE_NUM) {
+        PRECISION_FLOAT num;
+        memcpy(&num, cursor->pos, sizeof(num));
+        cursor->pos += sizeof(num);
+        return lval_num(num);
+    }
+
+    get_varint(cursor, &value);
+
+    switch (tag) {
+        case CACHE_SEXPR:
+        case CACHE_QEXPR:
+            node = tag == CACHE_SEXPR ? lval_sexpr() : lval_qexpr();
+            for (uint64_t i = 0; i < value; i++) {
+                node = lval_add(node, decode(cursor));
+            }
+            return node;
+        case CACHE_SYM:
+            // The name is interned already
+            node = lval_new();
+            node->type = LVAL_SYM;
+            node->sym  = cursor->symbols[value];
+            return node;
+        case CACHE_INT:
+            return lval_int((PRECISION_INT) ((value >> 1) ^ (~(value & 1) + 1)));
+        case CACHE_BIG:
+            node = lval_big(lbig_from_str((char*) cursor->pos, value));
+            cursor->pos += value;
+            return node;
+        case CACHE_STR:
+            node = lval_str_len((char*) cursor->pos, value);
+            cursor->pos += value;
+            return node;
+        case CACHE_NUM:
+        default:
+            ASSERTF(0, "Invalid cache tag: %i", tag);
+            return NULL;
+    }
+}
+
+void cache_set_enabled(bool value) {
+    enabled = value;
+}
+
+#if ! defined _WIN32
+
+/// Create a directory if it doesn't exist yet.
+static bool make_dir(char* path) {
+    struct stat info;
+    return mkdir(path, 0755) == 0 || (stat(path, &info) == 0 && S_ISDIR(info.st_mode));
+}
+
+/**
+ * Get the name of the entry of a file, creating the cache directory.
+ *
+ * \param path  The absolute path of the file.
+ *
+ * \returns The file name or `NULL` if there is no cache directory. Has to be
+ *          freed with `xfree`!
+ */
+static char* entry_filename(char* path) {
+    char* dir = getenv("MLISP_CACHE_DIR");
+    char* base = NULL;
+
+    if (dir == NULL || *dir == '\0') {
+        if ((dir = getenv("XDG_CACHE_HOME")) != NULL && *dir != '\0') {
+            base = strdup(dir);
+        } else if ((dir = getenv("HOME")) != NULL && *dir != '\0') {
+            base = xsprintf("%s/.cache", dir);
+        } else {
+            return NULL;
+        }
+
+        if (!make_dir(base)) {
+            xfree(base);
+            return NULL;
+        }
+
+        dir = xsprintf("%s/mlisp", base);
+        xfree(base);
+    } else {
+        dir = strdup(dir);
+    }
+
+    char* filename = NULL;
+    if (make_dir(dir)) {
+        unsigned long long hash = hash_bytes(HASH_OFFSET, path, strlen(path));
+        filename = xsprintf("%s/%016llx.mlc", dir, hash);
+    }
+
+    xfree(dir);
+    return filename;
+}
+
+/**
+ * Get the key of a file.
+ *
+ * \returns The key or `NULL` if the file can't be cached. Has to be freed
+ *          with `xfree`!
+ */
+static char* file_key(char* path) {
+    // Don't open FIFOs and devices, they would block or be consumed
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size > CACHE_MAX_FILE_SIZE) {
+        return NULL;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    char* key = NULL;
+    dev_t device = info.st_dev;
+    ino_t inode  = info.st_ino;
+
+    // The path may have been replaced in the meantime
+    if (fstat(fileno(file), &info) == 0 && S_ISREG(info.st_mode)
+            && info.st_dev == device && info.st_ino == inode
+            && info.st_size <= CACHE_MAX_FILE_SIZE) {
+        size_t size = (size_t) info.st_size;
+        void* mapping = NULL;
+
+        if (size > 0) {
+            mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        }
+
+        if (mapping != MAP_FAILED) {
+            uint64_t hash = hash_bytes(HASH_OFFSET, mapping, mapping ? size : 0);
+            key = xsprintf("%s\n%lld\n%zu\n%016llx", path, (long long) info.st_mtime,
+                           size, (unsigned long long) hash);
+        }
+
+        if (mapping && mapping != MAP_FAILED) {
+            munmap(mapping, size);
+        }
+    }
+
+    fclose(file);
+    return key;
+}
+
+/// Read a whole file, `NULL` if it can't be read.
+static unsigned char* read_file(char* filename, size_t* size) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    struct stat info;
+    unsigned char* data = NULL;
+
+    if (fstat(fileno(file), &info) == 0 && S_ISREG(info.st_mode)) {
+        *size = (size_t) info.st_size;
+        data  = xmalloc(*size + 1);
+
+        if (fread(data, 1, *size, file) != *size) {
+            xfree(data);
+            data = NULL;
+        }
+    }
+
+    fclose(file);
+    return data;
+}
+
+/**
+ * Check an entry and prepare decoding its expressions.
+ *
+ * An entry starts with #CACHE_MAGIC, followed by the length and characters
+ * of its key and a hash of the rest of the entry: the size of the symbol
+ * table, the names of the symbols (each terminated by `\0`), the number of
+ * expressions and finally the encoded expressions.
+ *
+ * \returns Whether the entry is valid and has the key of the file.
+ */
+static bool read_entry(lcache* cache, size_t size) {
+    ccursor* cursor = &cache->cursor;
+    cursor->pos = cache->data;
+    cursor->end = cache->data + size;
+
+    uint64_t length;
+    size_t magic = strlen(CACHE_MAGIC);
+
+    if (size < magic || memcmp(cursor->pos, CACHE_MAGIC, magic) != 0) {
+        return false;
+    }
+    cursor->pos += magic;
+
+    if (!get_varint(cursor, &length) || length != strlen(cache->key)
+            || (uint64_t) (cursor->end - cursor->pos) < length
+            || memcmp(cursor->pos, cache->key, length) != 0) {
+        return false;
+    }
+    cursor->pos += length;
+
+    // Detect damaged entries
+    uint64_t hash;
+    if ((size_t) (cursor->end - cursor->pos) < sizeof(hash)) {
+        return false;
+    }
+    memcpy(&hash, cursor->pos, sizeof(hash));
+    cursor->pos += sizeof(hash);
+
+    if (hash != hash_bytes(HASH_OFFSET, (char*) cursor->pos, (size_t) (cursor->end - cursor->pos))) {
+        return false;
+    }
+
+    if (!get_varint(cursor, &length) || (uint64_t) (cursor->end - cursor->pos) < length
+            || (length > 0 && cursor->pos[length - 1] != '\0')) {
+        return false;
+    }
+
+    // Intern every name once
+    char* names = (char*) cursor->pos;
+    char* end   = names + length;
+    cursor->pos += length;
+
+    for (char* name = names; name < end; name += strlen(name) + 1) {
+        cursor->symbol_count++;
+    }
+
+    cursor->symbols = xmalloc(sizeof(char*) * (cursor->symbol_count + 1));
+    cursor->symbol_count = 0;
+    for (char* name = names; name < end; name += strlen(name) + 1) {
+        cursor->symbols[cursor->symbol_count++] = symbol_intern(name);
+    }
+
+    if (!get_varint(cursor, &length)) {
+        return false;
+    }
+
+    // Check all expressions before the first one is evaluated
+    unsigned char* first = cursor->pos;
+    for (uint64_t i = 0; i < length; i++) {
+        if (!skip(cursor)) {
+            return false;
+        }
+    }
+
+    if (cursor->pos != cursor->end) {
+        return false;
+    }
+
+    cursor->pos = first;
+    cache->remaining = length;
+
+    return true;
+}
+
+lcache* cache_open(char* filename) {
+    ASSERT_NOT_NULL(filename);
+
+    if (!enabled) {
+        return NULL;
+    }
+
+    char* path = realpath(filename, NULL);
+    if (path == NULL) {
+        return NULL;
+    }
+
+    char* key = file_key(path);
+    char* entry = key ? entry_filename(path) : NULL;
+    free(path);
+
+    if (entry == NULL) {
+        if (key) xfree(key);
+        return NULL;
+    }
+
+    lcache* cache = xmalloc(sizeof(lcache));
+    cache->key       = key;
+    cache->filename  = entry;
+    cache->hit       = false;
+    cache->cursor    = (ccursor) {NULL, NULL, NULL, 0};
+    cache->remaining = 0;
+    cache->encodable = true;
+    cache->count     = 0;
+    cache->body      = (cbuffer) {NULL, 0, 0};
+    cache->names     = (cbuffer) {NULL, 0, 0};
+    cache->symbols   = NULL;
+
+    size_t size;
+    cache->data = read_file(entry, &size);
+    cache->hit  = cache->data && read_entry(cache, size);
+
+    if (cache->hit) {
+        stats.hits++;
+    } else {
+        stats.misses++;
+        cache->symbols = kh_init(cache);
+    }
+
+    return cache;
+}
+
+/// Write the expressions encoded to the entry.
+static void write_entry(lcache* cache) {
+    cbuffer header = {NULL, 0, 0};
+    put_bytes(&header, CACHE_MAGIC, strlen(CACHE_MAGIC));
+    put_varint(&header, strlen(cache->key));
+    put_bytes(&header, cache->key, strlen(cache->key));
+
+    // The symbol table and the number of expressions precede them
+    cbuffer table = {NULL, 0, 0};
+    put_varint(&table, cache->names.length);
+    put_bytes(&table, cache->names.data, cache->names.length);
+    put_varint(&table, cache->count);
+
+    uint64_t hash = hash_bytes(HASH_OFFSET, table.data, table.length);
+    hash = hash_bytes(hash, cache->body.data, cache->body.length);
+    put_bytes(&header, &hash, sizeof(hash));
+
+    // Replace the entry at once, other processes may be reading it
+    char* temp = xsprintf("%s.%ld", cache->filename, (long) getpid());
+    FILE* file = fopen(temp, "wb");
+
+    bool written = file
+        && fwrite(header.data, 1, header.length, file) == header.length
+        && fwrite(table.data, 1, table.length, file) == table.length
+        && fwrite(cache->body.data, 1, cache->body.length, file) == cache->body.length;
+
+    if (file && fclose(file) == 0 && written && rename(temp, cache->filename) == 0) {
+        stats.writes++;
+    } else if (file) {
+        remove(temp);
+    }
+
+    xfree(header.data);
+    xfree(table.data);
+    xfree(temp);
+}
+
+#else
+
+lcache* cache_open(char* filename) {
+    UNUSED(filename);
+    UNUSED(skip);
+    return NULL;
+}
+
+static void write_entry(lcache* cache) {
+    UNUSED(cache);
+}
+
+#endif
+
+bool cache_hit(lcache* cache) {
+    ASSERT_NOT_NULL(cache);
+
+    return cache->hit;
+}
+
+lval* cache_next(lcache* cache) {
+    ASSERT_NOT_NULL(cache);
+
+    if (!cache->hit || cache->remaining == 0) {
+        return NULL;
+    }
+
+    cache->remaining--;
+    return decode(&cache->cursor);
+}
+
+void cache_add(lcache* cache, lval* expr) {
+    ASSERT_NOT_NULL(cache);
+    ASSERT_NOT_NULL(expr);
+
+    if (cache->hit || !cache->encodable) {
+        return;
+    }
+
+    cache->encodable = encode(&cache->body, cache->symbols, &cache->names, expr);
+    cache->count++;
+}
+
+void cache_close(lcache* cache, bool save) {
+    ASSERT_NOT_NULL(cache);
+
+    if (save && !cache->hit && cache->encodable) {
+        write_entry(cache);
+    }
+
+    if (cache->symbols) kh_destroy(cache, cache->symbols);
+    if (cache->cursor.symbols) xfree(cache->cursor.symbols);
+    if (cache->data) xfree(cache->data);
+    if (cache->body.data) xfree(cache->body.data);
+    if (cache->names.data) xfree(cache->names.data);
+    xfree(cache->key);
+    xfree(cache->filename);
+    xfree(cache);
+}
+
+void cache_get_stats(cache_stats* result) {
+    ASSERT_NOT_NULL(result);
+    *result = stats;
+}
+
+void cache_print_stats(void) {
+    printf("Files loaded from the cache:   %zu\n", stats.hits);
+    printf("Files read without the cache:  %zu\n", stats.misses);
+    printf("Cache entries written:         %zu\n", stats.writes);
+}
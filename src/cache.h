@@ -0,0 +1,110 @@
+/**
+ * \file    cache.h
+ * \brief   Caches the expressions read from files by `load`.
+ *
+ * When a file is loaded, its expressions are saved in the cache directory
+ * in a compact binary encoding, so loading the same file again doesn't need
+ * the reader. Symbol names are stored once per file and interned once when
+ * the entry is loaded, numbers and strings are stored as they are in memory.
+ * The cache directory is `$MLISP_CACHE_DIR` or `mlisp` in `$XDG_CACHE_HOME`
+ * (`~/.cache` by default).
+ *
+ * Each file has one entry, named by a hash of its absolute path. An entry is
+ * only used if its key matches: the path, modification time, size and a
+ * hash of the contents of the file when it was saved. Files with syntax
+ * errors and files bigger than #CACHE_MAX_FILE_SIZE aren't cached. Entries
+ * are written to a temporary file first and renamed, so processes loading
+ * the same files at the same time never see partial entries.
+ *
+ * The cache is disabled by default, the interpreter enables it unless it's
+ * started with `--no-cache`.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stdbool.h>
+    #include <stddef.h>
+#endif
+
+#include "config.h"
+#include "lval.h"
+
+
+/// An entry of the cache being read or written (see #cache_open).
+typedef struct lcache lcache;
+
+/// Statistics of the cache.
+typedef struct cache_stats {
+    size_t hits;        ///< The number of files loaded from the cache.
+    size_t misses;      ///< The number of files read without the cache.
+    size_t writes;      ///< The number of entries written.
+} cache_stats;
+
+
+/**
+ * Enable or disable the cache.
+ *
+ * \param enabled   Whether loaded files are cached.
+ */
+void cache_set_enabled(bool enabled);
+
+/**
+ * Open the entry of a file.
+ *
+ * Reads the whole file to hash its contents. If the entry matches, its
+ * expressions can be read with #cache_next. Otherwise the expressions read
+ * from the file can be added with #cache_add to replace the entry.
+ *
+ * \param filename  The file.
+ *
+ * \returns The entry or `NULL` if the file can't be cached or the cache is
+ *          disabled. Has to be closed with #cache_close!
+ */
+lcache* cache_open(char* filename);
+
+/**
+ * Check whether an entry matches its file.
+ *
+ * \param cache The entry.
+ */
+bool cache_hit(lcache* cache);
+
+/**
+ * Decode the next expression of a matching entry.
+ *
+ * \param cache The entry.
+ *
+ * \returns The expression or `NULL` after the last one.
+ */
+lval* cache_next(lcache* cache);
+
+/**
+ * Add the next expression read from the file to an entry.
+ *
+ * Does nothing if the entry matches.
+ *
+ * \param cache The entry.
+ * \param expr  The expression, it's encoded immediately and not modified.
+ */
+void cache_add(lcache* cache, lval* expr);
+
+/**
+ * Close an entry.
+ *
+ * \param cache The entry.
+ * \param save  Whether to save the expressions added (if all of the file has
+ *              been read without errors).
+ */
+void cache_close(lcache* cache, bool save);
+
+/**
+ * Get the statistics of the cache.
+ *
+ * \param result    [out] The statistics.
+ */
+void cache_get_stats(cache_stats* result);
+
+/**
+ * Print the statistics of the cache.
+ */
+void cache_print_stats(void);
@@ -0,0 +1,271 @@
+#include "utils.h"
+#include "symbol.h"
+#include "compiler.h"
+
+
+/**
+ * Compile an expression that is evaluated as S-Expression.
+ *
+ * \param code  The code to append to.
+ * \param expr  The list to compile.
+ * \param tail  Whether the expression is in tail position.
+ */
+void compile_sexpr(lcode* code, lval* expr, bool tail);
+
+
+/// Append an instruction and return its position.
+static size_t emit(lcode* code, lopcode op, size_t arg) {
+    ASSERTF(arg < (1u << (32 - LCODE_OP_BITS)), "operand %zu too big", arg);
+
+    code->count++;
+    code->ops = xrealloc(code->ops, sizeof(uint32_t) * code->count);
+    code->ops[code->count - 1] = (uint32_t) op | (uint32_t) (arg << LCODE_OP_BITS);
+
+    return code->count - 1;
+}
+
+/// Set the operand of the instruction at `pos` to the current position.
+static void patch(lcode* code, size_t pos) {
+    lopcode op = LCODE_OP(code->ops[pos]);
+    code->ops[pos] = (uint32_t) op | (uint32_t) (code->count << LCODE_OP_BITS);
+}
+
+/// Add a value to the constant pool and return its index.
+static size_t constant(lcode* code, lval* value) {
+    code->const_count++;
+    code->constants = xrealloc(code->constants, LVAL_PTR_SIZE * code->const_count);
+    code->constants[code->const_count - 1] = lval_ref(value);
+
+    return code->const_count - 1;
+}
+
+/// Compile a symbol reference, resolving formal arguments to their slot.
+static void compile_sym(lcode* code, lval* node) {
+    if (code->formals && node->sym != symbol_intern("...")) {
+        // Later formals shadow earlier ones, like in the frame
+        for (size_t i = code->formals->count; i-- > 0;) {
+            if (code->formals->values[i]->sym == node->sym) {
+                emit(code, OP_LOCAL, i);
+                return;
+            }
+        }
+    }
+
+    emit(code, OP_LOAD, constant(code, node));
+}
+
+/// Compile a single element of an S-Expression.
+static void compile_expr(lcode* code, lval* node) {
+    switch (node->type) {
+        case LVAL_SYM:   compile_sym(code, node); break;
+        case LVAL_SEXPR: compile_sexpr(code, node, false); break;
+
+        // Everything else evaluates to itself
+        case LVAL_QEXPR:
+        case LVAL_INT:
+        case LVAL_BIG:
+        case LVAL_NUM:
+        case LVAL_VEC:
+        case LVAL_SEQ:
+        case LVAL_DICT:
+        case LVAL_SET:
+        case LVAL_ARRAY:
+        case LVAL_STR:
+        case LVAL_ERR:
+        case LVAL_FUNC:
+            emit(code, OP_CONST, constant(code, node));
+            break;
+        default:
+            ASSERTF(0, "Invalid lval type: %i", node->type);
+    }
+}
+
+/**
+ * Compile `(if cond {then} {else})` with jumps instead of a call.
+ *
+ * \returns Whether the expression is an `if` with literal branches.
+ */
+static bool compile_if(lcode* code, lval* expr, bool tail) {
+    if (expr->count < 3 || expr->count > 4
+            || expr->values[0]->type != LVAL_SYM
+            || expr->values[0]->sym != symbol_intern("if")) {
+        return false;
+    }
+
+    for (size_t i = 2; i < expr->count; i++) {
+        if (expr->values[i]->type != LVAL_QEXPR) {
+            return false;
+        }
+    }
+
+    compile_expr(code, expr->values[0]);
+    compile_expr(code, expr->values[1]);
+
+    size_t if_pos = emit(code, OP_IF, 0);
+    size_t else_pos = emit(code, OP_JUMP, 0);
+
+    // The branches are evaluated like S-Expressions
+    compile_sexpr(code, expr->values[2], tail);
+    size_t then_end = emit(code, OP_JUMP, 0);
+
+    patch(code, else_pos);
+    if (expr->count == 4) {
+        compile_sexpr(code, expr->values[3], tail);
+    } else {
+        lval* empty = lval_sexpr();
+        emit(code, OP_CONST, constant(code, empty));
+        lval_del(empty);
+    }
+    size_t else_end = emit(code, OP_JUMP, 0);
+
+    // `if` has been rebound: call it with the branches as arguments
+    patch(code, if_pos);
+    for (size_t i = 2; i < expr->count; i++) {
+        emit(code, OP_CONST, constant(code, expr->values[i]));
+    }
+    emit(code, tail ? OP_TAILCALL : OP_CALL, expr->count);
+
+    patch(code, then_end);
+    patch(code, else_end);
+
+    return true;
+}
+
+/**
+ * Compile `(and a b)` and `(or a b)` so that `b` is only evaluated if `a`
+ * doesn't decide the result.
+ *
+ * \returns Whether the expression is an `and` or `or` with two operands.
+ */
+static bool compile_logic(lcode* code, lval* expr, bool tail) {
+    if (expr->count != 3 || expr->values[0]->type != LVAL_SYM) {
+        return false;
+    }
+
+    lopcode op;
+    if (expr->values[0]->sym == symbol_intern("and")) {
+        op = OP_AND;
+    } else if (expr->values[0]->sym == symbol_intern("or")) {
+        op = OP_OR;
+    } else {
+        return false;
+    }
+
+    compile_expr(code, expr->values[0]);
+    compile_expr(code, expr->values[1]);
+    size_t skip_pos = emit(code, op, 0);
+
+    // Otherwise the builtin is called with both operands
+    compile_expr(code, expr->values[2]);
+    emit(code, tail ? OP_TAILCALL : OP_CALL, expr->count);
+
+    patch(code, skip_pos);
+
+    return true;
+}
+
+/**
+ * Compile `(quote expr)` to a constant.
+ *
+ * \returns Whether the expression is a `quote` with one operand.
+ */
+static bool compile_quote(lcode* code, lval* expr, bool tail) {
+    if (expr->count != 2 || expr->values[0]->type != LVAL_SYM
+            || expr->values[0]->sym != symbol_intern("quote")) {
+        return false;
+    }
+
+    compile_expr(code, expr->values[0]);
+    size_t quote_pos = emit(code, OP_QUOTE, 0);
+
+    // A quoted S-Expression is a Q-Expression (see #builtin_quote)
+    lval* quoted = lval_ref(expr->values[1]);
+    if (quoted->type == LVAL_SEXPR) {
+        quoted = lval_unshare(quoted);
+        quoted->type = LVAL_QEXPR;
+    }
+    emit(code, OP_CONST, constant(code, quoted));
+    lval_del(quoted);
+    size_t end = emit(code, OP_JUMP, 0);
+
+    // `quote` has been rebound: call it with the value of the operand
+    patch(code, quote_pos);
+    compile_expr(code, expr->values[1]);
+    emit(code, tail ? OP_TAILCALL : OP_CALL, expr->count);
+
+    patch(code, end);
+
+    return true;
+}
+
+void compile_sexpr(lcode* code, lval* expr, bool tail) {
+    ASSERTF(expr->type == LVAL_SEXPR || expr->type == LVAL_QEXPR, "can only compile lists");
+
+    if (expr->count == 0) {
+        // Empty expression
+        lval* empty = lval_sexpr();
+        emit(code, OP_CONST, constant(code, empty));
+        lval_del(empty);
+    } else if (expr->count == 1) {
+        // Single expression, a S-Expression stays in the same position
+        if (expr->values[0]->type == LVAL_SEXPR) {
+            compile_sexpr(code, expr->values[0], tail);
+        } else {
+            compile_expr(code, expr->values[0]);
+        }
+    } else if (!compile_if(code, expr, tail) && !compile_logic(code, expr, tail)
+               && !compile_quote(code, expr, tail)) {
+        for_item(expr, {
+            compile_expr(code, item);
+        });
+
+        emit(code, tail ? OP_TAILCALL : OP_CALL, expr->count);
+    }
+}
+
+lcode* lcode_compile(lval* expr) {
+    return lcode_compile_lambda(NULL, expr);
+}
+
+lcode* lcode_compile_lambda(lval* formals, lval* body) {
+    lcode* code = xmalloc(sizeof(lcode));
+    code->refcount    = 1;
+    code->ops         = NULL;
+    code->count       = 0;
+    code->constants   = NULL;
+    code->const_count = 0;
+    code->formals     = formals ? lval_ref(formals) : NULL;
+
+    compile_sexpr(code, body, true);
+    emit(code, OP_RETURN, 0);
+
+    return code;
+}
+
+lcode* lcode_ref(lcode* code) {
+    ASSERT_NOT_NULL(code);
+
+    code->refcount++;
+    return code;
+}
+
+void lcode_del(lcode* code) {
+    ASSERT_NOT_NULL(code);
+
+    if (--code->refcount > 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < code->const_count; i++) {
+        lval_del(code->constants[i]);
+    }
+
+    if (code->constants) {
+        xfree(code->constants);
+    }
+    if (code->formals) {
+        lval_del(code->formals);
+    }
+    xfree(code->ops);
+    xfree(code);
+}
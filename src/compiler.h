@@ -0,0 +1,120 @@
+/**
+ * \file    compiler.h
+ * \brief   Lowers expressions to bytecode for the VM (see vm.h).
+ *
+ * An expression is compiled to a sequence of 32 bit instructions for a stack
+ * machine. The lower 8 bits hold the opcode, the upper 24 bits its operand
+ * (a constant index, an argument count or a jump target). Values that don't
+ * need evaluation (numbers, strings, Q-Expressions, ...) are kept in a
+ * constant pool and are pushed by reference, so the expression tree is never
+ * copied or modified when it's run.
+ *
+ * When a lambda body is compiled, references to the lambda's formal arguments
+ * are resolved to their slot in the frame (see #lenv_new_frame). As mlisp is
+ * dynamically scoped, other symbols can only be resolved at runtime.
+ *
+ * Calls whose result is the result of the whole code (the last call, also in
+ * the branches of an `if`) are compiled as tail calls.
+ *
+ * The special forms `if`, `and`, `or` and `quote` (see #eval_sexpr) are
+ * compiled to jumps, so the operands that aren't needed are never evaluated.
+ * As the operator may have been rebound, the VM checks that it's still the
+ * builtin and falls back to a call otherwise.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stdint.h>
+#endif
+
+#include "lval.h"
+
+
+/// The opcodes of the VM.
+typedef enum lopcode {
+    OP_CONST,   ///< Push the constant `arg`.
+    OP_LOAD,    ///< Push the value of the symbol stored in constant `arg`.
+    OP_LOCAL,   ///< Push the value of the formal argument in slot `arg`.
+    OP_CALL,    ///< Call the function with `arg - 1` arguments on the stack.
+    OP_TAILCALL,///< Like #OP_CALL, but in tail position (see #eval_call).
+    OP_IF,      ///< If the stack holds the builtin `if` and a condition, pop
+                ///< both and continue on the next instruction but one if the
+                ///< condition is true or at the jump target stored in the next
+                ///< instruction otherwise. If `if` has been rebound, jump
+                ///< to `arg` to call it like any other function.
+    OP_AND,     ///< If the stack holds the builtin `and` and a number that
+                ///< is zero, replace both with 0 and continue at `arg`.
+                ///< Otherwise, continue on the next instruction to evaluate
+                ///< the second operand and call `and`.
+    OP_OR,      ///< Like #OP_AND, for the builtin `or` and a number that
+                ///< isn't zero, which is replaced by 1.
+    OP_QUOTE,   ///< If the stack holds the builtin `quote`, pop it and
+                ///< continue on the next instruction (pushing the quoted
+                ///< expression). Otherwise, jump to `arg` to call it.
+    OP_JUMP,    ///< Continue at `arg`.
+    OP_RETURN   ///< Return the value on top of the stack.
+} lopcode;
+
+/// The number of bits used by the opcode in an instruction.
+#define LCODE_OP_BITS 8
+
+/// Get the opcode of an instruction.
+#define LCODE_OP(instr) ((lopcode) ((instr) & ((1u << LCODE_OP_BITS) - 1)))
+
+/// Get the operand of an instruction.
+#define LCODE_ARG(instr) ((size_t) ((instr) >> LCODE_OP_BITS))
+
+/// A compiled expression.
+typedef struct lcode {
+    size_t refcount;        ///< The number of owners sharing this code.
+
+    uint32_t* ops;          ///< The instructions.
+    size_t count;           ///< The number of instructions.
+
+    lval** constants;       ///< The constant pool.
+    size_t const_count;     ///< The number of constants.
+
+    lval* formals;          ///< The formals resolved to slots or `NULL`.
+} lcode;
+
+
+/**
+ * Compile an expression.
+ *
+ * Compile a list-like object so that running it has the same effect as
+ * evaluating it as S-Expression (see #eval). The expression isn't modified,
+ * the code shares the parts it needs.
+ *
+ * \param expr  The S-Expression or Q-Expression to compile.
+ *
+ * \returns The compiled code. Has to be cleaned up with #lcode_del!
+ */
+lcode* lcode_compile(lval* expr);
+
+/**
+ * Compile the body of a lambda function.
+ *
+ * Like #lcode_compile, but references to the formal arguments load their
+ * slot directly. The code has to be run in a frame created for `formals`.
+ *
+ * \param formals   The formal arguments of the lambda.
+ * \param body      The Q-Expression to compile.
+ *
+ * \returns The compiled code. Has to be cleaned up with #lcode_del!
+ */
+lcode* lcode_compile_lambda(lval* formals, lval* body);
+
+/**
+ * Share compiled code.
+ *
+ * \param code  The code to share.
+ * \returns The same code.
+ */
+lcode* lcode_ref(lcode* code);
+
+/**
+ * Drop a reference to compiled code, delete it when it's the last one.
+ *
+ * \param code  The code to delete.
+ */
+void lcode_del(lcode* code);
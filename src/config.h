@@ -4,13 +4,44 @@
  */
 #pragma once
 
+#if ! defined MLISP_NOINCLUDE
+    #include <stdint.h>
+#endif
+
 #if ! defined NDEBUG
     /// DEBUG flag
     #define DEBUG 1
 #endif
 
+// Uncomment to release the memory of all temporaries after every
+// top-level evaluation (see lalloc_end_eval). Can be set with CMake, too.
+//#define ALLOC_ARENA
+
+// Uncomment to free memory with a tracing garbage collector instead of
+// reference counting (see gc.h). Can be set with CMake, too.
+//#define MLISP_GC
+
+/// The biggest file whose expressions are cached when it's loaded (see cache.h).
+#define CACHE_MAX_FILE_SIZE (16 * 1024 * 1024)
+
+/// The smallest integer shared by all integers with its value (see #lval_int).
+#define LVAL_SMALL_INT_MIN (-256)
+
+/// The biggest integer shared by all integers with its value (see #lval_int).
+#define LVAL_SMALL_INT_MAX 1024
+
+/// The number of digits (of 32 bits) from which big integers are multiplied
+/// with Karatsuba's method (see bignum.h).
+#define BIGNUM_KARATSUBA_THRESHOLD 32
+
 /// The precision of a float number.
 typedef double PRECISION_FLOAT;
 
 /// The precision of an integer number.
-typedef int    PRECISION_INT;
+typedef int64_t PRECISION_INT;
+
+/// The smallest integer, results below become big integers.
+#define PRECISION_INT_MIN INT64_MIN
+
+/// The biggest integer, results above become big integers.
+#define PRECISION_INT_MAX INT64_MAX
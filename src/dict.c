@@ -0,0 +1,380 @@
+#include <string.h>
+
+#include "utils.h"
+#include "alloc.h"
+#include "lval.h"
+#include "dict.h"
+
+/// An entry of a dictionary.
+typedef struct ldict_entry {
+    uint64_t hash;      ///< The hash of the key.
+    lval* key;          ///< The key.
+    lval* value;        ///< The value, `NULL` in sets.
+} ldict_entry;
+
+/**
+ * A node of the trie.
+ *
+ * The slots of a node are selected by five bits of the hashes, starting with
+ * the lowest bits at the root. Below the last level, a node holds entries
+ * with equal hashes, its maps are empty then.
+ */
+typedef struct ldict_node {
+    size_t refcount;        ///< The number of dictionaries and nodes sharing
+                            ///< this node.
+    uint32_t datamap;       ///< The slots holding an entry.
+    uint32_t nodemap;       ///< The slots holding a child.
+    uint32_t count;         ///< The number of entries.
+    uint32_t children;      ///< The number of children.
+    ldict_entry entries[];  ///< The entries, followed by the children (see
+                            ///< #CHILDREN), both in the order of their slots.
+} ldict_node;
+
+/// Get the children of a node.
+#define CHILDREN(node) ((ldict_node**) ((node)->entries + (node)->count))
+
+/// The number of bits of the hash used by each level.
+#define LEVEL_BITS 5
+
+/// Get the slot of a hash at a level.
+#define SLOT(hash, shift) ((uint32_t) 1 << (((hash) >> (shift)) & 31))
+
+/// Get the index of a slot among the used ones.
+static inline size_t index_of(uint32_t map, uint32_t slot) {
+#if defined __GNUC__
+    return (size_t) __builtin_popcount(map & (slot - 1));
+#else
+    uint32_t bits = map & (slot - 1);
+    size_t count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+/// Get the allocation size of a node.
+static size_t node_size(uint32_t count, uint32_t children) {
+    return sizeof(ldict_node) + count * sizeof(ldict_entry) + children * sizeof(ldict_node*);
+}
+
+/// Allocate a node with uninitialized entries and children.
+static ldict_node* node_new(uint32_t datamap, uint32_t nodemap, uint32_t count, uint32_t children) {
+    ldict_node* node = lalloc(node_size(count, children));
+    node->refcount = 1;
+    node->datamap  = datamap;
+    node->nodemap  = nodemap;
+    node->count    = count;
+    node->children = children;
+
+    return node;
+}
+
+/// Free a node without dropping the references it holds.
+static void node_free(ldict_node* node) {
+    lfree(node, node_size(node->count, node->children));
+}
+
+/// Drop a reference to a node and delete it if it was the last one.
+static void node_del(ldict_node* node) {
+    if (--node->refcount > 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < node->count; i++) {
+        lval_del(node->entries[i].key);
+        if (node->entries[i].value) {
+            lval_del(node->entries[i].value);
+        }
+    }
+    for (size_t i = 0; i < node->children; i++) {
+        node_del(CHILDREN(node)[i]);
+    }
+
+    node_free(node);
+}
+
+/**
+ * Get a node that may be modified.
+ *
+ * \param node  The node (the caller's reference is moved to the result).
+ *
+ * \returns The node itself if it isn't shared, a copy otherwise.
+ */
+static ldict_node* node_own(ldict_node* node) {
+    if (node->refcount == 1) {
+        return node;
+    }
+
+    ldict_node* copy = node_new(node->datamap, node->nodemap, node->count, node->children);
+    memcpy(copy->entries, node->entries, node_size(node->count, node->children) - sizeof(ldict_node));
+
+    for (size_t i = 0; i < copy->count; i++) {
+        lval_ref(copy->entries[i].key);
+        if (copy->entries[i].value) {
+            lval_ref(copy->entries[i].value);
+        }
+    }
+    for (size_t i = 0; i < copy->children; i++) {
+        CHILDREN(copy)[i]->refcount++;
+    }
+
+    node->refcount--;
+    return copy;
+}
+
+/**
+ * Insert an entry into a node that isn't shared.
+ *
+ * \param node  The node (freed).
+ * \param index The index of the entry.
+ * \param slot  The slot of the entry, 0 below the last level.
+ * \param entry The entry (its references are moved to the node).
+ *
+ * \returns The new node.
+ */
+static ldict_node* node_insert(ldict_node* node, size_t index, uint32_t slot, ldict_entry entry) {
+    ldict_node* result = node_new(node->datamap | slot, node->nodemap, node->count + 1, node->children);
+
+    memcpy(result->entries, node->entries, index * sizeof(ldict_entry));
+    result->entries[index] = entry;
+    memcpy(result->entries + index + 1, node->entries + index, (node->count - index) * sizeof(ldict_entry));
+    memcpy(CHILDREN(result), CHILDREN(node), node->children * sizeof(ldict_node*));
+
+    node_free(node);
+    return result;
+}
+
+/**
+ * Replace an entry of a node that isn't shared with a child.
+ *
+ * \param node  The node (freed).
+ * \param index The index of the entry.
+ * \param slot  The slot of the entry.
+ * \param child The child (the reference is moved to the node).
+ *
+ * \returns The new node.
+ */
+static ldict_node* node_push_down(ldict_node* node, size_t index, uint32_t slot, ldict_node* child) {
+    ldict_node* result = node_new(node->datamap & ~slot, node->nodemap | slot,
+                                  node->count - 1, node->children + 1);
+    size_t child_index = index_of(node->nodemap, slot);
+
+    memcpy(result->entries, node->entries, index * sizeof(ldict_entry));
+    memcpy(result->entries + index, node->entries + index + 1,
+           (node->count - index - 1) * sizeof(ldict_entry));
+
+    memcpy(CHILDREN(result), CHILDREN(node), child_index * sizeof(ldict_node*));
+    CHILDREN(result)[child_index] = child;
+    memcpy(CHILDREN(result) + child_index + 1, CHILDREN(node) + child_index,
+           (node->children - child_index) * sizeof(ldict_node*));
+
+    node_free(node);
+    return result;
+}
+
+/**
+ * Create the node holding two entries with different keys.
+ *
+ * \param shift The position of the bits of the hashes used by the node.
+ * \param x     An entry (moved).
+ * \param y     Another entry (moved).
+ *
+ * \returns The node, with children down to the level where the entries'
+ *          slots differ.
+ */
+static ldict_node* node_pair(unsigned shift, ldict_entry x, ldict_entry y) {
+    ldict_node* node;
+
+    if (shift >= 64) {
+        node = node_new(0, 0, 2, 0);
+        node->entries[0] = x;
+        node->entries[1] = y;
+    } else if (SLOT(x.hash, shift) == SLOT(y.hash, shift)) {
+        node = node_new(0, SLOT(x.hash, shift), 0, 1);
+        CHILDREN(node)[0] = node_pair(shift + LEVEL_BITS, x, y);
+    } else {
+        bool ordered = SLOT(x.hash, shift) < SLOT(y.hash, shift);
+        node = node_new(SLOT(x.hash, shift) | SLOT(y.hash, shift), 0, 2, 0);
+        node->entries[0] = ordered ? x : y;
+        node->entries[1] = ordered ? y : x;
+    }
+
+    return node;
+}
+
+/// Replace the value of an entry, keeping its key.
+static void replace_value(ldict_entry* entry, ldict_entry* with) {
+    lval_del(with->key);
+    if (entry->value) {
+        lval_del(entry->value);
+    }
+    entry->value = with->value;
+}
+
+/**
+ * Add or replace an entry below a node.
+ *
+ * \param node  The node (the caller's reference is moved to the result).
+ * \param shift The position of the bits of the hash used by the node.
+ * \param entry The entry (moved).
+ * \param added [out] Set to true if the entry was added.
+ *
+ * \returns The node replacing `node`.
+ */
+static ldict_node* node_put(ldict_node* node, unsigned shift, ldict_entry entry, bool* added) {
+    node = node_own(node);
+
+    if (shift >= 64) {
+        for (size_t i = 0; i < node->count; i++) {
+            if (lval_key_eq(node->entries[i].key, entry.key)) {
+                replace_value(&node->entries[i], &entry);
+                return node;
+            }
+        }
+
+        *added = true;
+        return node_insert(node, node->count, 0, entry);
+    }
+
+    uint32_t slot = SLOT(entry.hash, shift);
+
+    if (node->datamap & slot) {
+        size_t index = index_of(node->datamap, slot);
+        ldict_entry* existing = &node->entries[index];
+
+        if (existing->hash == entry.hash && lval_key_eq(existing->key, entry.key)) {
+            replace_value(existing, &entry);
+            return node;
+        }
+
+        *added = true;
+        return node_push_down(node, index, slot,
+                              node_pair(shift + LEVEL_BITS, *existing, entry));
+    }
+
+    if (node->nodemap & slot) {
+        ldict_node** child = &CHILDREN(node)[index_of(node->nodemap, slot)];
+        *child = node_put(*child, shift + LEVEL_BITS, entry, added);
+        return node;
+    }
+
+    *added = true;
+    return node_insert(node, index_of(node->datamap, slot), slot, entry);
+}
+
+
+ldict* ldict_new(void) {
+    ldict* dict = xmalloc(sizeof(ldict));
+    dict->count = 0;
+    dict->root  = NULL;
+
+    return dict;
+}
+
+ldict* ldict_copy(ldict* dict) {
+    ASSERT_NOT_NULL(dict);
+
+    ldict* copy = ldict_new();
+    copy->count = dict->count;
+    copy->root  = dict->root;
+
+    if (copy->root) {
+        copy->root->refcount++;
+    }
+
+    return copy;
+}
+
+void ldict_del(ldict* dict) {
+    ASSERT_NOT_NULL(dict);
+
+    if (dict->root) {
+        node_del(dict->root);
+    }
+    xfree(dict);
+}
+
+bool ldict_find(ldict* dict, lval* key, lval** value) {
+    ASSERT_NOT_NULL(dict);
+    ASSERT_NOT_NULL(key);
+
+    uint64_t hash = lval_hash(key);
+    ldict_node* node = dict->root;
+    ldict_entry* found = NULL;
+
+    for (unsigned shift = 0; node && !found; shift += LEVEL_BITS) {
+        if (shift >= 64) {
+            for (size_t i = 0; i < node->count && !found; i++) {
+                found = lval_key_eq(node->entries[i].key, key) ? &node->entries[i] : NULL;
+            }
+            break;
+        }
+
+        uint32_t slot = SLOT(hash, shift);
+
+        if (node->datamap & slot) {
+            ldict_entry* entry = &node->entries[index_of(node->datamap, slot)];
+            found = entry->hash == hash && lval_key_eq(entry->key, key) ? entry : NULL;
+            break;
+        }
+
+        node = node->nodemap & slot ? CHILDREN(node)[index_of(node->nodemap, slot)] : NULL;
+    }
+
+    if (found && value) {
+        *value = found->value;
+    }
+    return found != NULL;
+}
+
+void ldict_put(ldict* dict, lval* key, lval* value) {
+    ASSERT_NOT_NULL(dict);
+    ASSERT_NOT_NULL(key);
+
+    ldict_entry entry = {lval_hash(key), key, value};
+
+    if (dict->root == NULL) {
+        dict->root = node_new(SLOT(entry.hash, 0), 0, 1, 0);
+        dict->root->entries[0] = entry;
+        dict->count = 1;
+        return;
+    }
+
+    bool added = false;
+    dict->root = node_put(dict->root, 0, entry, &added);
+    dict->count += added;
+}
+
+void ldict_iter_init(ldict_iter* iter, ldict* dict) {
+    ASSERT_NOT_NULL(iter);
+    ASSERT_NOT_NULL(dict);
+
+    iter->depth        = dict->root ? 1 : 0;
+    iter->nodes[0]     = dict->root;
+    iter->positions[0] = 0;
+}
+
+bool ldict_iter_next(ldict_iter* iter, lval** key, lval** value) {
+    ASSERT_NOT_NULL(iter);
+
+    // Visit the entries of a node before its children
+    while (iter->depth > 0) {
+        ldict_node* node = iter->nodes[iter->depth - 1];
+        size_t position = iter->positions[iter->depth - 1]++;
+
+        if (position < node->count) {
+            *key   = node->entries[position].key;
+            *value = node->entries[position].value;
+            return true;
+        } else if (position < node->count + node->children) {
+            iter->nodes[iter->depth]     = CHILDREN(node)[position - node->count];
+            iter->positions[iter->depth] = 0;
+            iter->depth++;
+        } else {
+            iter->depth--;
+        }
+    }
+
+    return false;
+}
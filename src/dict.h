@@ -0,0 +1,121 @@
+/**
+ * \file    dict.h
+ * \brief   Persistent hash maps and sets.
+ *
+ * A dictionary maps keys to values, a set is a dictionary without values.
+ * Keys are hashed structurally (see #lval_hash) and compared with #lval_key_eq,
+ * so any value can be a key.
+ *
+ * The entries are stored in a hash array mapped trie: each level of the trie
+ * uses five bits of the hash to select one of 32 slots, holding either an
+ * entry or the node of the next level. Slots are only allocated when used.
+ * Lookups and updates take at most 13 levels (and a linear scan of the
+ * entries whose hashes are all equal).
+ *
+ * Nodes are reference counted and shared between dictionaries: copying a
+ * dictionary only shares its root, and an update copies just the nodes on
+ * the path to the changed entry, so the copies made when a shared value is
+ * modified (see #lval_unshare) stay cheap. Nodes that aren't shared are
+ * updated in place.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stdbool.h>
+    #include <stddef.h>
+    #include <stdint.h>
+#endif
+
+#include "config.h"
+
+
+// Forward declarations
+struct lval;
+struct ldict_node;
+
+/// The maximum number of nodes on a path from the root to an entry: 13
+/// levels of five bits of the hash and the node of colliding hashes.
+#define LDICT_MAX_DEPTH 14
+
+/// A persistent hash map.
+typedef struct ldict {
+    size_t count;               ///< The number of entries.
+    struct ldict_node* root;    ///< The root of the trie, `NULL` if empty.
+} ldict;
+
+/// The state of an iteration over the entries of a dictionary.
+typedef struct ldict_iter {
+    size_t depth;                               ///< The number of nodes on
+                                                ///< the current path.
+    struct ldict_node* nodes[LDICT_MAX_DEPTH];  ///< The nodes on the path.
+    size_t positions[LDICT_MAX_DEPTH];          ///< The next entry or child
+                                                ///< of each node.
+} ldict_iter;
+
+
+/**
+ * Create an empty dictionary.
+ *
+ * \returns The dictionary. Has to be deleted with #ldict_del!
+ */
+ldict* ldict_new(void);
+
+/**
+ * Copy a dictionary, sharing all entries.
+ *
+ * \param dict  The dictionary to copy.
+ *
+ * \returns The copy. Has to be deleted with #ldict_del!
+ */
+ldict* ldict_copy(ldict* dict);
+
+/**
+ * Delete a dictionary, dropping the references to the keys and values of the
+ * entries it doesn't share.
+ *
+ * \param dict  The dictionary to delete.
+ */
+void ldict_del(ldict* dict);
+
+/**
+ * Find the entry of a key.
+ *
+ * \param dict  The dictionary.
+ * \param key   The key.
+ * \param value [out] The value of the entry (not referenced), `NULL` in sets.
+ *              May be `NULL`.
+ *
+ * \returns Whether the dictionary has an entry for the key.
+ */
+bool ldict_find(ldict* dict, struct lval* key, struct lval** value);
+
+/**
+ * Add an entry or replace the value of an existing one.
+ *
+ * \param dict  The dictionary, which must not be shared.
+ * \param key   The key (consumed).
+ * \param value The value (consumed), `NULL` in sets.
+ */
+void ldict_put(ldict* dict, struct lval* key, struct lval* value);
+
+/**
+ * Start iterating over the entries of a dictionary. The order depends on the
+ * hashes of the keys, it's the same for dictionaries with the same entries
+ * added in the same order. The dictionary must not be modified during the
+ * iteration.
+ *
+ * \param iter  The state of the iteration.
+ * \param dict  The dictionary.
+ */
+void ldict_iter_init(ldict_iter* iter, ldict* dict);
+
+/**
+ * Get the next entry of an iteration.
+ *
+ * \param iter  The state of the iteration.
+ * \param key   [out] The key of the entry (not referenced).
+ * \param value [out] The value of the entry (not referenced), `NULL` in sets.
+ *
+ * \returns Whether there was another entry.
+ */
+bool ldict_iter_next(ldict_iter* iter, struct lval** key, struct lval** value);
@@ -1,6 +1,9 @@
 #include "utils.h"
+#include "symbol.h"
 #include "lenv.h"
 #include "eval.h"
+#include "vm.h"
+#include "gc.h"
 #include "builtins/builtin.h"
 
 
@@ -11,6 +14,11 @@
 * `func` will be returned. Otherwise, `func` is called with the given
 * arguments. Consumes node completely.
 *
+* The operands of the special forms `if`, `and`, `or`, `quote`, `def`, `=` and
+* `lambda` are evaluated by the evaluator itself: `if` only evaluates the
+* selected branch, `and` and `or` only evaluate their second operand if the
+* first doesn't decide the result and `quote` returns its operand unevaluated.
+*
 * \param env	The environment in which to evaluate the node.
 * \param node	The node to evaluate.
 *
@@ -19,43 +27,237 @@
 lval* eval_sexpr(lenv* env, lval* node);
 
 /**
-* Evaluate a function.
-*
-* Evaluate a function. If it's a builtin, call it straight forward. Otherwise
-* it's a user defined lambda. If there aren't enough arguments to call it,
-* return a new function with the given arguments bound to the lambda context
-* (partial evaluation). Otherwise, evaluate the lambda and return the result.
-*
-* \todo Improve this code
-*
-* \param env	The environment in which to evaluate the function.
-* \param func	The function to call.
-* \param args	A list of arguments for the function.
-*
-* \returns A #lval containing the result.
-*/
-lval* eval_func(lenv* env, lval* func, lval* args);
+ * Evaluate a S-Expression, possibly in tail position (see #eval_call).
+ */
+static lval* eval_sexpr_tail(lenv* env, lval* node, ltail* tail);
+
+
+/// The backend used to evaluate S-Expressions.
+static eval_backend backend = EVAL_VM;
+
 
 
 lval* eval_sexpr(lenv* env, lval* node) {
-    // Evaluate children
-    for_item(node, {
-        node->values[i] = eval(env, node->values[i]);
+    return eval_sexpr_tail(env, node, NULL);
+}
 
-        // Error checking
-        if (node->values[i]->type == LVAL_ERR) {
-            return lval_take(node, i);
+/**
+ * Evaluate a Q-Expression like a S-Expression without copying it.
+ */
+static lval* eval_qexpr_tail(lenv* env, lval* node, ltail* tail) {
+    // An empty branch or body evaluates to an empty S-Expression
+    if (node->count == 0) {
+        lval_del(node);
+        return lval_sexpr();
+    }
+
+    return eval_sexpr_tail(env, node, tail);
+}
+
+/**
+ * Evaluate `(if cond {then} {else})`, only the selected branch is evaluated.
+ */
+static bool eval_if(lenv* env, lval* node, ltail* tail, lval** result) {
+    if (node->count < 3 || node->count > 4) {
+        return false;
+    }
+
+    // Other branches are evaluated like the arguments of any other function
+    for (size_t i = 2; i < node->count; i++) {
+        if (node->values[i]->type != LVAL_QEXPR) {
+            return false;
+        }
+    }
+
+    lval* cond = eval(env, lval_ref(node->values[1]));
+
+    if (cond->type == LVAL_ERR) {
+        *result = cond;
+    } else if (!lval_is_number(cond)) {
+        *result = lval_err("Function '%s' passed incorrect argument types. Expected number, got %s.",
+                           "if", lval_str_type(cond->type));
+        lval_del(cond);
+    } else if (!lval_is_zero(cond)) {
+        lval_del(cond);
+        *result = eval_qexpr_tail(env, lval_ref(node->values[2]), tail);
+    } else {
+        lval_del(cond);
+        *result = (node->count == 4) ? eval_qexpr_tail(env, lval_ref(node->values[3]), tail)
+                                     : lval_sexpr();
+    }
+
+    return true;
+}
+
+/**
+ * Evaluate `(and a b)` or `(or a b)`, `b` is only evaluated if `a` doesn't
+ * decide the result.
+ */
+static bool eval_logic(lenv* env, lval* func, lval* node, ltail* tail, lval** result) {
+    if (node->count != 3) {
+        return false;
+    }
+
+    bool is_and = func->builtin == builtin_and;
+    lval* first = eval(env, lval_ref(node->values[1]));
+
+    if (first->type == LVAL_ERR) {
+        *result = first;
+    } else if (!lval_is_number(first)) {
+        *result = lval_err("Function '%s' passed incorrect argument types. Expected number, got %s.",
+                           is_and ? "and" : "or", lval_str_type(first->type));
+        lval_del(first);
+    } else if (lval_is_zero(first) == is_and) {
+        lval_del(first);
+        *result = lval_int(!is_and);
+    } else {
+        lval* second = eval(env, lval_ref(node->values[2]));
+        if (second->type == LVAL_ERR) {
+            lval_del(first);
+            *result = second;
+        } else {
+            // The builtin checks the second operand
+            lval* args[] = {first, second};
+            *result = eval_call(env, lval_ref(func), lval_sexpr_from(args, 2), tail);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Evaluate `(def {name} value)` or `(= {name} value)` without building the
+ * argument list. Defining several names is left to the builtins, as all
+ * values are evaluated before any name is bound.
+ */
+static bool eval_def(lenv* env, lval* func, lval* node, lval** result) {
+    if (node->count != 3 || node->values[1]->type != LVAL_QEXPR
+            || node->values[1]->count != 1 || node->values[1]->values[0]->type != LVAL_SYM) {
+        return false;
+    }
+
+    lval* value = eval(env, lval_ref(node->values[2]));
+
+    if (value->type != LVAL_ERR) {
+        if (func->builtin == builtin_def) {
+            lenv_def(env, node->values[1]->values[0], value);
+        } else {
+            lenv_put(env, node->values[1]->values[0], value);
+        }
+
+        lval_del(value);
+        value = lval_sexpr();
+    }
+
+    *result = value;
+    return true;
+}
+
+/**
+ * Evaluate `(lambda {formals} {body})` without building the argument list.
+ */
+static bool eval_lambda(lval* node, lval** result) {
+    if (node->count != 3 || node->values[1]->type != LVAL_QEXPR
+            || node->values[2]->type != LVAL_QEXPR) {
+        return false;
+    }
+
+    // Invalid formals are reported by the builtin
+    for_item(node->values[1], {
+        if (item->type != LVAL_SYM) {
+            return false;
         }
     });
 
+    *result = lval_lambda(lval_ref(node->values[1]), lval_ref(node->values[2]));
+    return true;
+}
+
+/**
+ * Evaluate a special form.
+ *
+ * The operands of the builtins `if`, `and`, `or`, `quote`, `def`, `=` and
+ * `lambda` are only evaluated when they are needed. A form that doesn't
+ * have the expected shape (e.g. an `if` whose branches aren't literal
+ * Q-Expressions) is evaluated like a call of any other function.
+ *
+ * \param env       The environment in which to evaluate the node.
+ * \param func      The value of the operator.
+ * \param node      The S-Expression.
+ * \param tail      Where to store a call in tail position or `NULL`.
+ * \param result    [out] The result.
+ *
+ * \returns Whether the node is a special form. If so, `func` and `node` have
+ *          been consumed.
+ */
+static bool eval_special(lenv* env, lval* func, lval* node, ltail* tail, lval** result) {
+    bool special;
+
+    if (func->builtin == builtin_if) {
+        special = eval_if(env, node, tail, result);
+    } else if (func->builtin == builtin_and || func->builtin == builtin_or) {
+        special = eval_logic(env, func, node, tail, result);
+    } else if (func->builtin == builtin_quote) {
+        special = node->count == 2;
+        if (special) {
+            *result = builtin_quote_expr(lval_ref(node->values[1]));
+        }
+    } else if (func->builtin == builtin_def || func->builtin == builtin_put) {
+        special = eval_def(env, func, node, result);
+    } else if (func->builtin == builtin_lambda) {
+        special = eval_lambda(node, result);
+    } else {
+        return false;
+    }
+
+    if (special) {
+        lval_del(func);
+        lval_del(node);
+    }
+
+    return special;
+}
+
+static lval* eval_sexpr_tail(lenv* env, lval* node, ltail* tail) {
+    // A single S-Expression is evaluated in the same position
+    if (tail && node->count == 1 && node->values[0]->type == LVAL_SEXPR) {
+        return eval_tail(env, lval_take(node, 0), tail);
+    }
+
     // Empty expression
     if (node->count == 0) { return node; }
 
-    // Single expression
-    else if (node->count == 1) { return lval_take(node, 0); }
+    // The operator decides whether the operands are evaluated
+    lval* func = eval(env, lval_ref(node->values[0]));
 
-    // Ensure first element is a symbol
-    lval* func = lval_pop(node, 0);
+    if (func->type == LVAL_ERR || node->count == 1) {
+        lval_del(node);
+        return func;
+    }
+
+    lval* result;
+    if (func->type == LVAL_FUNC && func->builtin && eval_special(env, func, node, tail, &result)) {
+        return result;
+    }
+
+    // The operands are replaced by their values
+    node = lval_unshare(node);
+    node->type = LVAL_SEXPR;
+    lval_del(node->values[0]);
+    node->values[0] = func;
+
+    // Evaluate operands
+    for (size_t i = 1; i < node->count; i++) {
+        node->values[i] = eval(env, node->values[i]);
+
+        // Error checking
+        if (node->values[i]->type == LVAL_ERR) {
+            return lval_take(node, i);
+        }
+    }
+
+    // Ensure first element is a function
+    func = lval_pop(node, 0);
     if (func->type != LVAL_FUNC) {
         char* repr = lval_to_str(env, func);
         lval* error = lval_err("First element is not a function: %s", repr);
@@ -65,85 +267,194 @@ lval* eval_sexpr(lenv* env, lval* node) {
     }
 
     // Call builtin with operator
-    lval* result = eval_func(env, func, node);
-    lval_del(func);
-
-    return result;
+    return eval_call(env, func, node, tail);
 }
 
-lval* eval_func(lenv* env, lval* func, lval* args) {
-    if (func->builtin) {
-        return func->builtin(env, args);
-    }
-
+/**
+ * Bind the arguments of a lambda function in a new frame.
+ *
+ * Consumes args. If not all formals could be bound, func is consumed, too.
+ *
+ * \param env   The environment in which the function is called.
+ * \param func  The lambda function.
+ * \param args  A list of arguments for the function.
+ * \param frame Where to store the new frame.
+ *
+ * \returns `NULL` if all formals have been bound, the partially applied
+ *          function or an error otherwise.
+ */
+static lval* eval_bind(lenv* env, lval* func, lval* args, lenv** frame_ptr) {
     lval* formals = func->formals;
 
+    // Bind the arguments in a new frame, the function isn't modified
+    lenv* frame = lenv_extend(func->env);
+
+    // The interned name of the var-args marker
+    static char* varargs = NULL;
+    if (varargs == NULL) {
+        varargs = symbol_intern("...");
+    }
+
     // Record argument count
     size_t given = args->count;
-    size_t total = formals->count;
+    size_t total = formals->count - frame->bound;
 
-    while (args->count) {
+    for (size_t i = 0; i < args->count; i++) {
         // If we ran out of formal arguments to bind
-        if (formals->count == 0) {
+        if (frame->bound == formals->count) {
             lval_del(args);
-            char* repr = lval_to_str(env, func);
+            lval* partial = lval_partial(func, frame);
+            char* repr = lval_to_str(env, partial);
             lval* err = lval_err("Function '%s' passed too many arguments. Expected %i, got %i.",
                                  repr, given, total);
             xfree(repr);
+            lval_del(partial);
             return err;
         }
 
-        lval* symbol = lval_pop(formals, 0);
-
         // Handle var-args
-        if (strcmp(symbol->sym, "...") == 0) {
+        if (formals->values[frame->bound]->sym == varargs) {
             // Ensure one symbols follows
-            if (formals->count != 1) {
-                lval_del(symbol); lval_del(args);
+            if (formals->count - frame->bound != 2) {
+                lval_del(args); lval_del(func); lenv_del(frame);
                 return lval_err("Function format is invalid: '...' not followed by single symbol.");
             }
 
-            lval* next_sym = lval_pop(formals, 0);
+            // Bind the remaining arguments as list
+            lval* rest = lval_qexpr();
+            for (; i < args->count; i++) {
+                lval_add(rest, lval_ref(args->values[i]));
+            }
 
-            lenv_put(func->env, next_sym, builtin_list(env, args));
-            lval_del(symbol); lval_del(next_sym);
+            frame->slots[frame->bound + 1] = rest;
+            frame->bound = formals->count;
             break;
         }
 
-        lval* value = lval_pop(args, 0);
-
-        lenv_put(func->env, symbol, value);
-
-        lval_del(symbol);
-        lval_del(value);
+        // The formals are resolved to slots by position
+        frame->slots[frame->bound++] = lval_ref(args->values[i]);
     }
 
     lval_del(args);
 
     // If '...' has not yet been processed, it should be bound to empty list
-    if (formals->count > 0 && strcmp(formals->values[0]->sym, "...") == 0) {
+    if (frame->bound < formals->count && formals->values[frame->bound]->sym == varargs) {
         // Ensure that '...' is not passed invalidly
-        if (formals->count != 2) {
+        if (formals->count - frame->bound != 2) {
+            lval_del(func); lenv_del(frame);
             return lval_err("Function format invalid: '...' not followed by single symbol.");
         }
 
-        // Delete '...'
-        lval_del(lval_pop(formals, 0));
+        frame->slots[frame->bound + 1] = lval_qexpr();
+        frame->bound = formals->count;
+    }
+
+    // Not all formals have been bound
+    if (frame->bound < formals->count) {
+        return lval_partial(func, frame);
+    }
 
-        // FIXME: Comment
-        lval* symbol = lval_pop(formals, 0);
-        lval* value  = lval_qexpr();
+    *frame_ptr = frame;
+    return NULL;
+}
 
-        lenv_put(func->env, symbol, value);
-        lval_del(symbol); lval_del(value);
+lval* eval_func(lenv* env, lval* func, lval* args) {
+    if (func->builtin) {
+        gc_enter();
+        lval* result = func->builtin(env, args);
+        gc_leave();
+        lval_del(func);
+
+        return result;
     }
 
-    // If all formals have been bound, evaluate
-    if (formals->count == 0) {
-        func->env->parent = env;
-        return builtin_eval(func->env, lval_add(lval_sexpr(), lval_copy(func->body)));
+    // The frame of a function that made a call in tail position
+    lenv* caller = NULL;
+    lval* result;
+
+    while (1) {
+        lenv* frame = NULL;
+        result = eval_bind(env, func, args, &frame);
+        if (result) {
+            break;
+        }
+
+        // The frame of a tail call replaces the frame of its caller
+        lenv_set_caller(frame, env);
+        if (caller) {
+            lenv_del(caller);
+            caller = NULL;
+        }
+
+        // Compile the body once, the code is shared with all copies of the function
+        if (backend == EVAL_VM && func->code == NULL) {
+            func->code = lcode_compile_lambda(func->formals, func->body);
+        }
+
+        ltail tail;
+
+        gc_enter();
+        if (backend == EVAL_VM) {
+            result = vm_run(frame, func->code, &tail);
+        } else {
+            result = eval_qexpr_tail(frame, lval_ref(func->body), &tail);
+        }
+        gc_leave();
+        lval_del(func);
+
+        if (result) {
+            lenv_del(frame);
+            break;
+        }
+
+        // Run the call in tail position in the frame it was made in
+        caller = frame;
+        env    = frame;
+        func   = tail.func;
+        args   = tail.args;
+    }
+
+    if (caller) {
+        lenv_del(caller);
+    }
+
+    return result;
+}
+
+lval* eval_apply(lenv* env, lval* func, lval** values, size_t count) {
+    return eval_func(env, lval_ref(func), lval_sexpr_from(values, count));
+}
+
+lval* eval_call(lenv* env, lval* func, lval* args, ltail* tail) {
+    if (tail == NULL || (func->builtin && func->builtin != builtin_eval
+                         && func->builtin != builtin_if)) {
+        return eval_func(env, func, args);
+    }
+
+    // Evaluate the expression of 'eval' or the branch of 'if' in place
+    if (func->builtin) {
+        lval* expr = (func->builtin == builtin_if) ? builtin_if_branch(args)
+                                                   : builtin_eval_expr(args);
+        lval_del(func);
+
+        return eval_tail(env, expr, tail);
+    }
+
+    tail->func = func;
+    tail->args = args;
+
+    return NULL;
+}
+
+lval* eval_tail(lenv* env, lval* node, ltail* tail) {
+    if (node->type != LVAL_SEXPR) {
+        return eval(env, node);
+    }
+
+    if (backend == EVAL_VM) {
+        return vm_eval(env, node, tail);
     } else {
-        return lval_copy(func);
+        return eval_sexpr_tail(env, node, tail);
     }
 }
 
@@ -155,8 +466,20 @@ lval* eval(lenv* env, lval* node) {
         return value;
     } else if (node->type == LVAL_SEXPR) {
         // Evaluate S-Expressions
-        return eval_sexpr(env, node);
+        if (backend == EVAL_VM) {
+            return vm_eval(env, node, NULL);
+        } else {
+            return eval_sexpr(env, node);
+        }
     }
 
     return node;
 }
+
+void eval_set_backend(eval_backend selected) {
+    backend = selected;
+}
+
+eval_backend eval_get_backend(void) {
+    return backend;
+}
@@ -12,16 +12,113 @@
 #include "lenv.h"
 
 
+/// Possible backends to evaluate S-Expressions.
+typedef enum eval_backend {
+    EVAL_AST,   ///< Walk the expression tree (see #eval_sexpr).
+    EVAL_VM     ///< Compile to bytecode and run it (see #vm_eval).
+} eval_backend;
+
+
+/**
+ * A call in tail position.
+ *
+ * Calls of lambda functions in tail position aren't run where they are
+ * evaluated. They are passed back to #eval_func, which runs them in a loop,
+ * so tail recursive functions run in constant C stack.
+ */
+typedef struct ltail {
+    lval* func;     ///< The lambda function to call.
+    lval* args;     ///< The arguments of the call.
+} ltail;
+
+
 /**
  * Evaluate a node.
  *
  * If it's a symbol, return it's value from the given environment. If it's
- * a S-Expression, evaluate it according to #eval_sexpr. Otherwise, just return
- * it.
+ * a S-Expression, evaluate it with the selected backend (see
+ * #eval_set_backend). Otherwise, just return it.
  *
  * \param env	The environment in which to evaluate the node.
  * \param node	The node to evaluate.
  *
  * \returns A #lval containing the result.
  */
- lval* eval(lenv* env, lval* node);
+lval* eval(lenv* env, lval* node);
+
+/**
+* Evaluate a function.
+*
+* Evaluate a function. If it's a builtin, call it straight forward. Otherwise
+* it's a user defined lambda. If there aren't enough arguments to call it,
+* return a new function with the given arguments bound to the lambda context
+* (partial evaluation). Otherwise, evaluate the lambda and return the result.
+* Consumes func and args.
+*
+* \todo Improve this code
+*
+* \param env	The environment in which to evaluate the function.
+* \param func	The function to call.
+* \param args	A list of arguments for the function.
+*
+* \returns A #lval containing the result.
+*/
+lval* eval_func(lenv* env, lval* func, lval* args);
+
+/**
+ * Call a function with values as arguments.
+ *
+ * Lets builtins call functions without building a S-Expression: the values
+ * are passed as they are, they aren't evaluated again. Consumes the values,
+ * but not the function.
+ *
+ * \param env       The environment in which to call the function.
+ * \param func      The function to call.
+ * \param values    The arguments.
+ * \param count     The number of arguments.
+ *
+ * \returns A #lval containing the result.
+ */
+lval* eval_apply(lenv* env, lval* func, lval** values, size_t count);
+
+/**
+ * Call a function, possibly in tail position.
+ *
+ * Without `tail`, this is #eval_func. Otherwise, a call of a lambda function
+ * is stored in `tail` instead of being run and `NULL` is returned. `eval`
+ * and `if` are followed, the expression they evaluate is in tail position,
+ * too. Consumes func and args.
+ *
+ * \param env   The environment in which to evaluate the function.
+ * \param func  The function to call.
+ * \param args  A list of arguments for the function.
+ * \param tail  Where to store a call in tail position or `NULL`.
+ *
+ * \returns A #lval containing the result or `NULL` if `tail` has been set.
+ */
+lval* eval_call(lenv* env, lval* func, lval* args, ltail* tail);
+
+/**
+ * Evaluate a node in tail position.
+ *
+ * Like #eval, but calls are made with #eval_call.
+ *
+ * \param env   The environment in which to evaluate the node.
+ * \param node  The node to evaluate.
+ * \param tail  Where to store a call in tail position or `NULL`.
+ *
+ * \returns A #lval containing the result or `NULL` if `tail` has been set.
+ */
+lval* eval_tail(lenv* env, lval* node, ltail* tail);
+
+/**
+ * Select the backend used to evaluate S-Expressions.
+ *
+ * \param selected  The backend to use from now on.
+ */
+void eval_set_backend(eval_backend selected);
+
+/**
+ * Get the backend used to evaluate S-Expressions.
+ */
+eval_backend eval_get_backend(void);
@@ -0,0 +1,342 @@
+#include "config.h"
+
+#if defined MLISP_GC
+
+#include <time.h>
+
+#include "utils.h"
+#include "alloc.h"
+#include "compiler.h"
+#include "vm.h"
+#include "gc.h"
+
+
+/// The header in front of every collected object.
+typedef struct gc_header {
+    struct gc_header* next; ///< The next object of the heap.
+    struct gc_header* prev; ///< The previous object of the heap.
+    unsigned int kind;      ///< The #gc_kind of the object.
+    bool marked;            ///< Whether the object is reachable.
+} gc_header;
+
+/// The size of the header, rounded up to keep the objects aligned.
+static const size_t GC_HEADER_SIZE = (sizeof(gc_header) + ALLOC_CLASS_STEP - 1)
+                                     / ALLOC_CLASS_STEP * ALLOC_CLASS_STEP;
+
+/// A registered root.
+typedef struct gc_root_t {
+    gc_kind kind;   ///< The kind of the root.
+    void* ptr;      ///< The value or environment.
+} gc_root_t;
+
+/// All collected objects.
+static gc_header* heap = NULL;
+
+static gc_root_t* roots = NULL;
+static size_t root_count = 0;
+static size_t root_capacity = 0;
+
+/// The number of running function calls.
+static size_t depth = 0;
+
+/// Whether the unreachable objects are being freed.
+static bool sweeping = false;
+
+static double growth = GC_GROWTH;
+
+static gc_stats stats = {0, 0, 0, 0, 0, GC_MIN_HEAP, 0};
+
+
+/// Get the header of an object.
+static gc_header* header_of(void* ptr) {
+    return (gc_header*) ((char*) ptr - GC_HEADER_SIZE);
+}
+
+/// Get the object following a header.
+static void* object_of(gc_header* header) {
+    return (char*) header + GC_HEADER_SIZE;
+}
+
+/// Get the size of an object including its header.
+static size_t size_of(gc_kind kind) {
+    return GC_HEADER_SIZE + (kind == GC_LVAL ? LVAL_SIZE : sizeof(lenv));
+}
+
+void* gc_alloc(gc_kind kind, size_t size) {
+    ASSERTF(size + GC_HEADER_SIZE == size_of(kind), "invalid object size %zu", size);
+
+    gc_header* header = lalloc(GC_HEADER_SIZE + size);
+    header->kind   = kind;
+    header->marked = false;
+    header->next   = heap;
+    header->prev   = NULL;
+    if (heap) {
+        heap->prev = header;
+    }
+    heap = header;
+
+    stats.heap_bytes += GC_HEADER_SIZE + size;
+
+    return object_of(header);
+}
+
+void gc_free(gc_kind kind, void* ptr) {
+    gc_header* header = header_of(ptr);
+    ASSERTF(header->kind == kind, "object freed as wrong kind %u", kind);
+
+    if (header->prev) {
+        header->prev->next = header->next;
+    } else {
+        heap = header->next;
+    }
+    if (header->next) {
+        header->next->prev = header->prev;
+    }
+
+    stats.heap_bytes -= size_of(kind);
+    lfree(header, size_of(kind));
+}
+
+bool gc_sweeping(void) {
+    return sweeping;
+}
+
+static void push_root(gc_kind kind, void* ptr) {
+    if (root_count == root_capacity) {
+        root_capacity = root_capacity ? root_capacity * 2 : 16;
+        roots = xrealloc(roots, sizeof(gc_root_t) * root_capacity);
+    }
+
+    roots[root_count].kind = kind;
+    roots[root_count].ptr  = ptr;
+    root_count++;
+}
+
+static void pop_root(gc_kind kind, void* ptr) {
+    ASSERTF(root_count > 0 && roots[root_count - 1].ptr == ptr
+            && roots[root_count - 1].kind == kind, "roots unregistered out of order");
+    UNUSED(kind); UNUSED(ptr);
+
+    root_count--;
+}
+
+void gc_root(lval* value)      { push_root(GC_LVAL, value); }
+void gc_unroot(lval* value)    { pop_root(GC_LVAL, value); }
+void gc_root_env(lenv* env)    { push_root(GC_LENV, env); }
+void gc_unroot_env(lenv* env)  { pop_root(GC_LENV, env); }
+
+void gc_enter(void) { depth++; }
+void gc_leave(void) { depth--; }
+
+// ------------------------------------------------------------------------------
+// Mark
+
+static void mark_env(lenv* env);
+
+void gc_mark(lval* value) {
+    if (lval_is_static(value)) {
+        return;
+    }
+
+    gc_header* header = header_of(value);
+    if (header->marked) {
+        return;
+    }
+    header->marked = true;
+
+    switch (value->type) {
+        case LVAL_FUNC:
+            if (!value->builtin) {
+                mark_env(value->env);
+                gc_mark(value->formals);
+                gc_mark(value->body);
+
+                if (value->code) {
+                    for (size_t i = 0; i < value->code->const_count; i++) {
+                        gc_mark(value->code->constants[i]);
+                    }
+                }
+            }
+            break;
+
+        case LVAL_SEQ:
+            if (value->seq->source) {
+                gc_mark(value->seq->source);
+            }
+            if (value->seq->func) {
+                gc_mark(value->seq->func);
+            }
+            break;
+
+        case LVAL_DICT:
+        case LVAL_SET:
+            if (value->dict) {
+                ldict_iter iter;
+                lval* key;
+                lval* item;
+
+                ldict_iter_init(&iter, value->dict);
+                while (ldict_iter_next(&iter, &key, &item)) {
+                    gc_mark(key);
+                    if (item) {
+                        gc_mark(item);
+                    }
+                }
+            }
+            break;
+
+        case LVAL_ARRAY:
+            if (value->array) {
+                larray_each(value->array, gc_mark);
+            }
+            break;
+
+        // The storage owns the values of all slices sharing it
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            if (value->buf) {
+                for (size_t i = value->buf->first; i < value->buf->used; i++) {
+                    gc_mark(value->buf->items[i]);
+                }
+            }
+            break;
+
+        // No references to other objects
+        case LVAL_SYM:
+        case LVAL_INT:
+        case LVAL_BIG:
+        case LVAL_NUM:
+        case LVAL_VEC:
+        case LVAL_STR:
+        case LVAL_ERR:
+            break;
+    }
+}
+
+static void mark_env(lenv* env) {
+    for (; env; env = env->parent) {
+        gc_header* header = header_of(env);
+        if (header->marked) {
+            return;
+        }
+        header->marked = true;
+
+        lenv_each(env, {
+            gc_mark(val);
+        });
+
+        if (env->formals) {
+            gc_mark(env->formals);
+            for (size_t i = 0; i < env->formals->count; i++) {
+                if (env->slots[i]) {
+                    gc_mark(env->slots[i]);
+                }
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------
+// Sweep
+
+static void sweep(void) {
+    // Unreachable objects may still reference each other: drop all their
+    // references first, without freeing anything (see #gc_sweeping), as the
+    // objects they reference might be unreachable, too
+    sweeping = true;
+
+    for (gc_header* header = heap; header; header = header->next) {
+        if (header->marked) {
+            continue;
+        }
+
+        if (header->kind == GC_LVAL) {
+            lval_clear(object_of(header));
+        } else {
+            lenv_clear(object_of(header));
+        }
+    }
+
+    // The slots of an environment are sized by its formals, free them before
+    // the formals are freed
+    for (int pass = 0; pass < 2; pass++) {
+        gc_header* next;
+        gc_kind kind = pass == 0 ? GC_LENV : GC_LVAL;
+
+        for (gc_header* header = heap; header; header = next) {
+            next = header->next;
+            if (header->marked || header->kind != kind) {
+                continue;
+            }
+
+            stats.freed_objects++;
+            if (kind == GC_LVAL) {
+                lval_free(object_of(header));
+            } else {
+                lenv_free(object_of(header));
+            }
+        }
+    }
+
+    for (gc_header* header = heap; header; header = header->next) {
+        header->marked = false;
+    }
+
+    sweeping = false;
+}
+
+void gc_collect(void) {
+    ASSERTF(depth == 0, "collecting while a function is running");
+
+    clock_t start = clock();
+
+    for (size_t i = 0; i < root_count; i++) {
+        if (roots[i].kind == GC_LVAL) {
+            gc_mark(roots[i].ptr);
+        } else {
+            mark_env(roots[i].ptr);
+        }
+    }
+    vm_mark_stack();
+
+    sweep();
+    lalloc_reset();
+
+    double pause = (double) (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    stats.collections++;
+    stats.pause_total += pause;
+    stats.pause_max    = pause > stats.pause_max ? pause : stats.pause_max;
+    stats.live_bytes   = stats.heap_bytes;
+    stats.threshold    = (size_t) ((double) stats.live_bytes * growth);
+    if (stats.threshold < GC_MIN_HEAP) {
+        stats.threshold = GC_MIN_HEAP;
+    }
+}
+
+void gc_safepoint(void) {
+    if (depth == 0 && stats.heap_bytes >= stats.threshold) {
+        gc_collect();
+    }
+}
+
+void gc_set_growth(double factor) {
+    ASSERTF(factor > 1.0, "growth factor %f too small", factor);
+    growth = factor;
+}
+
+void gc_get_stats(gc_stats* result) {
+    *result = stats;
+}
+
+void gc_print_stats(void) {
+    printf("Number of collections:         %zu\n", stats.collections);
+    printf("Total collection pause (ms):   %.3f\n", stats.pause_total);
+    printf("Longest collection pause (ms): %.3f\n", stats.pause_max);
+    printf("Live bytes after collection:   %zu\n", stats.live_bytes);
+    printf("Heap bytes:                    %zu\n", stats.heap_bytes);
+    printf("Next collection at (bytes):    %zu\n", stats.threshold);
+    printf("Number of collected objects:   %zu\n", stats.freed_objects);
+}
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * \file    gc.h
+ * \brief   Optional tracing garbage collector for #lval and #lenv objects.
+ *
+ * When compiled with #MLISP_GC, a mark-and-sweep collector frees all objects
+ * that can't be reached from the roots (see #gc_root) or the VM stack.
+ * Objects are still freed as soon as their last reference is dropped, so
+ * long-running evaluations don't grow the heap: the collector only has to
+ * reclaim what reference counting can't, the cycles (like a function stored
+ * in the environment it closes over).
+ *
+ * The collector is precise, it never scans the C stack. That's why it only
+ * runs at safe points (see #gc_safepoint) between top-level evaluations, when
+ * the values still in use by the caller are registered as roots.
+ *
+ * Without #MLISP_GC, all functions of this file are empty macros.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stddef.h>
+#endif
+
+#include "config.h"
+#include "lval.h"
+#include "lenv.h"
+
+
+#if defined MLISP_GC
+    /// The heap size in bytes that triggers the first collection.
+    #define GC_MIN_HEAP (1024 * 1024)
+
+    /// The default factor by which the heap may grow between collections.
+    #define GC_GROWTH 2.0
+
+    /// The kinds of objects managed by the collector.
+    typedef enum gc_kind {
+        GC_LVAL,    ///< A #lval object.
+        GC_LENV     ///< A #lenv object.
+    } gc_kind;
+
+    /// Statistics of the collector.
+    typedef struct gc_stats {
+        size_t collections;     ///< The number of collections.
+        double pause_total;     ///< The total time spent collecting in ms.
+        double pause_max;       ///< The longest collection in ms.
+        size_t live_bytes;      ///< The size of the objects that survived
+                                ///< the last collection.
+        size_t heap_bytes;      ///< The size of all objects.
+        size_t threshold;       ///< The heap size triggering the next
+                                ///< collection.
+        size_t freed_objects;   ///< The number of objects freed in total.
+    } gc_stats;
+
+
+    /**
+     * Allocate memory for a garbage collected object.
+     *
+     * \param kind  The kind of the object.
+     * \param size  The size of the object.
+     *
+     * \returns A pointer to the uninitialized object.
+     */
+    void* gc_alloc(gc_kind kind, size_t size);
+
+    /**
+     * Free a collected object whose last reference has been dropped.
+     *
+     * \param kind  The kind of the object.
+     * \param ptr   The object, allocated with #gc_alloc.
+     */
+    void gc_free(gc_kind kind, void* ptr);
+
+    /**
+     * Check whether the collector is freeing unreachable objects.
+     *
+     * While it sweeps, dropping the last reference to an object must not
+     * free it: the collector frees all unreachable objects itself.
+     *
+     * \returns Whether the collector is sweeping.
+     */
+    bool gc_sweeping(void);
+
+    /**
+     * Register a value as root.
+     *
+     * Roots and everything reachable from them survive collections. Roots
+     * are a stack: unregister them in reverse order (see #gc_unroot).
+     *
+     * \param value The value to keep alive.
+     */
+    void gc_root(lval* value);
+
+    /**
+     * Unregister a root value.
+     *
+     * \param value The value passed to #gc_root.
+     */
+    void gc_unroot(lval* value);
+
+    /**
+     * Register an environment as root.
+     *
+     * \see gc_root
+     *
+     * \param env   The environment to keep alive.
+     */
+    void gc_root_env(lenv* env);
+
+    /**
+     * Unregister a root environment.
+     *
+     * \param env   The environment passed to #gc_root_env.
+     */
+    void gc_unroot_env(lenv* env);
+
+    /**
+     * Mark a value as reachable while collecting.
+     *
+     * Used to mark roots that aren't registered, like the VM stack.
+     *
+     * \param value The reachable value.
+     */
+    void gc_mark(lval* value);
+
+    /**
+     * Enter a function call. No collection happens until it's left again.
+     */
+    void gc_enter(void);
+
+    /**
+     * Leave a function call.
+     */
+    void gc_leave(void);
+
+    /**
+     * Collect garbage if the heap reached its threshold.
+     *
+     * Does nothing while a function is running (see #gc_enter). All values
+     * the caller still needs have to be registered as roots.
+     */
+    void gc_safepoint(void);
+
+    /**
+     * Collect garbage now.
+     *
+     * May only be called when no function is running.
+     */
+    void gc_collect(void);
+
+    /**
+     * Set the factor by which the heap may grow between collections.
+     *
+     * After a collection, the next one is triggered when the heap reaches
+     * `factor` times the size of the live objects (but at least
+     * #GC_MIN_HEAP).
+     *
+     * \param factor    The growth factor, greater than 1.
+     */
+    void gc_set_growth(double factor);
+
+    /**
+     * Get the statistics of the collector.
+     *
+     * \param result    [out] The statistics.
+     */
+    void gc_get_stats(gc_stats* result);
+
+    /**
+     * Print the statistics of the collector.
+     */
+    void gc_print_stats(void);
+#else
+    #define gc_root(value)      ((void) 0)
+    #define gc_unroot(value)    ((void) 0)
+    #define gc_root_env(env)    ((void) 0)
+    #define gc_unroot_env(env)  ((void) 0)
+    #define gc_enter()          ((void) 0)
+    #define gc_leave()          ((void) 0)
+    #define gc_safepoint()      ((void) 0)
+#endif
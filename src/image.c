@@ -0,0 +1,1026 @@
+#if ! defined _WIN32
+    // For mmap and fileno
+    #define _POSIX_C_SOURCE 200112L
+
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#include <stdint.h>
+
+#include "utils.h"
+#include "symbol.h"
+#include "image.h"
+#include "builtins/builtin.h"
+
+
+/// The magic bytes at the beginning of an image.
+#define IMAGE_MAGIC "MLISPIMG"
+
+/// Marks the byte order of the machine that wrote an image.
+#define IMAGE_BYTE_ORDER 0x01020304u
+
+/// The index of a missing record (like the parent of an environment).
+#define IMAGE_NONE UINT32_MAX
+
+/// The kinds of records.
+typedef enum irecord_kind {
+    IMAGE_SEXPR,    ///< A S-Expression, its items are words.
+    IMAGE_QEXPR,    ///< A Q-Expression, its items are words.
+    IMAGE_SYM,      ///< A symbol, its name is a string.
+    IMAGE_INT,      ///< An integer.
+    IMAGE_BIG,      ///< A big integer, its decimal digits are a string.
+    IMAGE_NUM,      ///< A float number.
+    IMAGE_INTS,     ///< An integer vector, its items are a string of bytes.
+    IMAGE_FLOATS,   ///< A float vector, its items are a string of bytes.
+    IMAGE_STR,      ///< A string.
+    IMAGE_ERR,      ///< An error, its message is a string.
+    IMAGE_BUILTIN,  ///< A builtin function, its name is a string.
+    IMAGE_LAMBDA,   ///< A lambda, its formals, body and frame are words.
+    IMAGE_SEQ,      ///< A sequence (see #write_seq for its words).
+    IMAGE_DICT,     ///< A hash map, its keys and values are words.
+    IMAGE_SET,      ///< A hash set, its keys are words.
+    IMAGE_ARRAY,    ///< An array, its items are words.
+    IMAGE_ENV       ///< An environment (see #write_env for its words).
+} irecord_kind;
+
+/// The header of an image.
+typedef struct iheader {
+    char magic[8];          ///< #IMAGE_MAGIC
+    uint32_t version;       ///< #IMAGE_VERSION
+    uint32_t byte_order;    ///< #IMAGE_BYTE_ORDER
+    uint64_t records;       ///< The number of records.
+    uint64_t words;         ///< The number of words.
+    uint64_t strings;       ///< The size of the strings in bytes.
+} iheader;
+
+/// A record of an image.
+typedef struct irecord {
+    uint32_t kind;          ///< The #irecord_kind.
+    uint32_t count;         ///< The number of words or characters.
+    union {
+        PRECISION_INT integer;  ///< The value of an integer.
+        PRECISION_FLOAT num;    ///< The value of a float number.
+        uint64_t offset;        ///< The index of the first word or the
+                                ///< offset of the string.
+    };
+} irecord;
+
+/// Map the address of an object to the index of its record.
+KHASH_MAP_INIT_INT64(image, uint32_t)
+
+/// The state of writing an image.
+typedef struct iwriter {
+    irecord* records;       ///< The records written.
+    size_t count;           ///< The number of records.
+    size_t capacity;        ///< The number of records that fit in.
+
+    uint32_t* words;        ///< The words referring to records.
+    size_t word_count;      ///< The number of words.
+    size_t word_capacity;   ///< The number of words that fit in.
+
+    char* strings;          ///< The strings, each terminated by `\0`.
+    size_t length;          ///< The size of the strings.
+    size_t string_capacity; ///< The number of bytes that fit in.
+
+    khash_t(image)* written;///< The records of the objects written so far,
+                            ///< #IMAGE_NONE while writing their children.
+    khash_t(image)* names;  ///< The offsets of the interned names written.
+    khash_t(image)* symbols;///< The records of the symbols by their name.
+    lenv* builtins;         ///< The builtin functions, to find their names.
+    char* error;            ///< The reason writing failed, if it did.
+} iwriter;
+
+/// The state of loading an image.
+typedef struct ireader {
+    irecord* records;       ///< The records.
+    size_t count;           ///< The number of records.
+    uint32_t* words;        ///< The words referring to records.
+    size_t word_count;      ///< The number of words.
+    char* strings;          ///< The strings.
+    size_t length;          ///< The size of the strings.
+
+    void** objects;         ///< The object created for each record so far.
+    lenv* builtins;         ///< The builtin functions, to find them by name.
+} ireader;
+
+
+static uint32_t write_env(iwriter* writer, lenv* env);
+
+
+/// Grow an array so that at least `needed` items fit in.
+static void* reserve(void* items, size_t size, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) {
+        return items;
+    }
+
+    *capacity = needed > 2 * *capacity ? needed : 2 * *capacity;
+    return xrealloc(items, size * *capacity);
+}
+
+/// Reserve `count` words and return the index of the first one.
+static size_t add_words(iwriter* writer, size_t count) {
+    writer->words = reserve(writer->words, sizeof(uint32_t), &writer->word_capacity,
+                            writer->word_count + count);
+    writer->word_count += count;
+
+    return writer->word_count - count;
+}
+
+/// Append a string and return its offset.
+static size_t add_string(iwriter* writer, char* str, size_t length) {
+    writer->strings = reserve(writer->strings, 1, &writer->string_capacity,
+                              writer->length + length + 1);
+    memcpy(writer->strings + writer->length, str, length);
+    writer->strings[writer->length + length] = '\0';
+    writer->length += length + 1;
+
+    return writer->length - length - 1;
+}
+
+/// Append an interned name once and return its offset.
+static uint32_t add_name(iwriter* writer, char* name) {
+    int ret;
+    khiter_t k = kh_put(image, writer->names, (khint64_t) (uintptr_t) name, &ret);
+    if (ret != 0) {
+        kh_value(writer->names, k) = (uint32_t) add_string(writer, name, strlen(name));
+    }
+
+    return kh_value(writer->names, k);
+}
+
+/**
+ * Find the record of an object that has been written already.
+ *
+ * \param writer    The writer.
+ * \param object    The value or environment.
+ * \param index     [out] The index of its record.
+ *
+ * \returns Whether the object has been written (or failed as cyclic).
+ */
+static bool find_record(iwriter* writer, void* object, uint32_t* index) {
+    int ret;
+    khiter_t k = kh_put(image, writer->written, (khint64_t) (uintptr_t) object, &ret);
+    if (ret != 0) {
+        // Written after its children
+        kh_value(writer->written, k) = IMAGE_NONE;
+        return false;
+    }
+
+    *index = kh_value(writer->written, k);
+    if (*index == IMAGE_NONE) {
+        writer->error = "Unable to save a value that contains itself";
+    }
+
+    return true;
+}
+
+/// Append the record of an object and return its index.
+static uint32_t add_record(iwriter* writer, void* object, irecord record) {
+    if (writer->count >= IMAGE_NONE) {
+        writer->error = "Too many values to save";
+        return IMAGE_NONE;
+    }
+
+    writer->records = reserve(writer->records, sizeof(irecord), &writer->capacity,
+                              writer->count + 1);
+    writer->records[writer->count] = record;
+
+    khiter_t k = kh_get(image, writer->written, (khint64_t) (uintptr_t) object);
+    kh_value(writer->written, k) = (uint32_t) writer->count;
+
+    return (uint32_t) writer->count++;
+}
+
+static uint32_t write_value(iwriter* writer, lval* node);
+
+/// The number of words of a sequence.
+#define IMAGE_SEQ_WORDS 9
+
+/**
+ * Write the words of a sequence after everything it refers to.
+ *
+ * The words are the #lseq_kind, the indices of the source and the function
+ * (#IMAGE_NONE if there is none) and the lower and upper halves of the start,
+ * end and step of a range.
+ *
+ * \returns The offset of the words.
+ */
+static uint64_t write_seq(iwriter* writer, lseq* seq) {
+    uint32_t source = seq->source ? write_value(writer, seq->source) : IMAGE_NONE;
+    uint32_t func   = seq->func ? write_value(writer, seq->func) : IMAGE_NONE;
+    uint64_t range[3] = {(uint64_t) seq->start, (uint64_t) seq->end, (uint64_t) seq->step};
+
+    uint64_t offset = add_words(writer, IMAGE_SEQ_WORDS);
+    writer->words[offset]     = (uint32_t) seq->kind;
+    writer->words[offset + 1] = source;
+    writer->words[offset + 2] = func;
+
+    for (size_t i = 0; i < 3; i++) {
+        writer->words[offset + 3 + 2 * i] = (uint32_t) range[i];
+        writer->words[offset + 4 + 2 * i] = (uint32_t) (range[i] >> 32);
+    }
+
+    return offset;
+}
+
+/**
+ * Write a value after everything it refers to.
+ *
+ * \returns The index of its record or #IMAGE_NONE on an error.
+ */
+static uint32_t write_value(iwriter* writer, lval* node) {
+    uint32_t index;
+
+    // Symbols can't be modified, all symbols with a name share one record
+    if (node->type == LVAL_SYM && !writer->error) {
+        khiter_t k = kh_get(image, writer->symbols, (khint64_t) (uintptr_t) node->sym);
+        if (k != kh_end(writer->symbols)) {
+            return kh_value(writer->symbols, k);
+        }
+    }
+
+    if (writer->error || find_record(writer, node, &index)) {
+        return writer->error ? IMAGE_NONE : index;
+    }
+
+    irecord record;
+    record.count  = 0;
+    record.offset = 0;
+
+    switch (node->type) {
+        case LVAL_INT:
+            record.kind    = IMAGE_INT;
+            record.integer = node->integer;
+            break;
+        case LVAL_BIG: {
+            char* digits = lbig_to_str(node->big);
+            record.kind   = IMAGE_BIG;
+            record.count  = (uint32_t) strlen(digits);
+            record.offset = add_string(writer, digits, record.count);
+            xfree(digits);
+            break;
+        }
+        case LVAL_NUM:
+            record.kind = IMAGE_NUM;
+            record.num  = node->num;
+            break;
+        case LVAL_VEC: {
+            lvec* vec = node->vec;
+            size_t size = vec->count * (vec->integers ? sizeof(PRECISION_INT)
+                                                      : sizeof(PRECISION_FLOAT));
+            if (size >= UINT32_MAX) {
+                writer->error = "Unable to save a vector that big";
+                return IMAGE_NONE;
+            }
+
+            // The items may contain zero bytes, the string is read by its length
+            record.kind   = vec->integers ? IMAGE_INTS : IMAGE_FLOATS;
+            record.count  = (uint32_t) size;
+            record.offset = add_string(writer, (char*) (vec->integers ? (void*) vec->ints
+                                                                      : (void*) vec->floats),
+                                       size);
+            break;
+        }
+        case LVAL_SEQ:
+            record.kind   = IMAGE_SEQ;
+            record.count  = IMAGE_SEQ_WORDS;
+            record.offset = write_seq(writer, node->seq);
+            break;
+        case LVAL_DICT:
+        case LVAL_SET: {
+            // Keys and values alternate in a hash map
+            size_t width = node->type == LVAL_DICT ? 2 : 1;
+            ldict_iter iter;
+            lval* key;
+            lval* value;
+
+            record.kind   = node->type == LVAL_DICT ? IMAGE_DICT : IMAGE_SET;
+            record.count  = (uint32_t) (width * node->dict->count);
+            record.offset = add_words(writer, record.count);
+
+            ldict_iter_init(&iter, node->dict);
+            for (size_t i = 0; ldict_iter_next(&iter, &key, &value); i += width) {
+                index = write_value(writer, key);
+                writer->words[record.offset + i] = index;
+
+                if (value) {
+                    index = write_value(writer, value);
+                    writer->words[record.offset + i + 1] = index;
+                }
+            }
+            break;
+        }
+        case LVAL_ARRAY:
+            record.kind   = IMAGE_ARRAY;
+            record.count  = (uint32_t) node->array->count;
+            record.offset = add_words(writer, record.count);
+
+            for (size_t i = 0; i < node->array->count; i++) {
+                index = write_value(writer, larray_get(node->array, i));
+                writer->words[record.offset + i] = index;
+            }
+            break;
+        case LVAL_SYM:
+            record.kind   = IMAGE_SYM;
+            record.count  = (uint32_t) strlen(node->sym);
+            record.offset = add_name(writer, node->sym);
+
+            if (writer->count < IMAGE_NONE) {
+                int ret;
+                khiter_t k = kh_put(image, writer->symbols, (khint64_t) (uintptr_t) node->sym, &ret);
+                kh_value(writer->symbols, k) = (uint32_t) writer->count;
+            }
+            break;
+        case LVAL_STR:
+            record.kind   = IMAGE_STR;
+            record.count  = (uint32_t) node->length;
+            record.offset = add_string(writer, node->str, record.count);
+            break;
+        case LVAL_ERR:
+            record.kind   = IMAGE_ERR;
+            record.count  = (uint32_t) strlen(node->err);
+            record.offset = add_string(writer, node->err, record.count);
+            break;
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            record.kind   = node->type == LVAL_SEXPR ? IMAGE_SEXPR : IMAGE_QEXPR;
+            record.count  = (uint32_t) node->count;
+            record.offset = add_words(writer, node->count);
+
+            for_item(node, {
+                index = write_value(writer, item);
+                writer->words[record.offset + i] = index;
+            });
+            break;
+        case LVAL_FUNC:
+            if (node->builtin) {
+                char* name = lenv_func_name(writer->builtins, node->builtin);
+                if (name == NULL) {
+                    writer->error = "Unable to save an unknown builtin function";
+                    return IMAGE_NONE;
+                }
+
+                record.kind   = IMAGE_BUILTIN;
+                record.count  = (uint32_t) strlen(name);
+                record.offset = add_name(writer, name);
+            } else {
+                record.kind   = IMAGE_LAMBDA;
+                record.count  = 3;
+                record.offset = add_words(writer, 3);
+
+                index = write_value(writer, node->formals);
+                writer->words[record.offset] = index;
+                index = write_value(writer, node->body);
+                writer->words[record.offset + 1] = index;
+                index = write_env(writer, node->env);
+                writer->words[record.offset + 2] = index;
+            }
+            break;
+        default:
+            ASSERTF(0, "Invalid lval type: %i", node->type);
+    }
+
+    return writer->error ? IMAGE_NONE : add_record(writer, node, record);
+}
+
+/**
+ * Write an environment after everything it refers to.
+ *
+ * The words of an environment are the indices of its parent and its formals
+ * (#IMAGE_NONE if it has none), the number of formals bound, the value of
+ * each slot (#IMAGE_NONE if it isn't bound) and finally the offset of the
+ * name and the value of each other binding.
+ *
+ * \returns The index of its record or #IMAGE_NONE on an error.
+ */
+static uint32_t write_env(iwriter* writer, lenv* env) {
+    uint32_t index;
+    if (writer->error || find_record(writer, env, &index)) {
+        return writer->error ? IMAGE_NONE : index;
+    }
+
+    size_t slots = env->formals ? env->formals->count : 0;
+    size_t bindings = env->values ? kh_size(env->values) : 0;
+
+    irecord record;
+    record.kind   = IMAGE_ENV;
+    record.count  = (uint32_t) (3 + slots + 2 * bindings);
+    record.offset = add_words(writer, record.count);
+
+    size_t word = record.offset;
+    index = env->parent ? write_env(writer, env->parent) : IMAGE_NONE;
+    writer->words[word++] = index;
+    index = env->formals ? write_value(writer, env->formals) : IMAGE_NONE;
+    writer->words[word++] = index;
+    writer->words[word++] = (uint32_t) env->bound;
+
+    for (size_t i = 0; i < slots; i++) {
+        index = env->slots[i] ? write_value(writer, env->slots[i]) : IMAGE_NONE;
+        writer->words[word++] = index;
+    }
+
+    lenv_each(env, {
+        writer->words[word++] = add_name(writer, key);
+        index = write_value(writer, val);
+        writer->words[word++] = index;
+    });
+
+    return writer->error ? IMAGE_NONE : add_record(writer, env, record);
+}
+
+lval* image_save(lenv* env, char* filename) {
+    ASSERT_NOT_NULL(env);
+    ASSERT_NOT_NULL(filename);
+
+    iwriter writer = {0};
+    writer.written  = kh_init(image);
+    writer.names    = kh_init(image);
+    writer.symbols  = kh_init(image);
+    writer.builtins = lenv_new();
+    builtins_init(writer.builtins);
+
+    // The environment is the last record
+    write_env(&writer, env);
+
+    lval* result = NULL;
+    if (writer.error) {
+        result = lval_err("Unable to save image: %s", writer.error);
+    }
+
+    FILE* file = result ? NULL : fopen(filename, "wb");
+    if (result == NULL && file == NULL) {
+        result = lval_err("Unable to write image: %s", filename);
+    }
+
+    if (file) {
+        iheader header;
+        memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+        header.version    = IMAGE_VERSION;
+        header.byte_order = IMAGE_BYTE_ORDER;
+        header.records    = writer.count;
+        header.words      = writer.word_count;
+        header.strings    = writer.length;
+
+        bool written = fwrite(&header, sizeof(iheader), 1, file) == 1
+            && fwrite(writer.records, sizeof(irecord), writer.count, file) == writer.count
+            && fwrite(writer.words, sizeof(uint32_t), writer.word_count, file) == writer.word_count
+            && fwrite(writer.strings, 1, writer.length, file) == writer.length;
+
+        if (fclose(file) != 0 || !written) {
+            result = lval_err("Unable to write image: %s", filename);
+        }
+    }
+
+    kh_destroy(image, writer.written);
+    kh_destroy(image, writer.names);
+    kh_destroy(image, writer.symbols);
+    lenv_del(writer.builtins);
+    if (writer.records) xfree(writer.records);
+    if (writer.words) xfree(writer.words);
+    if (writer.strings) xfree(writer.strings);
+
+    return result ? result : lval_sexpr();
+}
+
+
+/// Get the string at `offset` with `length` characters or `NULL`.
+static char* read_string(ireader* reader, uint64_t offset, size_t length) {
+    if (offset >= reader->length || length >= reader->length - offset
+            || reader->strings[offset + length] != '\0') {
+        return NULL;
+    }
+
+    return reader->strings + offset;
+}
+
+/// Whether a node is a Q-Expression of symbols, as the formals of lambdas and
+/// frames are.
+static bool is_formals(lval* node) {
+    if (node->type != LVAL_QEXPR) {
+        return false;
+    }
+
+    for (size_t i = 0; i < node->count; i++) {
+        if (node->values[i]->type != LVAL_SYM) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Get the interned name at `offset` or `NULL`.
+static char* read_name(ireader* reader, uint64_t offset) {
+    if (offset >= reader->length
+            || memchr(reader->strings + offset, '\0', reader->length - offset) == NULL) {
+        return NULL;
+    }
+
+    return symbol_intern(reader->strings + offset);
+}
+
+/**
+ * Get the object created for the record a word refers to.
+ *
+ * \param reader    The reader.
+ * \param word      The index of the word.
+ * \param current   The index of the record being read.
+ * \param env       Whether the object has to be an environment or a value.
+ *
+ * \returns The object or `NULL` if the word doesn't refer to an earlier
+ *          record of that kind.
+ */
+static void* read_word(ireader* reader, size_t word, size_t current, bool env) {
+    uint32_t index = reader->words[word];
+    if (index >= current || (reader->records[index].kind == IMAGE_ENV) != env) {
+        return NULL;
+    }
+
+    return reader->objects[index];
+}
+
+/**
+ * Read the bindings of an #IMAGE_ENV record into an environment.
+ *
+ * \param reader    The reader.
+ * \param current   The index of the record.
+ * \param env       The environment created for the record or the one the
+ *                  image is loaded into.
+ * \param word      The index of the first word after the slots.
+ *
+ * \returns Whether all bindings are valid.
+ */
+static bool read_bindings(ireader* reader, size_t current, lenv* env, size_t word) {
+    irecord* record = &reader->records[current];
+    bool loaded = current == reader->count - 1;
+
+    for (; word < record->offset + record->count; word += 2) {
+        char* name  = read_name(reader, reader->words[word]);
+        lval* value = read_word(reader, word + 1, current, false);
+        if (name == NULL || value == NULL) {
+            return false;
+        }
+
+        if (loaded) {
+            // Replace the bindings of the environment
+            lval* sym = lval_sym(name);
+            lenv_put(env, sym, value);
+            lval_del(sym);
+            continue;
+        }
+
+        if (env->values == NULL) {
+            env->values = kh_init(lenv);
+        }
+
+        int ret;
+        khiter_t k = kh_put(lenv, env->values, name, &ret);
+        if (ret == 0) {
+            return false;
+        }
+        kh_value(env->values, k) = lval_ref(value);
+    }
+
+    return true;
+}
+
+/**
+ * Create the environment of an #IMAGE_ENV record (see #write_env).
+ *
+ * The last record is the environment that has been saved, its bindings are
+ * loaded into `target` instead.
+ *
+ * \returns The environment or `NULL` if the record is invalid.
+ */
+static lenv* read_env(ireader* reader, size_t current, lenv* target) {
+    irecord* record = &reader->records[current];
+    size_t word = record->offset;
+
+    if (record->count < 3) {
+        return NULL;
+    }
+
+    lenv* parent = NULL;
+    if (reader->words[word] != IMAGE_NONE
+            && (parent = read_word(reader, word, current, true)) == NULL) {
+        return NULL;
+    }
+
+    lval* formals = NULL;
+    if (reader->words[word + 1] != IMAGE_NONE
+            && (formals = read_word(reader, word + 1, current, false)) == NULL) {
+        return NULL;
+    }
+
+    size_t bound = reader->words[word + 2];
+    size_t slots = formals ? formals->count : 0;
+    size_t rest  = record->count - 3;
+    if ((formals && !is_formals(formals)) || bound > slots
+            || slots > rest || (rest - slots) % 2 != 0) {
+        return NULL;
+    }
+    word += 3;
+
+    if (current == reader->count - 1) {
+        return read_bindings(reader, current, target, word + slots) ? target : NULL;
+    }
+
+    lenv* env = formals ? lenv_new_frame(formals) : lenv_new();
+    env->parent = parent ? lenv_ref(parent) : NULL;
+    env->bound  = bound;
+
+    for (size_t i = 0; i < slots; i++, word++) {
+        lval* value = NULL;
+        if (reader->words[word] != IMAGE_NONE
+                && (value = read_word(reader, word, current, false)) == NULL) {
+            lenv_del(env);
+            return NULL;
+        }
+
+        env->slots[i] = value ? lval_ref(value) : NULL;
+    }
+
+    if (!read_bindings(reader, current, env, word)) {
+        lenv_del(env);
+        return NULL;
+    }
+
+    return env;
+}
+
+/// Create the list of an #IMAGE_SEXPR or #IMAGE_QEXPR record or `NULL`.
+static lval* read_list(ireader* reader, size_t current) {
+    irecord* record = &reader->records[current];
+    lval** values = xmalloc(LVAL_PTR_SIZE * (record->count + 1));
+
+    for (size_t i = 0; i < record->count; i++) {
+        values[i] = read_word(reader, record->offset + i, current, false);
+        if (values[i] == NULL) {
+            xfree(values);
+            return NULL;
+        }
+
+        lval_ref(values[i]);
+    }
+
+    lval* node = lval_sexpr_from(values, record->count);
+    node->type = record->kind == IMAGE_SEXPR ? LVAL_SEXPR : LVAL_QEXPR;
+    xfree(values);
+
+    return node;
+}
+
+/// Create the hash map or set of an #IMAGE_DICT or #IMAGE_SET record or `NULL`.
+static lval* read_dict(ireader* reader, size_t current) {
+    irecord* record = &reader->records[current];
+    size_t width = record->kind == IMAGE_DICT ? 2 : 1;
+    if (record->count % width != 0) {
+        return NULL;
+    }
+
+    ldict* dict = ldict_new();
+
+    for (size_t i = 0; i < record->count; i += width) {
+        lval* key   = read_word(reader, record->offset + i, current, false);
+        lval* value = width == 2 ? read_word(reader, record->offset + i + 1, current, false) : key;
+        if (key == NULL || value == NULL) {
+            ldict_del(dict);
+            return NULL;
+        }
+
+        ldict_put(dict, lval_ref(key), width == 2 ? lval_ref(value) : NULL);
+    }
+
+    return lval_dict(dict, record->kind == IMAGE_SET);
+}
+
+/// Create the array of an #IMAGE_ARRAY record or `NULL`.
+static lval* read_array(ireader* reader, size_t current) {
+    irecord* record = &reader->records[current];
+    larray* array = larray_new();
+
+    for (size_t i = 0; i < record->count; i++) {
+        lval* item = read_word(reader, record->offset + i, current, false);
+        if (item == NULL) {
+            larray_del(array);
+            return NULL;
+        }
+
+        larray_push(array, lval_ref(item));
+    }
+
+    return lval_array(array);
+}
+
+/// Create the lambda of an #IMAGE_LAMBDA record or `NULL`.
+static lval* read_lambda(ireader* reader, size_t current) {
+    irecord* record = &reader->records[current];
+    if (record->count != 3) {
+        return NULL;
+    }
+
+    lval* formals = read_word(reader, record->offset, current, false);
+    lval* body    = read_word(reader, record->offset + 1, current, false);
+    lenv* env     = read_word(reader, record->offset + 2, current, true);
+    if (formals == NULL || body == NULL || env == NULL
+            || !is_formals(formals) || body->type != LVAL_QEXPR) {
+        return NULL;
+    }
+
+    // The VM compiles it again on its first call
+    lval* node = lval_new();
+    node->type    = LVAL_FUNC;
+    node->builtin = NULL;
+    node->env     = lenv_ref(env);
+    node->formals = lval_ref(formals);
+    node->body    = lval_ref(body);
+    node->code    = NULL;
+
+    return node;
+}
+
+/// Create the sequence of an #IMAGE_SEQ record or `NULL`.
+static lval* read_seq(ireader* reader, size_t current) {
+    irecord* record = &reader->records[current];
+    if (record->count != IMAGE_SEQ_WORDS) {
+        return NULL;
+    }
+
+    uint32_t* words = reader->words + record->offset;
+    lval* source = words[1] == IMAGE_NONE ? NULL : read_word(reader, record->offset + 1, current, false);
+    lval* func   = words[2] == IMAGE_NONE ? NULL : read_word(reader, record->offset + 2, current, false);
+
+    uint64_t range[3];
+    for (size_t i = 0; i < 3; i++) {
+        range[i] = words[3 + 2 * i] | (uint64_t) words[4 + 2 * i] << 32;
+    }
+
+    // Only the fields the kind uses may be set
+    switch (words[0]) {
+        case LSEQ_RANGE:
+            if (source || func || range[2] == 0) {
+                return NULL;
+            }
+            return lval_seq(lseq_range((PRECISION_INT) range[0], (PRECISION_INT) range[1],
+                                       (PRECISION_INT) range[2]));
+        case LSEQ_LIST:
+        case LSEQ_LINES:
+            if (!source || func || source->type != (words[0] == LSEQ_LIST ? LVAL_QEXPR : LVAL_STR)) {
+                return NULL;
+            }
+            return lval_seq(lseq_new(words[0], lval_ref(source), NULL));
+        case LSEQ_MAP:
+        case LSEQ_FILTER:
+        case LSEQ_TAKE_WHILE:
+            if (!source || !func || source->type != LVAL_SEQ || func->type != LVAL_FUNC) {
+                return NULL;
+            }
+            return lval_seq(lseq_new(words[0], lval_ref(source), lval_ref(func)));
+        default:
+            return NULL;
+    }
+}
+
+/// Create the value of a record, `NULL` if it's invalid.
+static lval* read_value(ireader* reader, size_t current) {
+    irecord* record = &reader->records[current];
+    char* str;
+
+    switch (record->kind) {
+        case IMAGE_INT:
+            return lval_int(record->integer);
+        case IMAGE_BIG: {
+            str = read_string(reader, record->offset, record->count);
+            lbig* big = str ? lbig_from_str(str, record->count) : NULL;
+            return big ? lval_big(big) : NULL;
+        }
+        case IMAGE_NUM:
+            return lval_num(record->num);
+        case IMAGE_INTS:
+        case IMAGE_FLOATS: {
+            bool integers = record->kind == IMAGE_INTS;
+            size_t size = integers ? sizeof(PRECISION_INT) : sizeof(PRECISION_FLOAT);
+
+            str = read_string(reader, record->offset, record->count);
+            if (str == NULL || record->count % size != 0) {
+                return NULL;
+            }
+
+            // Strings aren't aligned for the items
+            lvec* vec = lvec_new(integers, record->count / size);
+            memcpy(integers ? (void*) vec->ints : (void*) vec->floats, str, record->count);
+            return lval_vec(vec);
+        }
+        case IMAGE_SYM:
+            str = read_string(reader, record->offset, record->count);
+            return str ? lval_sym(str) : NULL;
+        case IMAGE_STR:
+            str = read_string(reader, record->offset, record->count);
+            return str ? lval_str_len(str, record->count) : NULL;
+        case IMAGE_ERR:
+            str = read_string(reader, record->offset, record->count);
+            return str ? lval_err("%s", str) : NULL;
+        case IMAGE_BUILTIN: {
+            str = read_string(reader, record->offset, record->count);
+            if (str == NULL) {
+                return NULL;
+            }
+
+            lval* sym  = lval_sym(str);
+            lval* func = lenv_get(reader->builtins, sym);
+            lval_del(sym);
+
+            if (func->type != LVAL_FUNC || func->builtin == NULL) {
+                lval_del(func);
+                return NULL;
+            }
+            return func;
+        }
+        case IMAGE_SEXPR:
+        case IMAGE_QEXPR:
+            return read_list(reader, current);
+        case IMAGE_LAMBDA:
+            return read_lambda(reader, current);
+        case IMAGE_SEQ:
+            return read_seq(reader, current);
+        case IMAGE_DICT:
+        case IMAGE_SET:
+            return read_dict(reader, current);
+        case IMAGE_ARRAY:
+            return read_array(reader, current);
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Create the objects of all records of an image.
+ *
+ * \param reader    The reader, with the objects created so far.
+ * \param target    The environment to load the bindings into.
+ *
+ * \returns The reason the image is invalid or `NULL`.
+ */
+static char* read_records(ireader* reader, lenv* target) {
+    if (reader->count == 0 || reader->records[reader->count - 1].kind != IMAGE_ENV) {
+        return "No environment saved";
+    }
+
+    for (size_t i = 0; i < reader->count; i++) {
+        irecord* record = &reader->records[i];
+        bool words = record->kind == IMAGE_SEXPR || record->kind == IMAGE_QEXPR
+            || record->kind == IMAGE_LAMBDA || record->kind == IMAGE_SEQ
+            || record->kind == IMAGE_DICT || record->kind == IMAGE_SET
+            || record->kind == IMAGE_ARRAY
+            || record->kind == IMAGE_ENV;
+
+        if (words && (record->offset > reader->word_count
+                      || record->count > reader->word_count - record->offset)) {
+            return "Invalid record";
+        }
+
+        if (record->kind == IMAGE_ENV) {
+            reader->objects[i] = read_env(reader, i, target);
+        } else {
+            reader->objects[i] = read_value(reader, i);
+        }
+
+        if (reader->objects[i] == NULL) {
+            return "Invalid record";
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Map a file into memory or read it if it can't be mapped.
+ *
+ * \param file      The file.
+ * \param size      [out] The size of the file.
+ * \param mapped    [out] Whether the file has been mapped.
+ *
+ * \returns The contents of the file or `NULL` on an error.
+ */
+static char* map_file(FILE* file, size_t* size, bool* mapped) {
+#if ! defined _WIN32
+    struct stat info;
+    if (fstat(fileno(file), &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE,
+                             fileno(file), 0);
+        if (mapping != MAP_FAILED) {
+            *size   = (size_t) info.st_size;
+            *mapped = true;
+            return mapping;
+        }
+    }
+#endif
+
+    *mapped = false;
+    *size   = 0;
+
+    size_t capacity = 4096;
+    char* data = xmalloc(capacity);
+    size_t n;
+    while ((n = fread(data + *size, 1, capacity - *size, file)) > 0) {
+        *size += n;
+        if (*size == capacity) {
+            capacity *= 2;
+            data = xrealloc(data, capacity);
+        }
+    }
+
+    if (ferror(file)) {
+        xfree(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+lval* image_load(lenv* env, char* filename) {
+    ASSERT_NOT_NULL(env);
+    ASSERT_NOT_NULL(filename);
+
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        return lval_err("Unable to open image: %s", filename);
+    }
+
+    size_t size;
+    bool mapped;
+    char* data = map_file(file, &size, &mapped);
+    fclose(file);
+
+    if (data == NULL) {
+        return lval_err("Unable to read image: %s", filename);
+    }
+
+    iheader* header = (iheader*) data;
+    char* error = NULL;
+
+    if (size < sizeof(iheader) || memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic)) != 0) {
+        error = "Not an image";
+    } else if (header->version != IMAGE_VERSION || header->byte_order != IMAGE_BYTE_ORDER) {
+        error = "Incompatible image version or platform";
+    } else {
+        size_t available = size - sizeof(iheader);
+        if (header->records > available / sizeof(irecord)
+                || header->words > (available - header->records * sizeof(irecord)) / sizeof(uint32_t)
+                || header->strings != available - header->records * sizeof(irecord)
+                                                - header->words * sizeof(uint32_t)) {
+            error = "Truncated image";
+        }
+    }
+
+    if (error == NULL) {
+        ireader reader;
+        reader.records    = (irecord*) (data + sizeof(iheader));
+        reader.count      = header->records;
+        reader.words      = (uint32_t*) (reader.records + reader.count);
+        reader.word_count = header->words;
+        reader.strings    = (char*) (reader.words + reader.word_count);
+        reader.length     = header->strings;
+        reader.objects    = xmalloc(sizeof(void*) * (reader.count + 1));
+        reader.builtins   = lenv_new();
+        builtins_init(reader.builtins);
+
+        for (size_t i = 0; i < reader.count; i++) {
+            reader.objects[i] = NULL;
+        }
+
+        error = read_records(&reader, env);
+
+        // Drop the references of the table, the objects still in use are
+        // referred to by the environment
+        for (size_t i = 0; i < reader.count - (error ? 0 : 1); i++) {
+            if (reader.objects[i] == NULL) {
+                break;
+            } else if (reader.records[i].kind == IMAGE_ENV) {
+                lenv_del(reader.objects[i]);
+            } else {
+                lval_del(reader.objects[i]);
+            }
+        }
+
+        lenv_del(reader.builtins);
+        xfree(reader.objects);
+    }
+
+#if ! defined _WIN32
+    if (mapped) {
+        munmap(data, size);
+    } else {
+        xfree(data);
+    }
+#else
+    xfree(data);
+#endif
+
+    if (error) {
+        return lval_err("Unable to load image %s: %s", filename, error);
+    }
+
+    return lval_sexpr();
+}
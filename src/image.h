@@ -0,0 +1,53 @@
+/**
+ * \file    image.h
+ * \brief   Saves the global environment to an image file and restores it.
+ *
+ * Loading a library from source parses and evaluates all of its definitions
+ * again on every start. An image contains the bindings of an environment
+ * after they have been defined, so they can be restored without the reader
+ * or the evaluator.
+ *
+ * An image is a table of fixed-size records, one for each value or
+ * environment. Records refer to other records (the items of a list, the
+ * formals, body and frame of a lambda, ...) by their index, and only to
+ * records written before them. The table is mapped into memory when it's
+ * loaded and the indices are relocated to the objects created for the
+ * records, so values shared in the saved environment are shared again after
+ * loading. Strings and symbol names are stored after the table, builtin
+ * functions by their name (see #builtins_init). Compiled code isn't saved,
+ * the VM compiles the lambdas again on their first call.
+ *
+ * Images store numbers and indices in the byte order and format of the
+ * machine writing them, they can only be loaded on the same platform.
+ */
+#pragma once
+
+#include "lval.h"
+#include "lenv.h"
+
+
+/// The version of the image format, increased on incompatible changes.
+#define IMAGE_VERSION 7
+
+/**
+ * Save the bindings of an environment to an image file.
+ *
+ * \param env       The environment to save.
+ * \param filename  The image file to write.
+ *
+ * \returns An empty S-Expression or an error.
+ */
+lval* image_save(lenv* env, char* filename);
+
+/**
+ * Load the bindings of an image file into an environment.
+ *
+ * The bindings replace those of the environment with the same name.
+ *
+ * \param env       The environment to load the image into, usually created
+ *                  with #builtins_init.
+ * \param filename  The image file to read (see #image_save).
+ *
+ * \returns An empty S-Expression or an error.
+ */
+lval* image_load(lenv* env, char* filename);
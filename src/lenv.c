@@ -1,78 +1,247 @@
 #include "utils.h"
+#include "alloc.h"
 #include "lenv.h"
+#include "gc.h"
 
 
+/// Allocate an uninitialized environment.
+static lenv* lenv_alloc(void) {
+#if defined MLISP_GC
+    return gc_alloc(GC_LENV, sizeof(lenv));
+#else
+    return lalloc(sizeof(lenv));
+#endif
+}
+
 lenv* lenv_new(void) {
-    lenv* env = xmalloc(sizeof(lenv));
-    env->parent = NULL;
-    env->values = hash_new();
+    lenv* env = lenv_alloc();
+    env->refcount = 1;
+    env->parent  = NULL;
+    env->values  = kh_init(lenv);
+    env->formals = NULL;
+    env->slots   = NULL;
+    env->bound   = 0;
+
+    return env;
+}
+
+lenv* lenv_new_frame(lval* formals) {
+    lenv* env = lenv_alloc();
+    env->refcount = 1;
+    env->parent  = NULL;
+    env->values  = NULL;
+    env->formals = lval_ref(formals);
+    env->slots   = lalloc(LVAL_PTR_SIZE * formals->count);
+    env->bound   = 0;
+
+    for (size_t i = 0; i < formals->count; i++) {
+        env->slots[i] = NULL;
+    }
+
+    return env;
+}
+
+lenv* lenv_extend(lenv* frame) {
+    ASSERT_NOT_NULL(frame->formals);
+
+    lenv* env = lenv_new_frame(frame->formals);
+    env->bound = frame->bound;
+
+    for (size_t i = 0; i < frame->bound; i++) {
+        env->slots[i] = frame->slots[i] ? lval_ref(frame->slots[i]) : NULL;
+    }
+
+    return env;
+}
+
+lenv* lenv_ref(lenv* env) {
+    ASSERT_NOT_NULL(env);
 
+    env->refcount++;
     return env;
 }
 
 void lenv_del(lenv* env) {
-    hash_each(env->values, {
-        // Delete the value
+    ASSERT_NOT_NULL(env);
+    ASSERTF(env->refcount > 0, "lenv already deleted");
+
+    // Still shared with other owners
+    if (--env->refcount > 0) {
+        return;
+    }
+
+#if defined MLISP_GC
+    // Unreachable environments are freed by the collector itself
+    if (gc_sweeping()) {
+        return;
+    }
+#endif
+
+    lenv_clear(env);
+    lenv_free(env);
+}
+
+void lenv_clear(lenv* env) {
+    if (env->parent) {
+        lenv_del(env->parent);
+        env->parent = NULL;
+    }
+
+    // Drop the references to the values
+    lenv_each(env, {
         lval_del(val);
-        // Free memory allocated in lenv_put by calling strdup
-        xfree((char*) key);
     });
-    hash_free(env->values);
 
-    xfree(env);
+    if (env->formals) {
+        for (size_t i = 0; i < env->formals->count; i++) {
+            if (env->slots[i]) {
+                lval_del(env->slots[i]);
+                env->slots[i] = NULL;
+            }
+        }
+    }
+}
+
+void lenv_free(lenv* env) {
+    if (env->values) {
+        kh_destroy(lenv, env->values);
+    }
+
+    if (env->formals) {
+        lfree(env->slots, LVAL_PTR_SIZE * env->formals->count);
+        lval_del(env->formals);
+    }
+
+#if defined MLISP_GC
+    gc_free(GC_LENV, env);
+#else
+    lfree(env, sizeof(lenv));
+#endif
 }
 
 lenv* lenv_copy(lenv* env) {
-    lenv* copy = lenv_new();
-
-    // FIXME: I suspect copying every single variable into the new env makes
-    // it very slow (?) to search for a variable because for every single parent
-    // we encounter the same variables again...
-    // Do a good profiling on this to verify this hypothesis!
-
-    //if (env->parent) {
-    hash_each(env->values, {
-        //if (!hash_has(env->parent->values, strdup(key))) {
-        hash_set(copy->values, strdup(key), lval_copy(val));
-        //}
+    lenv* copy;
+
+    if (env->formals) {
+        copy = lenv_new_frame(env->formals);
+        copy->bound = env->bound;
+
+        for (size_t i = 0; i < env->formals->count; i++) {
+            copy->slots[i] = env->slots[i] ? lval_ref(env->slots[i]) : NULL;
+        }
+
+        if (env->values == NULL) {
+            return copy;
+        }
+
+        copy->values = kh_init(lenv);
+    } else {
+        copy = lenv_new();
+    }
+
+    int ret;
+    lenv_each(env, {
+        khiter_t slot = kh_put(lenv, copy->values, key, &ret);
+        kh_value(copy->values, slot) = lval_ref(val);
     });
-    //}
 
     return copy;
 }
 
+/**
+ * Find the slot of a bound formal argument.
+ *
+ * Later formals shadow earlier ones with the same name.
+ *
+ * \returns The slot or `NULL` if the name isn't bound in a slot.
+ */
+static lval** lenv_slot(lenv* env, char* name) {
+    if (env->formals == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = env->formals->count; i-- > 0;) {
+        if (env->formals->values[i]->sym == name && env->slots[i]) {
+            return &env->slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+/// Whether all bindings of `env` are shadowed by the formals of `frame`.
+static bool lenv_shadowed(lenv* env, lenv* frame) {
+    if (env->formals == NULL || env->values != NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < env->formals->count; i++) {
+        if (env->slots[i] && !lenv_slot(frame, env->formals->values[i]->sym)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void lenv_set_caller(lenv* frame, lenv* caller) {
+    ASSERTF(frame->parent == NULL, "frame already has a parent");
+
+    // Variables of the caller hidden by the frame's arguments can't be
+    // looked up through the frame
+    while (caller->parent && lenv_shadowed(caller, frame)) {
+        caller = caller->parent;
+    }
+
+    frame->parent = lenv_ref(caller);
+}
+
 lval* lenv_get(lenv* env, lval* name) {
     do {
-        lval* value = hash_get(env->values, name->sym);
-        if (value) { return lval_copy(value); }
+        lval** slot = lenv_slot(env, name->sym);
+        if (slot) {
+            return lval_ref(*slot);
+        }
+
+        if (env->values) {
+            khiter_t k = kh_get(lenv, env->values, name->sym);
+            if (k != kh_end(env->values)) {
+                return lval_ref(kh_value(env->values, k));
+            }
+        }
     } while ((env = env->parent) != NULL);
 
     return lval_err("Unbound symbol: '%s'", name->sym);
 }
 
 void lenv_put(lenv* env, lval* name, lval* value) {
-    // Keep in mind: The hash table stores a pointer to the key and
-    // a pointer to the value.
-    char* key;
-    if (!hash_has(env->values, name->sym)) {
-        // The hash table needs a pointer to the key. We can't just
-        // use 'name->sym' because 'name' will propably be deleted
-        // soon so we store a copy of it instead.
-        key = strdup(name->sym);
-    } else {
-        // The key already exists. In this case we don't need to copy
-        // the key because the stored on will remain untouched by 'hash_set'.
-        key = name->sym;
+    // The value is shared with the caller, not copied
+    lval_ref(value);
+
+    lval** slot = lenv_slot(env, name->sym);
+    if (slot) {
+        lval_del(*slot);
+        *slot = value;
+        return;
+    }
+
+    if (env->values == NULL) {
+        env->values = kh_init(lenv);
+    }
+
+    // Keep in mind: The hash table stores the interned symbol name as key,
+    // which is never deallocated, and a pointer to the value.
+    int ret;
+    khiter_t k = kh_put(lenv, env->values, name->sym, &ret);
 
+    if (ret == 0) {
         // If the key already exists, we have to remove the old value
         // manually because otherwise we loose the pointer to it and
         // we have a memory leak.
-        lval* old_value = hash_get(env->values, key);
-        lval_del(old_value);
+        lval_del(kh_value(env->values, k));
     }
 
-    hash_set(env->values, key, lval_copy(value));
-    ASSERTF(hash_has(env->values, key), "insert failed");
+    kh_value(env->values, k) = value;
 }
 
 void lenv_def(lenv* env, lval* name, lval* value) {
@@ -85,10 +254,9 @@ void lenv_def(lenv* env, lval* name, lval* value) {
 }
 
 char* lenv_func_name(lenv* env, lbuiltin func) {
-    hash_each(env->values, {
-        lval* value = val;
-        if (value->type == LVAL_FUNC && value->builtin == func) {
-            return (char*) key;
+    lenv_each(env, {
+        if (val->type == LVAL_FUNC && val->builtin == func) {
+            return key;
         }
     });
 
@@ -4,19 +4,60 @@
 */
 #pragma once
 
+#include "lval.h"
+
 #if defined MLISP_NOINCLUDE
-    typedef struct hash_t hash_t;
+    typedef struct kh_lenv_s kh_lenv_t;
 #else
-    #include "hash.h"
-#endif
+    #include <stdint.h>
+    #include "khash.h"
 
-#include "lval.h"
+    /// Hash an interned symbol name by its address.
+    #define lenv_hash_func(key) kh_int64_hash_func((khint64_t) (uintptr_t) (key))
+
+    /// Compare interned symbol names by their address.
+    #define lenv_hash_equal(a, b) ((a) == (b))
 
+    KHASH_INIT(lenv, char*, lval*, 1, lenv_hash_func, lenv_hash_equal)
 
-/// Contains an environment.
+    /**
+     * Iterate over the bindings of an environment, populating `key` and `val`.
+     */
+    #define lenv_each(env, block) { \
+        if (env->values) \
+        for (khiter_t k = kh_begin(env->values); k != kh_end(env->values); k++) { \
+            if (!kh_exist(env->values, k)) continue; \
+            char* key = kh_key(env->values, k); \
+            lval* val = kh_value(env->values, k); \
+            UNUSED(key); UNUSED(val); \
+            block; \
+        } \
+    }
+#endif
+
+
+/**
+ * Contains an environment.
+ *
+ * The environment of a lambda function is a frame: its formal arguments are
+ * resolved to slots when the lambda is created, so binding an argument or
+ * looking it up is an index into a small array. Other variables defined in
+ * a frame (with `=`) are stored in a hash table that is created on demand.
+ *
+ * Environments are shared by reference counting. The frame of a lambda
+ * function only holds its partially applied arguments and is never modified;
+ * every call binds the arguments in a new frame (see #lenv_extend).
+ */
 typedef struct lenv {
-    lenv* parent;   ///< The parent enrivonment.
-    hash_t* values; ///< The values in this environment.
+    size_t refcount;    ///< The number of owners sharing this environment.
+    lenv* parent;       ///< The parent enrivonment.
+    kh_lenv_t* values;  ///< The values in this environment, keyed by the
+                        ///< interned symbol name (may be `NULL` in frames).
+
+    lval* formals;      ///< The formal arguments of a frame or `NULL`.
+    lval** slots;       ///< The value of each formal argument (`NULL` if
+                        ///< not bound yet).
+    size_t bound;       ///< The number of formals already bound.
 } lenv;
 
 
@@ -34,21 +75,74 @@ typedef struct lenv {
 */
 lenv* lenv_new(void);
 
+/**
+ * Create the environment of a lambda function.
+ *
+ * Create a frame with one slot for each formal argument. The position of a
+ * symbol in `formals` is its slot index (the slot of `...` is never used).
+ *
+ * \param formals   The formal arguments (shared, not copied).
+ *
+ * \returns A pointer to the new environment.
+ */
+lenv* lenv_new_frame(lval* formals);
+
+/**
+ * Create a frame that continues binding the arguments of another one.
+ *
+ * The new frame shares the formals and the values of the arguments already
+ * bound in `frame`. Nothing else is copied.
+ *
+ * \param frame The frame to extend (see #lenv_new_frame).
+ *
+ * \returns A pointer to the new environment.
+ */
+lenv* lenv_extend(lenv* frame);
+
 /**
  * Delete an environment.
  *
- * Delete an environment by first removing all values stored in it and then
- * the environment itself.
+ * Drop one reference to an environment. When the last reference is dropped,
+ * delete it by first removing all values stored in it and then the
+ * environment itself.
  *
  * \param env   The environment to remove.
  */
 void lenv_del(lenv* env);
 
+/**
+ * Share an environment.
+ *
+ * \param env   The environment to share.
+ * \returns The same environment.
+ */
+lenv* lenv_ref(lenv* env);
+
+/**
+ * Drop the references of an environment to its parent and its values.
+ *
+ * Only used by #lenv_del and the garbage collector (see gc.h).
+ *
+ * \param env   The environment whose references to drop.
+ */
+void lenv_clear(lenv* env);
+
+/**
+ * Free the memory owned by an environment.
+ *
+ * Free the hash table, the slots and the environment itself, without
+ * dropping the references to the values (see #lenv_clear). Only used by
+ * #lenv_del and the garbage collector (see gc.h).
+ *
+ * \param env   The environment to free.
+ */
+void lenv_free(lenv* env);
+
 /**
  * Copy an environment.
  *
- * Copy an environment by creating a new one and copying all the values.
- * The new environment will be a child of the original one.
+ * Copy an environment by creating a new one with all the bindings (and the
+ * slots) of the original one. The values themselves are shared, not copied.
  *
  * \todo Rename to something more intuitive (create a child...)
  *
@@ -62,22 +156,26 @@ lenv* lenv_copy(lenv* env);
 /**
  * Search the environment for a variable with a given name.
  *
- * Get a value from an environment. If it is not found, search in the parent
- * environment. If this fails, return a #lval_err.
+ * Get a value from an environment, searching the bound slots first and then
+ * the other bindings. If it is not found, search in the parent environment.
+ * If this fails, return a #lval_err.
  *
- * \warning Returns a copy of the value that has to be memory-managed, too!
+ * \warning Returns a shared reference to the value that has to be
+ *          memory-managed, too! Use #lval_unshare before modifying it.
  *
  * \param env   The envionment where to start searching.
  * \param name  The name of the variable to search.
  *
- * \returns A copy of the value stored in the environment.
+ * \returns The value stored in the environment.
  */
 lval* lenv_get(lenv* env, lval* name);
 
 /**
  * Store a value in an environment.
  *
- * Store the copy of the given value in given environment.
+ * Store the given value in given environment. If the name is a formal
+ * argument of a frame, the value goes to its slot. The value is shared with
+ * the caller, the environment adds a reference to it.
  *
  * \param env   The environment where to store the value.
  * \param name  The name of the variable.
@@ -97,6 +195,19 @@ void lenv_put(lenv* env, lval* name, lval* value);
  */
 void lenv_def(lenv* env, lval* name, lval* value);
 
+/**
+ * Link a call frame to the environment of its caller.
+ *
+ * mlisp is dynamically scoped: a function can access the variables of its
+ * caller. Caller frames whose bindings are all shadowed by the formals of
+ * `frame` are skipped, so recursive functions don't build long chains of
+ * environments. The frame keeps a reference to its parent.
+ *
+ * \param frame     The frame of the called function (see #lenv_extend).
+ * \param caller    The environment the function is called from.
+ */
+void lenv_set_caller(lenv* frame, lenv* caller);
+
 /**
  * Get the name of a builtin function.
  *
@@ -105,7 +216,7 @@ void lenv_def(lenv* env, lval* name, lval* value);
  * \param env   Where to search for the function.
  * \param func  The function to search.
  *
- * \returns A copy of the function name. Has to be cleaned up!
+ * \returns The interned function name.
  * \retval  NULL    The function is not defined in this environment.
  */
 char* lenv_func_name(lenv* env, lbuiltin func);
@@ -1,13 +1,26 @@
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "utils.h"
+#include "alloc.h"
+#include "symbol.h"
 #include "lval.h"
+#include "lenv.h"
+#include "gc.h"
 
 #if defined DEBUG
     static long allocated_count = 0;
     static long deallocated_count = 0;
 #endif
 
+/// The number of small integers (see #lval_int).
+#define SMALL_INT_COUNT (LVAL_SMALL_INT_MAX - LVAL_SMALL_INT_MIN + 1)
+
+/// The numbers shared by all uses of a small integer.
+static lval small_ints[SMALL_INT_COUNT];
+static bool small_ints_ready = false;
+
 
 /// Wether a node is a list-like object.
 bool is_list_like(lval* node) {
@@ -57,12 +70,228 @@ char* lval_str_func(lenv* env, lval* func);
  */
 char* lval_str_str(lenv* env, lval* node);
 
+/**
+ * Return the string representation of a float.
+ *
+ * Floats with an integral value are written with a decimal point (`2.0`),
+ * so they can be told apart from integers.
+ *
+ * \param node  The float object to stringify.
+ *
+ * \returns A char pointer containing the string. Has to be cleaned up!
+ */
+char* lval_str_num(lval* node);
+
+/**
+ * Return the string representation of a vector.
+ *
+ * The items are written like numbers between brackets: `[1 2 3]`.
+ *
+ * \param node  The vector object to stringify.
+ *
+ * \returns A char pointer containing the string. Has to be cleaned up!
+ */
+char* lval_str_vec(lval* node);
+
 
 lval* lval_new(void) {
 #if defined DEBUG
     allocated_count += 1;
 #endif
-    return xmalloc(LVAL_SIZE);
+#if defined MLISP_GC
+    lval* node = gc_alloc(GC_LVAL, LVAL_SIZE);
+#else
+    lval* node = lalloc(LVAL_SIZE);
+#endif
+    node->refcount = 1;
+
+    return node;
+}
+
+/// Get the allocation size of a storage for `capacity` values.
+static size_t lbuf_size(size_t capacity) {
+    return sizeof(lbuf) + LVAL_PTR_SIZE * capacity;
+}
+
+/// Allocate an empty storage for `capacity` values.
+static lbuf* lbuf_new(size_t capacity) {
+    lbuf* buf = lalloc(lbuf_size(capacity));
+    buf->refcount = 1;
+    buf->capacity = capacity;
+    buf->first    = 0;
+    buf->used     = 0;
+
+    return buf;
+}
+
+void lbuf_del(lbuf* buf) {
+    ASSERT_NOT_NULL(buf);
+
+    if (--buf->refcount > 0) {
+        return;
+    }
+
+    for (size_t i = buf->first; i < buf->used; i++) {
+        lval_del(buf->items[i]);
+    }
+
+    lfree(buf, lbuf_size(buf->capacity));
+}
+
+/// Get the allocation size of a string storage for `capacity` characters.
+static size_t lstrbuf_size(size_t capacity) {
+    return sizeof(lstrbuf) + capacity + 1;
+}
+
+/// Allocate a string storage holding `length` characters, with room for
+/// `capacity` in total.
+static lstrbuf* lstrbuf_new(char* chars, size_t length, size_t capacity) {
+    lstrbuf* strbuf = lalloc(lstrbuf_size(capacity));
+    strbuf->refcount = 1;
+    strbuf->capacity = capacity;
+    strbuf->used     = length;
+    memcpy(strbuf->chars, chars, length);
+    strbuf->chars[length] = '\0';
+
+    return strbuf;
+}
+
+/// Drop a reference to a string storage, delete it when it's the last one.
+static void lstrbuf_del(lstrbuf* strbuf) {
+    if (--strbuf->refcount == 0) {
+        lfree(strbuf, lstrbuf_size(strbuf->capacity));
+    }
+}
+
+/// Point a new string at characters of a storage (the reference is moved to
+/// the string).
+static lval* str_from(lstrbuf* strbuf, char* str, size_t length) {
+    lval* node = lval_new();
+    node->type   = LVAL_STR;
+    node->str    = str;
+    node->length = length;
+    node->strbuf = strbuf;
+
+    return node;
+}
+
+/**
+ * Make sure a list has storage of its own with room for more values.
+ *
+ * Afterwards, the list is the only one using its storage, the storage only
+ * owns the list's values and there is room for `front` values in front of
+ * them and `back` values after them. When the storage has to be reallocated,
+ * its capacity is doubled.
+ *
+ * \param list  The list, must not be shared.
+ * \param front The number of values to make room for in front.
+ * \param back  The number of values to make room for at the end.
+ */
+static void list_reserve(lval* list, size_t front, size_t back) {
+    lbuf* buf = list->buf;
+    bool exclusive = buf && buf->refcount == 1;
+
+    if (exclusive) {
+        size_t start = (size_t) (list->values - buf->items);
+
+        // Release the values only slices of the list have been using
+        for (size_t i = buf->first; i < start; i++) {
+            lval_del(buf->items[i]);
+        }
+        for (size_t i = start + list->count; i < buf->used; i++) {
+            lval_del(buf->items[i]);
+        }
+        buf->first = start;
+        buf->used  = start + list->count;
+
+        if (start >= front && buf->used + back <= buf->capacity) {
+            return;
+        }
+    } else if (!buf && front + back == 0) {
+        // Nothing to own
+        return;
+    }
+
+    size_t needed = list->count + front + back;
+    size_t capacity = front + back > 0 ? needed * 2 : needed;
+    if (capacity < LBUF_MIN_CAPACITY) {
+        capacity = LBUF_MIN_CAPACITY;
+    }
+
+    // Keep the spare room where values are going to be added
+    lbuf* own = lbuf_new(capacity);
+    own->first = front > 0 ? capacity - list->count - back : 0;
+    own->used  = own->first + list->count;
+
+    if (list->count > 0) {
+        memcpy(&own->items[own->first], list->values, LVAL_PTR_SIZE * list->count);
+    }
+
+    if (exclusive) {
+        // The references are moved
+        buf->used = buf->first;
+    } else {
+        for (size_t i = own->first; i < own->used; i++) {
+            lval_ref(own->items[i]);
+        }
+    }
+    if (buf) {
+        lbuf_del(buf);
+    }
+
+    list->buf    = own;
+    list->values = &own->items[own->first];
+}
+
+/**
+ * Get a list that may be modified, with room for values around it.
+ *
+ * Like #lval_unshare followed by #list_reserve, but if the list is shared
+ * and ends where the values owned by its storage end (or starts where they
+ * start), the storage is only copied if it has no spare room left. Otherwise
+ * the new values go into the spare room, where no other list sharing the
+ * storage sees them. That way, adding values to a list that is still
+ * referenced (like by a variable) doesn't copy all of its values.
+ *
+ * Afterwards, the caller has to add the values and update the owned range
+ * of the storage, like #lval_add and #lval_prepend do.
+ *
+ * \param list  The list (the caller's reference is moved to the result).
+ * \param front The number of values to make room for in front.
+ * \param back  The number of values to make room for at the end.
+ *
+ * \returns The list to modify.
+ */
+static lval* list_own(lval* list, size_t front, size_t back) {
+    lbuf* buf = list->buf;
+
+    if (buf && (list->refcount > 1 || buf->refcount > 1)) {
+        size_t start = (size_t) (list->values - buf->items);
+        bool room_back  = back == 0
+                          || (start + list->count == buf->used && buf->used + back <= buf->capacity);
+        bool room_front = front == 0 || (start == buf->first && start >= front);
+
+        if (room_back && room_front) {
+            if (list->refcount > 1) {
+                lval* copy = lval_new();
+                copy->type   = list->type;
+                copy->count  = list->count;
+                copy->values = list->values;
+                copy->buf    = buf;
+                buf->refcount++;
+
+                // Drop the caller's reference to the shared list
+                list->refcount--;
+                list = copy;
+            }
+            return list;
+        }
+    }
+
+    list = lval_unshare(list);
+    list_reserve(list, front, back);
+
+    return list;
 }
 
 lval* lval_sexpr(void) {
@@ -70,6 +299,23 @@ lval* lval_sexpr(void) {
     node->type = LVAL_SEXPR;
     node->count = 0;
     node->values = NULL;
+    node->buf = NULL;
+
+    return node;
+}
+
+lval* lval_sexpr_from(lval** values, size_t count) {
+    lval* node = lval_sexpr();
+    if (count == 0) {
+        return node;
+    }
+
+    node->buf = lbuf_new(count);
+    node->buf->used = count;
+    memcpy(node->buf->items, values, LVAL_PTR_SIZE * count);
+
+    node->count = count;
+    node->values = node->buf->items;
 
     return node;
 }
@@ -79,6 +325,7 @@ lval* lval_qexpr(void) {
     node->type = LVAL_QEXPR;
     node->count = 0;
     node->values = NULL;
+    node->buf = NULL;
 
     return node;
 }
@@ -88,7 +335,49 @@ lval* lval_sym(char* symbol) {
 
     lval* node = lval_new();
     node->type = LVAL_SYM;
-    node->sym = strdup(symbol);
+    node->sym = symbol_intern(symbol);
+
+    return node;
+}
+
+/// Create the shared small integers. They are never freed.
+static void small_ints_init(void) {
+    for (int i = 0; i < SMALL_INT_COUNT; i++) {
+        small_ints[i].type = LVAL_INT;
+        small_ints[i].integer = i + LVAL_SMALL_INT_MIN;
+
+        // Dropping all references never brings it to zero
+        small_ints[i].refcount = SIZE_MAX / 2;
+    }
+
+    small_ints_ready = true;
+}
+
+lval* lval_int(PRECISION_INT value) {
+    if (value >= LVAL_SMALL_INT_MIN && value <= LVAL_SMALL_INT_MAX) {
+        if (!small_ints_ready) {
+            small_ints_init();
+        }
+        return lval_ref(&small_ints[value - LVAL_SMALL_INT_MIN]);
+    }
+
+    lval* node = lval_new();
+    node->type = LVAL_INT;
+    node->integer = value;
+
+    return node;
+}
+
+lval* lval_big(lbig* value) {
+    PRECISION_INT integer;
+    if (lbig_to_int(value, &integer)) {
+        lbig_del(value);
+        return lval_int(integer);
+    }
+
+    lval* node = lval_new();
+    node->type = LVAL_BIG;
+    node->big = value;
 
     return node;
 }
@@ -101,16 +390,105 @@ lval* lval_num(PRECISION_FLOAT value) {
     return node;
 }
 
-lval* lval_str(char* str) {
-    ASSERT_NOT_NULL(str);
+lval* lval_vec(lvec* value) {
+    lval* node = lval_new();
+    node->type = LVAL_VEC;
+    node->vec = value;
+
+    return node;
+}
 
+lval* lval_seq(lseq* value) {
     lval* node = lval_new();
-    node->type = LVAL_STR;
-    node->str = strdup(str);
+    node->type = LVAL_SEQ;
+    node->seq = value;
 
     return node;
 }
 
+lval* lval_dict(ldict* value, bool set) {
+    lval* node = lval_new();
+    node->type = set ? LVAL_SET : LVAL_DICT;
+    node->dict = value;
+
+    return node;
+}
+
+lval* lval_array(larray* value) {
+    lval* node = lval_new();
+    node->type  = LVAL_ARRAY;
+    node->array = value;
+
+    return node;
+}
+
+lval* lval_str(char* str) {
+    ASSERT_NOT_NULL(str);
+
+    return lval_str_len(str, strlen(str));
+}
+
+lval* lval_str_len(char* str, size_t length) {
+    ASSERT_NOT_NULL(str);
+
+    lstrbuf* strbuf = lstrbuf_new(str, length, length);
+    return str_from(strbuf, strbuf->chars, length);
+}
+
+lval* lval_str_concat(lval** strings, size_t count) {
+    ASSERT_NOT_NULL(strings);
+
+    lval* first = strings[0];
+    size_t length = first->length;
+    for (size_t i = 1; i < count; i++) {
+        length += strings[i]->length;
+    }
+
+    lstrbuf* strbuf = first->strbuf;
+    char* end = first->str + first->length;
+    size_t start;
+
+    if (end == strbuf->chars + strbuf->used && strbuf->used + length - first->length <= strbuf->capacity) {
+        // Nothing follows the first string yet: append to it in place
+        start = (size_t) (first->str - strbuf->chars);
+        strbuf->refcount++;
+    } else {
+        // Leave as much room as the string takes for the next appends
+        start = 0;
+        strbuf = lstrbuf_new(first->str, first->length, 2 * length);
+    }
+
+    for (size_t i = 1; i < count; i++) {
+        memcpy(strbuf->chars + strbuf->used, strings[i]->str, strings[i]->length);
+        strbuf->used += strings[i]->length;
+    }
+    strbuf->chars[strbuf->used] = '\0';
+
+    return str_from(strbuf, strbuf->chars + start, length);
+}
+
+lval* lval_str_sub(lval* node, size_t start, size_t length) {
+    ASSERT_NOT_NULL(node);
+    ASSERTF(start + length <= node->length, "Substring [%zu, %zu) out of range", start, start + length);
+
+    node->strbuf->refcount++;
+    return str_from(node->strbuf, node->str + start, length);
+}
+
+char* lval_str_cstr(lval* node) {
+    ASSERT_NOT_NULL(node);
+
+    // Characters are always followed by other characters or the terminator
+    if (node->str[node->length] != '\0') {
+        lstrbuf* strbuf = lstrbuf_new(node->str, node->length, node->length);
+        lstrbuf_del(node->strbuf);
+        node->strbuf = strbuf;
+        node->str    = strbuf->chars;
+    }
+
+    return node->str;
+}
+
 lval* lval_err(char* fmt, ...) {
     ASSERT_NOT_NULL(fmt);
 
@@ -145,47 +523,144 @@ lval* lval_lambda(lval* formals, lval* body) {
     node->type = LVAL_FUNC;
 
     node->builtin = NULL;
-    node->env = lenv_new();
+    node->env = lenv_new_frame(formals);
     node->formals = formals;
     node->body = body;
+    node->code = NULL;
+
+    return node;
+}
+
+lval* lval_partial(lval* func, lenv* frame) {
+    ASSERT_NOT_NULL(func);
+    ASSERT_NOT_NULL(frame);
+
+    lval* node = lval_new();
+    node->type = LVAL_FUNC;
+
+    node->builtin = NULL;
+    node->env = frame;
+    node->formals = lval_ref(func->formals);
+    node->body = lval_ref(func->body);
+    node->code = func->code ? lcode_ref(func->code) : NULL;
+
+    lval_del(func);
 
     return node;
 }
 
 void lval_del(lval* node) {
     ASSERT_NOT_NULL(node);
+    ASSERTF(node->refcount > 0, "lval already deleted");
 
-#if defined DEBUG
-    deallocated_count += 1;
+    // Still shared with other owners
+    if (--node->refcount > 0) {
+        return;
+    }
+
+#if defined MLISP_GC
+    // Unreachable objects are freed by the collector itself
+    if (gc_sweeping()) {
+        return;
+    }
 #endif
 
+    lval_clear(node);
+    lval_free(node);
+}
+
+void lval_clear(lval* node) {
     switch(node->type) {
-        case LVAL_NUM: break;
         case LVAL_FUNC:
             if (!node->builtin) {
                 lenv_del(node->env);
                 lval_del(node->formals);
                 lval_del(node->body);
+
+                if (node->code) {
+                    lcode_del(node->code);
+                    node->code = NULL;
+                }
             }
             break;
 
-        // Types with strings
-        case LVAL_ERR: xfree(node->err); break;
-        case LVAL_SYM: xfree(node->sym); break;
-        case LVAL_STR: xfree(node->str); break;
+        case LVAL_SEQ:
+            if (node->seq->source) {
+                lval_del(node->seq->source);
+                node->seq->source = NULL;
+            }
+            if (node->seq->func) {
+                lval_del(node->seq->func);
+                node->seq->func = NULL;
+            }
+            break;
 
-        // Sexpr: Delete all elements inside
+        // Sexpr: Delete all elements inside with the storage
         case LVAL_SEXPR:
         case LVAL_QEXPR:
-            for_item(node, {
-                lval_del(item);
-            })
+            if (node->buf) {
+                lbuf_del(node->buf);
+                node->buf = NULL;
+            }
+            break;
 
-            // Free memory allocated to contain the pointers
-            if (node->values) {
-                xfree(node->values);
+        // Dictionaries and arrays: Delete the entries and items they don't
+        // share
+        case LVAL_DICT:
+        case LVAL_SET:
+            if (node->dict) {
+                ldict_del(node->dict);
+                node->dict = NULL;
             }
             break;
+
+        case LVAL_ARRAY:
+            if (node->array) {
+                larray_del(node->array);
+                node->array = NULL;
+            }
+            break;
+
+        // No references to other objects
+        case LVAL_SYM:
+        case LVAL_INT:
+        case LVAL_BIG:
+        case LVAL_NUM:
+        case LVAL_VEC:
+        case LVAL_STR:
+        case LVAL_ERR:
+            break;
+    }
+}
+
+void lval_free(lval* node) {
+#if defined DEBUG
+    deallocated_count += 1;
+#endif
+
+    switch(node->type) {
+        case LVAL_INT: break;
+        case LVAL_NUM: break;
+        case LVAL_FUNC: break;
+        case LVAL_BIG: lbig_del(node->big); break;
+        case LVAL_VEC: lvec_del(node->vec); break;
+        case LVAL_SEQ: lseq_del(node->seq); break;
+
+        // Types with strings
+        case LVAL_ERR: xfree(node->err); break;
+        case LVAL_STR: lstrbuf_del(node->strbuf); break;
+
+        // Symbol names are owned by the symbol table
+        case LVAL_SYM: break;
+
+        // The storage of the values, the entries and the items are
+        // released before
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+        case LVAL_DICT:
+        case LVAL_SET:
+        case LVAL_ARRAY:
+            break;
         default:
             ASSERTF(0, "Invalid lval type: %i", node->type);
     }
@@ -193,7 +668,127 @@ void lval_del(lval* node) {
 #if defined DEBUG
     memset(node, 0xEE, LVAL_SIZE);
 #endif
-    xfree(node);
+
+#if defined MLISP_GC
+    gc_free(GC_LVAL, node);
+#else
+    lfree(node, LVAL_SIZE);
+#endif
+}
+
+/**
+ * Copy a sequence.
+ *
+ * \param seq   The sequence to copy.
+ * \param child How to get the source and function of the copy: #lval_copy or
+ *              #lval_ref.
+ *
+ * \returns The copy.
+ */
+static lseq* seq_copy(lseq* seq, lval* (*child)(lval*)) {
+    lseq* copy = lseq_new(seq->kind, seq->source ? child(seq->source) : NULL,
+                          seq->func ? child(seq->func) : NULL);
+    copy->start = seq->start;
+    copy->end   = seq->end;
+    copy->step  = seq->step;
+
+    return copy;
+}
+
+static bool values_eq(lval* x, lval* y, bool exact);
+static int int_float_cmp(PRECISION_INT integer, PRECISION_FLOAT num);
+
+/// Check whether two sequences produce the same items the same way.
+static bool seq_eq(lseq* x, lseq* y, bool exact) {
+    return x->kind == y->kind && x->start == y->start && x->end == y->end && x->step == y->step
+           && (x->source == y->source || (x->source && y->source && values_eq(x->source, y->source, exact)))
+           && (x->func == y->func || (x->func && y->func && values_eq(x->func, y->func, exact)));
+}
+
+/// Copy the entries of a dictionary and their keys and values.
+static ldict* dict_copy(ldict* dict) {
+    ldict* copy = ldict_new();
+    ldict_iter iter;
+    lval* key;
+    lval* value;
+
+    ldict_iter_init(&iter, dict);
+    while (ldict_iter_next(&iter, &key, &value)) {
+        ldict_put(copy, lval_copy(key), value ? lval_copy(value) : NULL);
+    }
+
+    return copy;
+}
+
+/// Check whether two dictionaries have the same entries.
+static bool dict_eq(ldict* x, ldict* y, bool exact) {
+    if (x->count != y->count) {
+        return false;
+    }
+
+    ldict_iter iter;
+    lval* key;
+    lval* value;
+    lval* other;
+
+    ldict_iter_init(&iter, x);
+    while (ldict_iter_next(&iter, &key, &value)) {
+        if (!ldict_find(y, key, &other) || (value && !values_eq(value, other, exact))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Copy the items of an array.
+static larray* array_copy(larray* array) {
+    larray* copy = larray_new();
+    for (size_t i = 0; i < array->count; i++) {
+        larray_push(copy, lval_copy(larray_get(array, i)));
+    }
+
+    return copy;
+}
+
+/// Check whether two arrays have equal items.
+static bool array_eq(larray* x, larray* y, bool exact) {
+    if (x->count != y->count) {
+        return false;
+    }
+
+    for (size_t i = 0; i < x->count; i++) {
+        if (!values_eq(larray_get(x, i), larray_get(y, i), exact)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Check whether two vectors have exactly equal items (see #lval_key_eq).
+static bool vec_key_eq(lvec* x, lvec* y) {
+    if (x->count != y->count) {
+        return false;
+    }
+
+    for (size_t i = 0; i < x->count; i++) {
+        bool equal;
+        if (x->integers && y->integers) {
+            equal = x->ints[i] == y->ints[i];
+        } else if (x->integers || y->integers) {
+            equal = x->integers ? int_float_cmp(x->ints[i], y->floats[i]) == 0
+                                : int_float_cmp(y->ints[i], x->floats[i]) == 0;
+        } else {
+            equal = FLOAT_EQ(x->floats[i], y->floats[i]);
+        }
+
+        if (!equal) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 lval* lval_copy(lval* node) {
@@ -204,6 +799,25 @@ lval* lval_copy(lval* node) {
 
     switch (node->type) {
         // Copy functions and numbers directly
+        case LVAL_INT:
+            copy->integer = node->integer;
+            break;
+        case LVAL_BIG:
+            copy->big = lbig_copy(node->big);
+            break;
+        case LVAL_VEC:
+            copy->vec = lvec_copy(node->vec);
+            break;
+        case LVAL_SEQ:
+            copy->seq = seq_copy(node->seq, lval_copy);
+            break;
+        case LVAL_DICT:
+        case LVAL_SET:
+            copy->dict = dict_copy(node->dict);
+            break;
+        case LVAL_ARRAY:
+            copy->array = array_copy(node->array);
+            break;
         case LVAL_NUM:
             copy->num = node->num;
             break;
@@ -215,19 +829,31 @@ lval* lval_copy(lval* node) {
                 copy->env     = lenv_copy(node->env);
                 copy->formals = lval_copy(node->formals);
                 copy->body    = lval_copy(node->body);
+                copy->code    = node->code ? lcode_ref(node->code) : NULL;
             }
             break;
 
         // Copy strings
         case LVAL_ERR: copy->err = strdup(node->err); break;
-        case LVAL_SYM: copy->sym = strdup(node->sym); break;
-        case LVAL_STR: copy->str = strdup(node->str); break;
+        case LVAL_SYM: copy->sym = node->sym; break;
+        case LVAL_STR:
+            copy->strbuf = lstrbuf_new(node->str, node->length, node->length);
+            copy->str    = copy->strbuf->chars;
+            copy->length = node->length;
+            break;
 
         // Copy lists by copying each subexpression
         case LVAL_SEXPR:
         case LVAL_QEXPR:
             copy->count  = node->count;
-            copy->values = xmalloc(LVAL_PTR_SIZE * node->count);
+            copy->values = NULL;
+            copy->buf    = NULL;
+
+            if (node->count > 0) {
+                copy->buf = lbuf_new(node->count);
+                copy->buf->used = node->count;
+                copy->values = copy->buf->items;
+            }
 
             for_item(node, {
                 copy->values[i] = lval_copy(item);
@@ -240,26 +866,141 @@ lval* lval_copy(lval* node) {
     return copy;
 }
 
-bool lval_eq(lval* x, lval* y) {
-    ASSERT_NOT_NULL(x);
-    ASSERT_NOT_NULL(y);
+bool lval_is_static(lval* node) {
+    return node >= small_ints && node < small_ints + SMALL_INT_COUNT;
+}
+
+lval* lval_ref(lval* node) {
+    ASSERT_NOT_NULL(node);
+
+    node->refcount++;
+    return node;
+}
+
+lval* lval_unshare(lval* node) {
+    ASSERT_NOT_NULL(node);
+
+    if (node->refcount == 1) {
+        if (is_list_like(node)) {
+            list_reserve(node, 0, 0);
+        }
+        return node;
+    }
+
+    lval* copy = lval_new();
+    copy->type = node->type;
+
+    switch (node->type) {
+        case LVAL_INT:
+            copy->integer = node->integer;
+            break;
+        case LVAL_BIG:
+            copy->big = lbig_copy(node->big);
+            break;
+        case LVAL_VEC:
+            copy->vec = lvec_copy(node->vec);
+            break;
+        case LVAL_SEQ:
+            copy->seq = seq_copy(node->seq, lval_ref);
+            break;
+
+        // Share the entries and items, updates copy the nodes they change
+        case LVAL_DICT:
+        case LVAL_SET:
+            copy->dict = ldict_copy(node->dict);
+            break;
+        case LVAL_ARRAY:
+            copy->array = larray_copy(node->array);
+            break;
+        case LVAL_NUM:
+            copy->num = node->num;
+            break;
+        case LVAL_FUNC:
+            if (node->builtin) {
+                copy->builtin = node->builtin;
+            } else {
+                // Lambda environments are never modified, share it
+                copy->builtin = NULL;
+                copy->env     = lenv_ref(node->env);
+                copy->formals = lval_ref(node->formals);
+                copy->body    = lval_ref(node->body);
+                copy->code    = node->code ? lcode_ref(node->code) : NULL;
+            }
+            break;
+
+        case LVAL_ERR: copy->err = strdup(node->err); break;
+        case LVAL_SYM: copy->sym = node->sym; break;
+
+        // Strings are never modified, share the characters
+        case LVAL_STR:
+            copy->str    = node->str;
+            copy->length = node->length;
+            copy->strbuf = node->strbuf;
+            copy->strbuf->refcount++;
+            break;
+
+        // Share the children, only copy the pointers
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            copy->count  = node->count;
+            copy->values = node->values;
+            copy->buf    = node->buf;
 
+            if (copy->buf) {
+                copy->buf->refcount++;
+                list_reserve(copy, 0, 0);
+            }
+            break;
+        default:
+            ASSERTF(0, "Invalid lval type: %i", node->type);
+    }
+
+    // Drop the caller's reference to the shared object
+    node->refcount--;
+
+    return copy;
+}
+
+/**
+ * Compare two object's values (see #lval_eq and #lval_key_eq).
+ *
+ * \param exact Whether floats are compared exactly instead of with the
+ *              tolerance of #fcmp.
+ */
+static bool values_eq(lval* x, lval* y, bool exact) {
     if (x->type != y->type) {
+        // Integers and floats are compared exactly by value. Big integers
+        // never equal other integers, they don't fit PRECISION_INT.
+        if (lval_is_number(x) && lval_is_number(y)) {
+            return lval_num_cmp(x, y) == 0;
+        }
         return false;
     }
 
     switch (x->type) {
-        case LVAL_NUM: return fcmp(x->num, y->num);
+        case LVAL_INT: return x->integer == y->integer;
+        case LVAL_BIG: return lbig_cmp(x->big, y->big) == 0;
+        case LVAL_NUM: return exact ? FLOAT_EQ(x->num, y->num) : fcmp(x->num, y->num);
+        case LVAL_VEC: return exact ? vec_key_eq(x->vec, y->vec) : lvec_eq(x->vec, y->vec);
+        case LVAL_SEQ: return seq_eq(x->seq, y->seq, exact);
+
+        case LVAL_DICT:
+        case LVAL_SET:
+            return dict_eq(x->dict, y->dict, exact);
+        case LVAL_ARRAY:
+            return array_eq(x->array, y->array, exact);
 
         case LVAL_ERR: return (strcmp(x->err, y->err) == false);
-        case LVAL_SYM: return (strcmp(x->sym, y->sym) == false);
-        case LVAL_STR: return (strcmp(x->str, y->str) == false);
+        case LVAL_SYM: return x->sym == y->sym;
+        case LVAL_STR:
+            return x->length == y->length && memcmp(x->str, y->str, x->length) == 0;
 
         case LVAL_FUNC:
             if (x->builtin || y->builtin) {
                 return x->builtin == y->builtin;
             } else {
-                return lval_eq(x->formals, y->formals) && lval_eq(x->body, y->body);
+                return x->env->bound == y->env->bound
+                       && values_eq(x->formals, y->formals, exact) && values_eq(x->body, y->body, exact);
             }
 
         case LVAL_SEXPR:
@@ -268,7 +1009,7 @@ bool lval_eq(lval* x, lval* y) {
                 return false;
             }
             for_item(x, {
-                if (!lval_eq(x->values[i], y->values[i])) {
+                if (!values_eq(x->values[i], y->values[i], exact)) {
                     return false;
                 }
             });
@@ -279,13 +1020,150 @@ bool lval_eq(lval* x, lval* y) {
     return false;
 }
 
+bool lval_eq(lval* x, lval* y) {
+    ASSERT_NOT_NULL(x);
+    ASSERT_NOT_NULL(y);
+
+    return values_eq(x, y, false);
+}
+
+bool lval_key_eq(lval* x, lval* y) {
+    ASSERT_NOT_NULL(x);
+    ASSERT_NOT_NULL(y);
+
+    return values_eq(x, y, true);
+}
+
+/// Mix the bits of a hash (the finalizer of MurmurHash3).
+static uint64_t hash_mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+/// Combine a hash with the hash of the next part of a value.
+static uint64_t hash_combine(uint64_t hash, uint64_t part) {
+    return hash_mix(hash * 31 + part);
+}
+
+/// Hash a float, integral values hash like the integers they equal.
+static uint64_t hash_float(PRECISION_FLOAT value) {
+    if (value >= -9223372036854775808.0 && value < 9223372036854775808.0
+            && FLOAT_EQ((PRECISION_FLOAT) (PRECISION_INT) value, value)) {
+        return hash_mix((uint64_t) (PRECISION_INT) value);
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_mix(bits);
+}
+
+/// Hash characters (FNV-1a).
+static uint64_t hash_chars(char* chars, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char) chars[i]) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+uint64_t lval_hash(lval* node) {
+    ASSERT_NOT_NULL(node);
+
+    uint64_t hash = (uint64_t) node->type;
+
+    switch (node->type) {
+        case LVAL_INT: return hash_mix((uint64_t) node->integer);
+        case LVAL_BIG: return hash_float(lbig_to_float(node->big));
+        case LVAL_NUM: return hash_float(node->num);
+
+        case LVAL_VEC:
+            hash = node->vec->count;
+            for (size_t i = 0; i < node->vec->count; i++) {
+                hash = hash_combine(hash, node->vec->integers ? hash_mix((uint64_t) node->vec->ints[i])
+                                                              : hash_float(node->vec->floats[i]));
+            }
+            return hash;
+
+        case LVAL_SEQ:
+            hash = hash_combine(hash, (uint64_t) node->seq->kind);
+            hash = hash_combine(hash, (uint64_t) node->seq->start);
+            hash = hash_combine(hash, (uint64_t) node->seq->end);
+            hash = hash_combine(hash, (uint64_t) node->seq->step);
+            hash = hash_combine(hash, node->seq->source ? lval_hash(node->seq->source) : 0);
+            return hash_combine(hash, node->seq->func ? lval_hash(node->seq->func) : 0);
+
+        // The order of the entries doesn't matter, add up their hashes
+        case LVAL_DICT:
+        case LVAL_SET: {
+            ldict_iter iter;
+            lval* key;
+            lval* value;
+
+            ldict_iter_init(&iter, node->dict);
+            while (ldict_iter_next(&iter, &key, &value)) {
+                hash += hash_combine(lval_hash(key), value ? lval_hash(value) : 0);
+            }
+            return hash_mix(hash);
+        }
+
+        case LVAL_ARRAY:
+            for (size_t i = 0; i < node->array->count; i++) {
+                hash = hash_combine(hash, lval_hash(larray_get(node->array, i)));
+            }
+            return hash;
+
+        case LVAL_ERR: return hash_combine(hash, hash_chars(node->err, strlen(node->err)));
+        case LVAL_SYM: return hash_combine(hash, (uint64_t) (uintptr_t) node->sym);
+        case LVAL_STR: return hash_combine(hash, hash_chars(node->str, node->length));
+
+        case LVAL_FUNC:
+            if (node->builtin) {
+                return hash_combine(hash, (uint64_t) (uintptr_t) node->builtin);
+            }
+            hash = hash_combine(hash, node->env->bound);
+            hash = hash_combine(hash, lval_hash(node->formals));
+            return hash_combine(hash, lval_hash(node->body));
+
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            for_item(node, {
+                hash = hash_combine(hash, lval_hash(item));
+            });
+            return hash;
+    }
+
+    ASSERTF(0, "Invalid lval type: %i", node->type);
+    return 0;
+}
+
 lval* lval_add(lval* container, lval* value) {
     ASSERT_LIST_LIKE(container);
+    ASSERTF(container->refcount == 1, "attempt to modify a shared list");
 
+    list_reserve(container, 0, 1);
+
+    container->values[container->count] = value;
+    container->count++;
+    container->buf->used++;
+
+    return container;
+}
+
+lval* lval_prepend(lval* container, lval* value) {
+    ASSERT_LIST_LIKE(container);
+
+    container = list_own(container, 1, 0);
+
+    container->values--;
+    container->values[0] = value;
     container->count++;
-    container->values = xrealloc(container->values,
-                                 LVAL_PTR_SIZE * container->count);
-    container->values[container->count - 1] = value;
+    container->buf->first--;
 
     return container;
 }
@@ -294,48 +1172,257 @@ lval* lval_join(lval* first, lval* second) {
     ASSERT_LIST_LIKE(first);
     ASSERT_LIST_LIKE(second);
 
-    // For each value in 'second', add it to 'first'
-    while (second->count) {
-        first = lval_add(first, lval_pop(second, 0));
+    if (first->count == 0 && first->type == second->type) {
+        lval_del(first);
+        return second;
+    }
+
+    if (second->count == 0) {
+        lval_del(second);
+        return lval_unshare(first);
+    }
+
+    first = list_own(first, 0, second->count);
+    memcpy(&first->values[first->count], second->values, LVAL_PTR_SIZE * second->count);
+
+    if (second->refcount == 1 && second->buf->refcount == 1) {
+        // Move the references, the values aren't owned by 'second' any more
+        list_reserve(second, 0, 0);
+        second->buf->used = second->buf->first;
+    } else {
+        for_item(second, {
+            lval_ref(item);
+        });
     }
 
+    first->count += second->count;
+    first->buf->used += second->count;
+
     lval_del(second);
     return first;
 }
 
 lval* lval_pop(lval* container, size_t index) {
     ASSERT_LIST_LIKE(container);
+    ASSERTF(container->refcount == 1, "attempt to modify a shared list");
     ASSERT_ARG(container, container->count > 0, "count is %i (<= 0)", container->count);
     ASSERT_ARG(index, index <= container->count, "is %i (< container->count = %i)", index, container->count);
 
+    list_reserve(container, 0, 0);
+
     lval* item = container->values[index];
 
-    // Shift memory following the item at 'index' over the top of it
-    memmove(&container->values[index], &container->values[index + 1],
-            LVAL_PTR_SIZE * (container->count - index - 1));
+    if (index == 0) {
+        // Popping from the front only moves the start of the list
+        container->values++;
+        container->buf->first++;
+    } else {
+        // Shift memory following the item at 'index' over the top of it
+        memmove(&container->values[index], &container->values[index + 1],
+                LVAL_PTR_SIZE * (container->count - index - 1));
+        container->buf->used--;
+    }
 
     container->count--;
 
-    // Reallocate the memory used
-    container->values = xrealloc(container->values, LVAL_PTR_SIZE * container->count);
-
     return item;
 }
 
 lval* lval_take(lval* container, size_t index) {
-    lval* item = lval_pop(container, index);
+    lval* item;
+
+    if (container->refcount > 1 || (container->buf && container->buf->refcount > 1)) {
+        // Don't touch the shared container, just share the item
+        item = lval_ref(container->values[index]);
+    } else {
+        item = lval_pop(container, index);
+    }
+
     lval_del(container);
 
     return item;
 }
 
+lval* lval_drop(lval* list, size_t count) {
+    ASSERT_LIST_LIKE(list);
+    ASSERT_ARG(count, count <= list->count, "is %zu (> list->count = %zu)", count, list->count);
+
+    if (count == 0) {
+        return list;
+    }
+
+    if (list->refcount > 1) {
+        // Create a slice sharing the storage
+        lval* slice = lval_new();
+        slice->type   = list->type;
+        slice->count  = list->count;
+        slice->values = list->values;
+        slice->buf    = list->buf;
+        slice->buf->refcount++;
+
+        list->refcount--;
+        list = slice;
+    }
+
+    // The storage keeps owning the dropped values
+    list->values += count;
+    list->count  -= count;
+
+    return list;
+}
+
+bool lval_is_number(lval* node) {
+    return node->type == LVAL_INT || node->type == LVAL_BIG || node->type == LVAL_NUM;
+}
+
+bool lval_is_integer(lval* node) {
+    return node->type == LVAL_INT || node->type == LVAL_BIG;
+}
+
+lbig* lval_to_big(lval* node) {
+    return node->type == LVAL_BIG ? lbig_copy(node->big) : lbig_from_int(node->integer);
+}
+
+PRECISION_FLOAT lval_to_float(lval* node) {
+    switch (node->type) {
+        case LVAL_INT: return (PRECISION_FLOAT) node->integer;
+        case LVAL_BIG: return lbig_to_float(node->big);
+        case LVAL_NUM: return node->num;
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+        case LVAL_SYM:
+        case LVAL_FUNC:
+        case LVAL_VEC:
+        case LVAL_SEQ:
+        case LVAL_DICT:
+        case LVAL_SET:
+        case LVAL_ARRAY:
+        case LVAL_STR:
+        case LVAL_ERR:
+        default:
+            ASSERTF(0, "Not a number: %s", lval_str_type(node->type));
+            return 0;
+    }
+}
+
+bool lval_is_zero(lval* node) {
+    switch (node->type) {
+        case LVAL_INT: return node->integer == 0;
+        case LVAL_BIG: return node->big->count == 0;
+        case LVAL_NUM: return FLOAT_EQ(node->num, 0);
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+        case LVAL_SYM:
+        case LVAL_FUNC:
+        case LVAL_VEC:
+        case LVAL_SEQ:
+        case LVAL_DICT:
+        case LVAL_SET:
+        case LVAL_ARRAY:
+        case LVAL_STR:
+        case LVAL_ERR:
+        default:
+            ASSERTF(0, "Not a number: %s", lval_str_type(node->type));
+            return false;
+    }
+}
+
+/// Compare two floats (see #lval_num_cmp).
+static int float_cmp(PRECISION_FLOAT x, PRECISION_FLOAT y) {
+    if (x < y) {
+        return -1;
+    }
+    if (x > y) {
+        return 1;
+    }
+
+    return isnan(x) || isnan(y) ? LVAL_UNORDERED : 0;
+}
+
+/// Compare a big integer with a float exactly (see #lval_num_cmp).
+static int big_float_cmp(lbig* big, PRECISION_FLOAT num) {
+    if (!isfinite(num)) {
+        return float_cmp(0, num);
+    }
+
+    PRECISION_FLOAT whole = trunc(num);
+    lbig* truncated = lbig_from_float(whole);
+    int order = lbig_cmp(big, truncated);
+    lbig_del(truncated);
+
+    if (order != 0) {
+        return order < 0 ? -1 : 1;
+    }
+
+    // The fraction has the sign of the float
+    return float_cmp(whole, num);
+}
+
+/// Compare an integer with a float exactly (see #lval_num_cmp).
+static int int_float_cmp(PRECISION_INT integer, PRECISION_FLOAT num) {
+    // Floats beyond the integers are integral, converting them overflows
+    PRECISION_FLOAT limit = -(PRECISION_FLOAT) PRECISION_INT_MIN;
+    if (isnan(num) || num >= limit || num < -limit) {
+        return float_cmp(0, num);
+    }
+
+    PRECISION_FLOAT whole = trunc(num);
+    PRECISION_INT truncated = (PRECISION_INT) whole;
+    if (integer != truncated) {
+        return integer < truncated ? -1 : 1;
+    }
+
+    // The fraction has the sign of the float
+    return float_cmp(whole, num);
+}
+
+int lval_num_cmp(lval* x, lval* y) {
+    ASSERT_NOT_NULL(x);
+    ASSERT_NOT_NULL(y);
+
+    if (x->type == LVAL_NUM && y->type == LVAL_NUM) {
+        return float_cmp(x->num, y->num);
+    }
+
+    if (x->type == LVAL_NUM) {
+        int order = lval_num_cmp(y, x);
+        return order == LVAL_UNORDERED ? order : -order;
+    }
+
+    if (y->type == LVAL_NUM) {
+        if (x->type == LVAL_INT) {
+            return int_float_cmp(x->integer, y->num);
+        }
+        return big_float_cmp(x->big, y->num);
+    }
+
+    if (x->type == LVAL_INT && y->type == LVAL_INT) {
+        return (x->integer > y->integer) - (x->integer < y->integer);
+    }
+
+    lbig* a = lval_to_big(x);
+    lbig* b = lval_to_big(y);
+    int order = lbig_cmp(a, b);
+    lbig_del(a);
+    lbig_del(b);
+
+    return (order > 0) - (order < 0);
+}
+
 char* lval_str_type(lval_type type) {
     switch (type) {
         case LVAL_SEXPR: return "S-Expression";
         case LVAL_QEXPR: return "Q-Expression";
         case LVAL_SYM:   return "symbol";
         case LVAL_STR:   return "string";
-        case LVAL_NUM:   return "number";
+        case LVAL_INT:   return "integer";
+        case LVAL_BIG:   return "integer";
+        case LVAL_NUM:   return "float";
+        case LVAL_VEC:   return "vector";
+        case LVAL_SEQ:   return "sequence";
+        case LVAL_DICT:  return "dictionary";
+        case LVAL_SET:   return "set";
+        case LVAL_ARRAY: return "array";
         case LVAL_ERR:   return "error";
         case LVAL_FUNC:  return "function";
         default:         return "unknown";
@@ -382,8 +1469,15 @@ char* lval_str_func(lenv* env, lval* func) {
             return strdup("<builtin>");
         }
     } else {
-        char* str_formals = lval_repr(env, func->formals);
+        // Only show the formals that are not bound yet
+        lval* formals = lval_qexpr();
+        for (size_t i = func->env->bound; i < func->formals->count; i++) {
+            lval_add(formals, lval_ref(func->formals->values[i]));
+        }
+
+        char* str_formals = lval_repr(env, formals);
         char* str_body    = lval_repr(env, func->body);
+        lval_del(formals);
 
         char* buffer = xsprintf("(lambda %s %s)", str_formals, str_body);
 
@@ -396,7 +1490,97 @@ char* lval_str_func(lenv* env, lval* func) {
 
 char* lval_str_str(lenv* env, lval* node) {
     UNUSED(env);
-    return strdup(node->str);
+
+    char* str = xmalloc(node->length + 1);
+    memcpy(str, node->str, node->length);
+    str[node->length] = '\0';
+
+    return str;
+}
+
+/// Write a float with a decimal point if its value is integral.
+static char* float_to_str(PRECISION_FLOAT value) {
+    char* buffer = xsprintf("%g", value);
+
+    // Floats with integral values keep a decimal point to be read as floats
+    if (strspn(buffer, "-0123456789") == strlen(buffer)) {
+        char* tmp = xsprintf("%s.0", buffer);
+        xfree(buffer);
+        buffer = tmp;
+    }
+
+    return buffer;
+}
+
+char* lval_str_num(lval* node) {
+    return float_to_str(node->num);
+}
+
+char* lval_str_vec(lval* node) {
+    lvec* vec = node->vec;
+    size_t capacity = 64;
+    size_t length = 1;
+
+    char* buffer = xmalloc(capacity);
+    buffer[0] = '[';
+
+    for (size_t i = 0; i < vec->count; i++) {
+        char* tmp = vec->integers ? xsprintf("%lld", (long long) vec->ints[i])
+                                  : float_to_str(vec->floats[i]);
+        size_t tmp_len = strlen(tmp);
+
+        // Room for a space, the item, `]` and `\0`
+        if (length + tmp_len + 3 > capacity) {
+            capacity = 2 * (length + tmp_len + 3);
+            buffer = xrealloc(buffer, capacity);
+        }
+
+        // Print space unless first element
+        if (i > 0) {
+            buffer[length++] = ' ';
+        }
+        memcpy(buffer + length, tmp, tmp_len);
+        length += tmp_len;
+        xfree(tmp);
+    }
+
+    buffer[length++] = ']';
+    buffer[length] = '\0';
+
+    return buffer;
+}
+
+/**
+ * Write a hash map, set or array like the call creating it, for example
+ * `(dict key value ...)`.
+ */
+static char* lval_str_call(lenv* env, lval* node) {
+    lval* call = lval_sexpr();
+    call = lval_add(call, lval_sym(node->type == LVAL_ARRAY ? "array"
+                                   : node->type == LVAL_SET ? "set" : "dict"));
+
+    if (node->type == LVAL_ARRAY) {
+        for (size_t i = 0; i < node->array->count; i++) {
+            call = lval_add(call, lval_ref(larray_get(node->array, i)));
+        }
+    } else {
+        ldict_iter iter;
+        lval* key;
+        lval* value;
+
+        ldict_iter_init(&iter, node->dict);
+        while (ldict_iter_next(&iter, &key, &value)) {
+            call = lval_add(call, lval_ref(key));
+            if (value) {
+                call = lval_add(call, lval_ref(value));
+            }
+        }
+    }
+
+    char* str = lval_str_expr(env, call, '(', ')');
+    lval_del(call);
+
+    return str;
 }
 
 char* lval_to_str(lenv* env, lval* node) {
@@ -409,7 +1593,14 @@ char* lval_to_str(lenv* env, lval* node) {
         case LVAL_FUNC:  return lval_str_func(env, node);
         case LVAL_STR:   return lval_str_str(env, node);
         case LVAL_SYM:   return xsprintf("%s", node->sym);
-        case LVAL_NUM:   return xsprintf("%g", node->num);
+        case LVAL_INT:   return xsprintf("%lld", (long long) node->integer);
+        case LVAL_BIG:   return lbig_to_str(node->big);
+        case LVAL_NUM:   return lval_str_num(node);
+        case LVAL_VEC:   return lval_str_vec(node);
+        case LVAL_SEQ:   return xsprintf("<sequence>");
+        case LVAL_DICT:  return lval_str_call(env, node);
+        case LVAL_SET:   return lval_str_call(env, node);
+        case LVAL_ARRAY: return lval_str_call(env, node);
         case LVAL_ERR:   return xsprintf("Error: %s", node->err);
         default:         ASSERTF(0, "Encountered invalid lval type: %i", node->type);
     }
@@ -423,7 +1614,7 @@ char* lval_repr(lenv* env, lval* node) {
 
     if (node->type == LVAL_STR) {
         char* escaped = NULL;
-        escaped = strdup(node->str);
+        escaped = lval_str_str(env, node);
         escaped = mpcf_escape(escaped);
 
         char* quoted = xsprintf("\"%s\"", escaped);
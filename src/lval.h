@@ -11,11 +11,19 @@
 #endif
 
 #include "config.h"
+#include "bignum.h"
+#include "vector.h"
+#include "sequence.h"
+#include "dict.h"
+#include "array.h"
 
 
 // Forward declarations
 struct lval;
 struct lenv;
+struct lcode;
+struct lbuf;
+struct lstrbuf;
 typedef struct lval lval;
 typedef struct lenv lenv;
 
@@ -29,26 +37,50 @@ typedef enum lval_type {
     LVAL_QEXPR, ///< A Q-Expression.
     LVAL_SYM,   ///< A symbol.
     LVAL_FUNC,  ///< A function (lambda or builtin).
+    LVAL_INT,   ///< An integer number.
+    LVAL_BIG,   ///< An integer number that doesn't fit #PRECISION_INT.
     LVAL_NUM,   ///< A floating point number.
+    LVAL_VEC,   ///< A packed vector of numbers.
+    LVAL_SEQ,   ///< A lazy sequence.
+    LVAL_DICT,  ///< A hash map.
+    LVAL_SET,   ///< A hash set.
+    LVAL_ARRAY, ///< A persistent array.
     LVAL_STR,   ///< A string.
     LVAL_ERR    ///< An error.
 } lval_type;
 
 /// The lval object.
 struct lval {
-    lval_type type; ///< The object's type
+    lval_type type;     ///< The object's type
+    size_t refcount;    ///< The number of owners sharing this object
 
     // Data
     union {
-        PRECISION_FLOAT num;    ///< Value of a number object.
+        PRECISION_INT integer;  ///< Value of an integer object.
+        PRECISION_FLOAT num;    ///< Value of a float object.
+        lbig* big;              ///< Value of a big integer object.
+        lvec* vec;              ///< Value of a vector object.
+        lseq* seq;              ///< Value of a sequence object.
+        ldict* dict;            ///< Entries of a hash map or set object.
+        larray* array;          ///< Items of an array object.
         char* err;              ///< Value of an error object.
-        char* sym;              ///< Value of a symbol object.
-        char* str;              ///< Value of a string object.
+        char* sym;              ///< Value of a symbol object (interned).
+
+        /// Value of a string object
+        struct {
+            char* str;                  ///< The characters, not necessarily
+                                        ///< terminated (see #lval_str_cstr).
+            size_t length;              ///< The number of characters.
+            struct lstrbuf* strbuf;     ///< The storage holding the characters,
+                                        ///< may be shared with other strings.
+        };
 
         /// Values for S-Expr/Q-Expr
         struct {
             size_t count;           ///< The number of values.
             struct lval** values;   ///< The values (pointer to pointers).
+            struct lbuf* buf;       ///< The storage holding the values, may
+                                    ///< be shared with slices of the list.
         };
 
         /// Value of function object
@@ -56,7 +88,8 @@ struct lval {
             lbuiltin builtin;   ///< Pointer to a builtin function or ...
             lenv* env;          ///< a lambda function with an environment,
             lval* formals;      ///< formal arguments and
-            lval* body;         ///< a function body.
+            lval* body;         ///< a function body,
+            struct lcode* code; ///< compiled on its first call by the VM.
         };
     };
 };
@@ -69,12 +102,62 @@ static const size_t LVAL_SIZE = sizeof(lval);
 static const size_t LVAL_PTR_SIZE = sizeof(lval*);
 
 
+#if !defined(MLISP_NOINCLUDE)
+    /// The smallest number of values allocated for a list.
+    #define LBUF_MIN_CAPACITY 4
+
+    /**
+     * The storage of a list's values.
+     *
+     * A list points at a range of the storage's items. Slices of a list (see
+     * #lval_drop) share its storage, so the storage keeps the references to
+     * all items any of them may point at.
+     */
+    typedef struct lbuf {
+        size_t refcount;    ///< The number of lists sharing the storage.
+        size_t capacity;    ///< The number of items that fit in.
+        size_t first;       ///< The index of the first item owned.
+        size_t used;        ///< The index after the last item owned.
+        lval* items[];      ///< The items, `items[first..used)` are owned.
+    } lbuf;
+
+    /**
+     * Drop a reference to a list's storage, delete it and its items when it's
+     * the last one.
+     *
+     * \param buf   The storage to delete.
+     */
+    void lbuf_del(lbuf* buf);
+
+    /**
+     * The storage of a string's characters.
+     *
+     * A string points at a range of the storage's characters. Substrings share
+     * the storage of the string they were taken from. A string ending where
+     * the used characters end may be extended in place (see
+     * #lval_str_concat): the other strings sharing the storage never see
+     * characters after their own end.
+     */
+    typedef struct lstrbuf {
+        size_t refcount;    ///< The number of strings sharing the storage.
+        size_t capacity;    ///< The number of characters that fit in.
+        size_t used;        ///< The number of characters written,
+                            ///< `chars[used]` is always `\0`.
+        char chars[];       ///< The characters.
+    } lstrbuf;
+#endif
+
+
 #if !defined(MLISP_NOINCLUDE)
     // Forward declarations
     lenv* lenv_new(void);
+    lenv* lenv_new_frame(lval* formals);
+    lenv* lenv_ref(lenv* env);
     void lenv_del(lenv* env);
     lenv* lenv_copy(lenv* env);
     char* lenv_func_name(lenv* env, lbuiltin func);
+    struct lcode* lcode_ref(struct lcode* code);
+    void lcode_del(struct lcode* code);
 #endif
 
 
@@ -106,9 +189,22 @@ lval* lval_sexpr(void);
  */
 lval* lval_qexpr(void);
 
+/**
+ * Create a lispy S-Expression from an array of values.
+ *
+ * \param values    The values, their references are moved to the new list.
+ * \param count     The number of values.
+ *
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_sexpr_from(lval** values, size_t count);
+
 /**
  * Create and initialize a lispy symbol.
  *
+ * The name is interned (see #symbol_intern), so symbols with the same name
+ * share the same `sym` pointer.
+ *
  * \param symbol    The symbol's value. Won't be deallocated,
  *                  you'll have to cleanup yourself.
  * \returns A pointer to the newly created object.
@@ -116,13 +212,70 @@ lval* lval_qexpr(void);
 lval* lval_sym(char* symbol);
 
 /**
- * Create and initialize a lispy number.
+ * Create and initialize a lispy integer.
+ *
+ * Integers from #LVAL_SMALL_INT_MIN to #LVAL_SMALL_INT_MAX aren't allocated:
+ * all of them share one static object per value (see #lval_is_static). Like
+ * any shared object, it must not be modified (see #lval_unshare).
+ *
+ * \param value     The integer's value.
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_int(PRECISION_INT value);
+
+/**
+ * Create a lispy integer from a big integer.
+ *
+ * Big integers are normalized: if the value fits #PRECISION_INT, the result
+ * is created with #lval_int, so every integer has exactly one
+ * representation.
+ *
+ * \param value     The integer's value (consumed).
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_big(lbig* value);
+
+/**
+ * Create and initialize a lispy float number.
  *
  * \param value     The number's value.
  * \returns A pointer to the newly created object.
  */
 lval* lval_num(PRECISION_FLOAT value);
 
+/**
+ * Create a lispy vector.
+ *
+ * \param value     The vector's items (consumed).
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_vec(lvec* value);
+
+/**
+ * Create a lispy sequence.
+ *
+ * \param value     The sequence (consumed).
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_seq(lseq* value);
+
+/**
+ * Create a lispy hash map or set.
+ *
+ * \param value     The entries (consumed), without values for a set.
+ * \param set       Whether to create a set.
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_dict(ldict* value, bool set);
+
+/**
+ * Create a lispy array.
+ *
+ * \param value     The items (consumed).
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_array(larray* value);
+
 /**
  * Create and initialize a lispy string.
  *
@@ -132,6 +285,59 @@ lval* lval_num(PRECISION_FLOAT value);
  */
 lval* lval_str(char* str);
 
+/**
+ * Create and initialize a lispy string from a slice of a larger buffer.
+ *
+ * \param str       The beginning of the string, doesn't have to be
+ *                  terminated.
+ * \param length    The number of characters to copy.
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_str_len(char* str, size_t length);
+
+/**
+ * Join strings into a new one.
+ *
+ * If `first` ends where the used characters of its storage end and there's
+ * room left, the others are appended in place and the new string shares the
+ * storage. Otherwise new storage is allocated with room to spare, so that
+ * repeatedly extending a string takes amortized linear time in total.
+ *
+ * \param strings   The strings, all of type #LVAL_STR.
+ * \param count     The number of strings, at least one.
+ *
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_str_concat(lval** strings, size_t count);
+
+/**
+ * Take a range of a string's characters.
+ *
+ * Takes constant time, the substring shares the storage of the string.
+ *
+ * \param node      The string.
+ * \param start     The index of the first character.
+ * \param length    The number of characters, `start + length` must not be
+ *                  after the end of the string.
+ *
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_str_sub(lval* node, size_t start, size_t length);
+
+/**
+ * Get the characters of a string terminated by `\0`.
+ *
+ * Strings sharing their storage aren't always terminated, those get storage
+ * of their own first. The value of the string doesn't change, so that's
+ * done for shared strings, too.
+ *
+ * \param node  The string.
+ *
+ * \returns The characters, valid until the string is deleted or extended
+ *          (see #lval_str_concat).
+ */
+char* lval_str_cstr(lval* node);
+
 /**
  * Create and initialize a lispy error.
  *
@@ -167,20 +373,63 @@ lval* lval_func(lbuiltin func);
  */
 lval* lval_lambda(lval* formals, lval* body);
 
+/**
+ * Create a partially applied lambda function.
+ *
+ * The new function shares the formals, the body and the code of `func`, but
+ * uses the frame holding its bound arguments as environment.
+ *
+ * \param func      The lambda function (consumed).
+ * \param frame     The frame with the bound arguments (consumed).
+ *
+ * \returns A pointer to the newly created object.
+ */
+lval* lval_partial(lval* func, lenv* frame);
+
 /**
  * Delete a #lval object.
  *
- * Delete a #lval object. If the object holds a string, it frees it.
+ * Drop one reference to a #lval object. The object is only destroyed when
+ * the last reference is dropped. If the object holds a string, it frees it.
  *
  * \li If it's a lambda, it first deletes the env, formals and body.
- * \li If it's a qexpr or sexpr, it first deletes all child objects.
+ * \li If it's a sequence, it first deletes its source and function.
+ * \li If it's a qexpr or sexpr, it first releases the storage of its values
+ *     (see #lbuf_del).
+ * \li If it's a hash map or set, it first releases its entries (see
+ *     #ldict_del).
+ * \li If it's an array, it first releases its items (see #larray_del).
  *
- * Then finally, it frees it's own memory.
+ * Then finally, it frees it's own memory (see #lval_free). With #MLISP_GC,
+ * objects are freed the same way, except while the garbage collector sweeps
+ * (it frees the unreachable objects itself).
  *
  * \param node  The object to delete.
  */
 void lval_del(lval* node);
 
+/**
+ * Drop the references a #lval object holds.
+ *
+ * Delete the children, the storage, entries or items and the compiled code
+ * of an object like #lval_del does before freeing it. Only used by #lval_del
+ * and the garbage collector (see gc.h).
+ *
+ * \param node  The object whose references to drop.
+ */
+void lval_clear(lval* node);
+
+/**
+ * Free the memory owned by a #lval object.
+ *
+ * Free the object's strings and the object itself, without
+ * dropping the references to its children. Only used by #lval_del and the
+ * garbage collector (see gc.h).
+ *
+ * \param node  The object to free.
+ */
+void lval_free(lval* node);
+
 /**
  * Copy a #lval object.
  *
@@ -193,11 +442,52 @@ void lval_del(lval* node);
  */
 lval* lval_copy(lval* node);
 
+/**
+ * Share a #lval object.
+ *
+ * Add a reference to a #lval object instead of copying it. Shared objects
+ * must not be modified, use #lval_unshare to get a writable object first.
+ *
+ * \param node  The object to share.
+ * \returns The same object.
+ */
+lval* lval_ref(lval* node);
+
+/**
+ * Get a writable version of a #lval object (copy-on-write).
+ *
+ * If the caller holds the only reference, the object itself is returned.
+ * Otherwise the caller's reference is dropped and a shallow copy is returned:
+ * child objects of lists and lambdas are shared, not copied. The values of a
+ * list are always in storage of its own afterwards. Has to be
+ * performed in-place:
+ * \code
+ *      node = lval_unshare(node);
+ * \endcode
+ *
+ * \param node  The object to modify.
+ * \returns An object that is safe to modify.
+ */
+lval* lval_unshare(lval* node);
+
+/**
+ * Check whether an object is statically allocated.
+ *
+ * Static objects, like small integers (see #lval_int), are never freed and
+ * aren't managed by the garbage collector.
+ *
+ * \param node  The object to check.
+ * \returns Whether the object is static.
+ */
+bool lval_is_static(lval* node);
+
 /**
  * Check for equality of two objects's values.
  *
  * Compare two object's values. If the two objects have different types,
- * the comparison always is false. Otherwise, the values are compared.
+ * the comparison always is false, except for numbers: an integer and a float
+ * are equal if their values are. Otherwise, the values are compared, the
+ * items of vectors like numbers.
  *
  * \param x The first object
  * \param y The second object
@@ -208,6 +498,30 @@ lval* lval_copy(lval* node);
  */
 bool lval_eq(lval* x, lval* y);
 
+/**
+ * Hash an object's value.
+ *
+ * Keys that are equal (see #lval_key_eq) have the same hash, so integers
+ * hash like the floats they equal.
+ *
+ * \param node  The object to hash.
+ * \returns The hash.
+ */
+uint64_t lval_hash(lval* node);
+
+/**
+ * Compare two keys of a dictionary or set.
+ *
+ * Like #lval_eq, but floats are compared exactly, so that equal keys have
+ * the same hash (see #lval_hash).
+ *
+ * \param x The first key.
+ * \param y The second key.
+ *
+ * \returns Whether the keys are equal.
+ */
+bool lval_key_eq(lval* x, lval* y);
+
 
 // ------------------------------------------------------------------------------
 // Lvalue modifiers
@@ -217,7 +531,9 @@ bool lval_eq(lval* x, lval* y);
  * Add an object to a container.
  *
  * On a list-like container (Q-Expr or S-Expr), add the object given by
- * value to the end of the container values list. Has to be performed in-place:
+ * value to the end of the container values list. The container must not be
+ * shared (see #lval_unshare). Takes amortized constant time, the storage
+ * grows by doubling. Has to be performed in-place:
  * \code
  *      container = lval_add(container, value);
  * \endcode
@@ -229,11 +545,30 @@ bool lval_eq(lval* x, lval* y);
  */
 lval* lval_add(lval* container, lval* value);
 
+/**
+ * Add an object to the front of a container.
+ *
+ * Like #lval_add, but inserts the value before the first one. Takes amortized
+ * constant time, too: storage grown for it keeps room in front of the values.
+ * The container may be shared, the value is added to a new list then. Its
+ * storage is only copied if there is no room in front of the values.
+ *
+ * \param container [out]   The container where to add the value.
+ * \param value             The value to add.
+ *
+ * \returns The new container with the value added.
+ */
+lval* lval_prepend(lval* container, lval* value);
+
 /**
  * Join two lists into a new one.
  *
  * Takes two lists and joins them into a new one and returns it. Deletes both
- * arguments and creates a new object. Has to be performed in-place:
+ * arguments. The values of `second` are copied in bulk, its references are
+ * moved if it isn't shared. The values of `first` are only copied if there
+ * is no room after them in its storage, even if it's shared, so joining
+ * onto a list takes amortized time in the length of `second`. Has to be
+ * performed in-place:
  * \code
  *      container = lval_join(fist, second);
  * \endcode
@@ -249,7 +584,8 @@ lval* lval_join(lval* first, lval* second);
  * Pop a value from a list and returns it.
  *
  * Remove a value from a list-like container and return it. The container
- * now doesn't contain the returned value any more.
+ * now doesn't contain the returned value any more. The container must not be
+ * shared (see #lval_unshare).
  *
  * \warning Please note that from now on you have to memory-manage the return
  *          value, too!
@@ -265,7 +601,7 @@ lval* lval_pop(lval* container, size_t index);
  * Return an element from a list and remove the rest of the list.
  *
  * Pop an element from a list-like container, return it and remove the rest
- * of the container. Essentially like running
+ * of the container. Works on shared containers, too. Essentially like running
  * \code
  *      lval* item = lval_pop(container, index);
  *      lval_del(container);
@@ -278,6 +614,85 @@ lval* lval_pop(lval* container, size_t index);
  */
 lval* lval_take(lval* container, size_t index);
 
+/**
+ * Drop values from the front of a list.
+ *
+ * Takes constant time: if the list is shared, the result is a slice sharing
+ * its storage (see #lbuf), nothing is copied. Has to be performed in-place:
+ * \code
+ *      list = lval_drop(list, count);
+ * \endcode
+ *
+ * \param list  The list to drop values from.
+ * \param count The number of values to drop.
+ *
+ * \returns The list without the first `count` values.
+ */
+lval* lval_drop(lval* list, size_t count);
+
+
+// ------------------------------------------------------------------------------
+// Numbers
+
+/**
+ * Check whether an object is a number (an integer or a float).
+ *
+ * \param node  The object to check.
+ * \returns Whether the object is a number.
+ */
+bool lval_is_number(lval* node);
+
+/**
+ * Check whether an object is an integer (fitting #PRECISION_INT or big).
+ *
+ * \param node  The object to check.
+ * \returns Whether the object is an integer.
+ */
+bool lval_is_integer(lval* node);
+
+/**
+ * Get the value of an integer as big integer.
+ *
+ * \param node  The integer.
+ * \returns A new big integer. Has to be deleted with #lbig_del!
+ */
+lbig* lval_to_big(lval* node);
+
+/**
+ * Get the value of a number as float.
+ *
+ * \param node  The number, an integer or a float.
+ * \returns The value, integers are converted (and rounded if they are big).
+ */
+PRECISION_FLOAT lval_to_float(lval* node);
+
+/// The result of #lval_num_cmp if a number is NaN.
+#define LVAL_UNORDERED 2
+
+/**
+ * Compare two numbers exactly.
+ *
+ * Integers and floats are compared by value without rounding, so a float
+ * only equals an integer if it is integral and has the same value.
+ *
+ * \param x The first number.
+ * \param y The second number.
+ *
+ * \returns -1, 0 or 1 if `x` is less than, equal to or greater than `y`,
+ *          #LVAL_UNORDERED if one of them is NaN.
+ */
+int lval_num_cmp(lval* x, lval* y);
+
+/**
+ * Check whether a number is zero.
+ *
+ * Numbers are the booleans of the language: every number but zero is true.
+ *
+ * \param node  The number, an integer or a float.
+ * \returns Whether the number is zero.
+ */
+bool lval_is_zero(lval* node);
+
 
 // ------------------------------------------------------------------------------
 // Printers
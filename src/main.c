@@ -91,14 +91,52 @@ char* read_input() {
 }
 
 int main(int argc, char** argv) {
+    // Parse options
+    int first_file = 1;
+    char* image = NULL;
+    char* save_image = NULL;
+    bool cache = true;
+    bool print_cache_stats = false;
+    for (; first_file < argc && strncmp(argv[first_file], "--", 2) == 0; first_file++) {
+        if (strcmp(argv[first_file], "--ast") == 0) {
+            eval_set_backend(EVAL_AST);
+        } else if (strcmp(argv[first_file], "--vm") == 0) {
+            eval_set_backend(EVAL_VM);
+        } else if (strcmp(argv[first_file], "--image") == 0 && first_file + 1 < argc) {
+            image = argv[++first_file];
+        } else if (strcmp(argv[first_file], "--save-image") == 0 && first_file + 1 < argc) {
+            save_image = argv[++first_file];
+        } else if (strcmp(argv[first_file], "--no-cache") == 0) {
+            cache = false;
+        } else if (strcmp(argv[first_file], "--cache-stats") == 0) {
+            print_cache_stats = true;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[first_file]);
+            fprintf(stderr, "Usage: %s [--ast | --vm] [--image file] [--save-image file] "
+                            "[--no-cache] [--cache-stats] [file ...]\n", argv[0]);
+            return 1;
+        }
+    }
+
     // Initialization
-    parser_init();
+    cache_set_enabled(cache);
+
     lenv* env = lenv_new();
     builtins_init(env);
+    gc_root_env(env);
 
-    if (argc >= 2) {
+    // Restore the definitions saved by --save-image
+    if (image) {
+        lval* result = image_load(env, image);
+        if (result->type == LVAL_ERR) {
+            lval_println(env, result);
+        }
+        lval_del(result);
+    }
+
+    if (argc > first_file) {
         // Loop over file names
-        for (int i = 1; i < argc; i++) {
+        for (int i = first_file; i < argc; i++) {
             lval* args   = lval_add(lval_sexpr(), lval_str(argv[i]));
             lval* result = builtin_load(env, args);
 
@@ -107,6 +145,15 @@ int main(int argc, char** argv) {
             }
             lval_del(result);
         }
+
+        // Save the definitions of the files
+        if (save_image) {
+            lval* result = image_save(env, save_image);
+            if (result->type == LVAL_ERR) {
+                lval_println(env, result);
+            }
+            lval_del(result);
+        }
     } else {
         // Welcome message
         puts("MLisp Version 0.1dev");
@@ -144,10 +191,16 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (print_cache_stats) {
+        cache_print_stats();
+    }
+
     lenv_del(env);
 
-    // Undefine and delete our parsers
-    parser_cleanup();
+#if defined MLISP_GC
+    gc_unroot_env(env);
+    gc_collect();
+#endif
 
     return 0;
 }
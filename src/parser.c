@@ -1,133 +1,657 @@
+#if ! defined _WIN32
+    // For mmap and fileno
+    #define _POSIX_C_SOURCE 200112L
+
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+
 #include "utils.h"
+#include "alloc.h"
 #include "parser.h"
 #include "eval.h"
+#include "gc.h"
+
+
+/// The state of the reader.
+typedef struct lreader {
+    char* filename;     ///< The name of the source, used in errors.
+    char* start;        ///< The beginning of the source.
+    char* pos;          ///< The next character to read.
+    char* end;          ///< The end of the source.
+    mpc_err_t* error;   ///< The syntax error, if any.
+    mpc_state_t origin; ///< The position of `start` in the source.
+} lreader;
+
+/// A reader reading a file in chunks (see #parse_stream_open).
+struct lstream {
+    FILE* file;         ///< The file being read, `NULL` if it's mapped.
+    char* buffer;       ///< The part of the file in memory or its mapping.
+    size_t capacity;    ///< The size of the buffer.
+    size_t length;      ///< The number of characters in the buffer.
+    size_t end;         ///< The end of the current chunk, `0` if none.
+    bool eof;           ///< Whether the whole file has been read.
+
+    size_t scan;        ///< The next character to scan for a chunk end.
+    int depth;          ///< The nesting depth at `scan`.
+    bool in_string;     ///< Whether `scan` is in a string,
+    bool in_comment;    ///< or a comment.
+
+    lreader reader;     ///< The reader of the current chunk.
+};
+
+/// The initial buffer size of a stream.
+#define STREAM_BUFFER_SIZE 65536
+
+/// The longest number or symbol that is copied without allocation.
+#define READER_BUFFER_SIZE 64
 
 
-mpc_parser_t* number;
-mpc_parser_t* symbol;
-mpc_parser_t* string;
-mpc_parser_t* comment;
-mpc_parser_t* sexpr;
-mpc_parser_t* qexpr;
-mpc_parser_t* expr;
-mpc_parser_t* lispy;
+/**
+ * Read a list of expressions up to a closing character.
+ *
+ * \param reader    The reader.
+ * \param node      The list to add the expressions to.
+ * \param close     The closing character, `\0` for the end of input.
+ *
+ * \returns The list or `NULL` on a syntax error (the list is deleted).
+ */
+static lval* read_list(lreader* reader, lval* node, char close);
 
 
-// TODO: Docs
-lval* parse_num(mpc_ast_t* tree);
+/// Whether a character can be part of a symbol starting with a letter.
+static bool is_symbol_char(char c) {
+    return c != '\0' && (isalpha((unsigned char) c) || strchr("_+-*/\\=<>!?&%.", c));
+}
+
+/// Whether a character can follow the digits of a symbol starting with digits.
+static bool is_symbol_tail(char c) {
+    return c != '\0' && (isalpha((unsigned char) c) || strchr("_+-*/\\=<>!?&%", c));
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
 
-lval* parse_str(char* contents);
+/// Get a character after the current position, `\0` behind the end.
+static char peek(lreader* reader, size_t offset) {
+    return reader->pos + offset < reader->end ? reader->pos[offset] : '\0';
+}
 
+/**
+ * Report a syntax error at the current position.
+ *
+ * The error is an mpc error, so it's printed like the errors of `mpc_parse`.
+ *
+ * \param reader    The reader.
+ * \param expected  The expected tokens, a `NULL` terminated array.
+ */
+static void read_error(lreader* reader, char** expected) {
+    mpc_err_t* error = xmalloc(sizeof(mpc_err_t));
+    error->filename = strdup(reader->filename);
+    error->failure  = NULL;
+    error->recieved = peek(reader, 0);
 
-void parser_init(void) {
-    number = mpc_new("number");
-    symbol = mpc_new("symbol");
-    string = mpc_new("string");
-    comment = mpc_new("comment");
-    sexpr = mpc_new("sexpr");
-    qexpr = mpc_new("qexpr");
-    expr = mpc_new("expr");
-    lispy = mpc_new("lispy");
+    // Only compute the position when it's needed
+    error->state = reader->origin;
+    error->state.pos += (int) (reader->pos - reader->start);
+    for (char* c = reader->start; c < reader->pos; c++) {
+        if (*c == '\n') {
+            error->state.row++;
+            error->state.col = 0;
+        } else {
+            error->state.col++;
+        }
+    }
 
-    // Define them with the following Language
-    mpc_err_t* err = mpca_lang(MPCA_LANG_DEFAULT, "" /*__GRAMMAR__*/,
-                               number, symbol, string, comment, sexpr, qexpr, expr, lispy);
+    error->expected_num = 0;
+    while (expected[error->expected_num]) {
+        error->expected_num++;
+    }
 
-    if (err != NULL) {
-        mpc_err_print(err);
-        mpc_err_delete(err);
-        exit(1);
+    error->expected = xmalloc(sizeof(char*) * (size_t) error->expected_num);
+    for (int i = 0; i < error->expected_num; i++) {
+        error->expected[i] = strdup(expected[i]);
     }
+
+    reader->error = error;
 }
 
-mpc_parser_t* parser_get(void) {
-    return lispy;
+/// Skip whitespace and comments.
+static void skip_space(lreader* reader) {
+    while (1) {
+        while (isspace((unsigned char) peek(reader, 0))) {
+            reader->pos++;
+        }
+
+        if (peek(reader, 0) != ';') {
+            return;
+        }
+
+        while (reader->pos < reader->end && *reader->pos != '\n' && *reader->pos != '\r') {
+            reader->pos++;
+        }
+    }
 }
 
-void parser_cleanup(void) {
-    mpc_cleanup(7, number, symbol, string, comment,  sexpr, qexpr, expr, lispy);
+/**
+ * Create a number from a token.
+ *
+ * Numbers without a decimal point are integers, big integers if they don't
+ * fit #PRECISION_INT.
+ *
+ * \param token The number's characters.
+ */
+static lval* read_number(char* token) {
+    if (!strchr(token, '.')) {
+        errno = 0;
+        long long value = strtoll(token, NULL, 10);
+
+        if (errno != ERANGE && value >= PRECISION_INT_MIN && value <= PRECISION_INT_MAX) {
+            return lval_int((PRECISION_INT) value);
+        }
+
+        return lval_big(lbig_from_str(token, strlen(token)));
+    }
+
+    return lval_num(strtod(token, NULL));
 }
 
-lval* parse_tree(mpc_ast_t* tree) {
-    // assert_not_null(tree);  // FIXME: Comment in
+/**
+ * Create a number or symbol from the characters up to the current position.
+ *
+ * \param reader    The reader.
+ * \param start     The first character of the token.
+ * \param is_number Whether the token is a number.
+ */
+static lval* read_atom(lreader* reader, char* start, bool is_number) {
+    size_t length = (size_t) (reader->pos - start);
+
+    char buffer[READER_BUFFER_SIZE];
+    char* token = length < READER_BUFFER_SIZE ? buffer : xmalloc(length + 1);
+    memcpy(token, start, length);
+    token[length] = '\0';
+
+    lval* node = is_number ? read_number(token) : lval_sym(token);
 
-    if (strstr(tree->tag, "number")) {
-        return parse_num(tree);
-    } else if (strstr(tree->tag, "symbol")) {
-        return lval_sym(tree->contents);
-    } else if (strstr(tree->tag, "string")) {
-        return parse_str(tree->contents);
+    if (token != buffer) {
+        xfree(token);
     }
 
-    lval* node = NULL;
-    // If root (">") or sexpr or qexpr, create empty list
-    if (strcmp(tree->tag, ">") == 0) {
-        node = lval_sexpr();
-    } else if (strstr(tree->tag, "sexpr")) {
-        node = lval_sexpr();
-    } else if (strstr(tree->tag, "qexpr")) {
-        node = lval_qexpr();
-    } else {
-        ASSERTF(0, "Unkown tag containing elements");
+    return node;
+}
+
+lval* parse_number(char* str, size_t length) {
+    size_t i = length > 0 && str[0] == '-' ? 1 : 0;
+    size_t digits = i;
+
+    while (i < length && is_digit(str[i])) {
+        i++;
+    }
+    if (i == digits) {
+        return NULL;
     }
 
-    // Fill this list with any valid expression contained within
-    for (int i = 0; i < tree->children_num; i++) {
-        if (strstr(tree->children[i]->tag, "comment")) {
-            continue;
-        } else if (strcmp(tree->children[i]->contents, "(") == 0) {
-            continue;
-        } else if (strcmp(tree->children[i]->contents, ")") == 0) {
-            continue;
-        } else if (strcmp(tree->children[i]->contents, "{") == 0) {
-            continue;
-        } else if (strcmp(tree->children[i]->contents, "}") == 0) {
-            continue;
-        } else if (strcmp(tree->children[i]->tag, "regex") == 0) {
-            continue;
+    if (i + 1 < length && str[i] == '.' && is_digit(str[i + 1])) {
+        i++;
+        while (i < length && is_digit(str[i])) {
+            i++;
         }
+    }
+    if (i < length) {
+        return NULL;
+    }
+
+    char buffer[READER_BUFFER_SIZE];
+    char* token = length < READER_BUFFER_SIZE ? buffer : xmalloc(length + 1);
+    memcpy(token, str, length);
+    token[length] = '\0';
+
+    lval* node = read_number(token);
 
-        node = lval_add(node, parse_tree(tree->children[i]));
+    if (token != buffer) {
+        xfree(token);
     }
 
     return node;
 }
 
-lval* parse_num(mpc_ast_t* tree) {
-    PRECISION_FLOAT val = strtod(tree->contents, NULL);
-    return lval_num(val);
+/**
+ * Read a symbol or a number.
+ *
+ * Symbols either don't contain digits at all or start with digits followed by
+ * other characters (like `1st`). Everything else starting with digits is a
+ * number. As symbols are tried first, a minus sign is always a symbol.
+ */
+static lval* read_symbol_or_number(lreader* reader) {
+    char* start = reader->pos;
+
+    if (is_symbol_char(peek(reader, 0))) {
+        while (is_symbol_char(peek(reader, 0))) {
+            reader->pos++;
+        }
+
+        return read_atom(reader, start, false);
+    }
+
+    while (is_digit(peek(reader, 0))) {
+        reader->pos++;
+    }
+
+    if (is_symbol_tail(peek(reader, 0))) {
+        while (is_symbol_tail(peek(reader, 0))) {
+            reader->pos++;
+        }
+        while (is_digit(peek(reader, 0))) {
+            reader->pos++;
+        }
+        while (is_symbol_tail(peek(reader, 0))) {
+            reader->pos++;
+        }
+
+        return read_atom(reader, start, false);
+    }
+
+    // Only read the decimal point if digits follow
+    if (peek(reader, 0) == '.' && is_digit(peek(reader, 1))) {
+        reader->pos++;
+        while (is_digit(peek(reader, 0))) {
+            reader->pos++;
+        }
+    }
+
+    return read_atom(reader, start, true);
 }
 
-lval* parse_str(char* contents) {
-    size_t len = strlen(contents);
+/**
+ * Replace the escape sequences of a string in place.
+ *
+ * Supports the escape sequences of C strings, like `mpcf_unescape`. Unknown
+ * sequences are kept as they are.
+ *
+ * \param str       The characters.
+ * \param length    The number of characters.
+ *
+ * \returns The number of characters after decoding.
+ */
+static size_t unescape(char* str, size_t length) {
+    static const char escaped[]   = "abfnrtv\\'\"0";
+    static const char unescaped[] = "\a\b\f\n\r\t\v\\'\"";
+
+    char* out = str;
+    for (char* in = str; in < str + length; out++) {
+        const char* seq = in[0] == '\\' && in[1] ? strchr(escaped, in[1]) : NULL;
 
-    // Cut off the final quote character
-    contents[len - 1] = '\0';
+        if (seq) {
+            *out = unescaped[seq - escaped];
+            in += 2;
+        } else {
+            *out = *in++;
+        }
+    }
+    *out = '\0';
+
+    return (size_t) (out - str);
+}
+
+/// Read a string literal, the reader is at the opening quote.
+static lval* read_string(lreader* reader) {
+    char* start = ++reader->pos;
+    bool escapes = false;
 
-    // Copy the string leaving out the first quote character
-    char* unescaped = NULL;
-    unescaped = strdup(contents + 1);
+    while (peek(reader, 0) != '"') {
+        if (peek(reader, 0) == '\0') {
+            read_error(reader, (char*[]) {"'\"'", NULL});
+            return NULL;
+        } else if (*reader->pos == '\\' && peek(reader, 1) != '\0') {
+            escapes = true;
+            reader->pos += 2;
+        } else {
+            reader->pos++;
+        }
+    }
 
-    // Unescape the string
-    unescaped = mpcf_unescape(unescaped);
+    // Copy the string once, only decode it if needed
+    lval* node = lval_str_len(start, (size_t) (reader->pos - start));
+    if (escapes) {
+        node->length = node->strbuf->used = unescape(node->str, node->length);
+    }
 
-    lval* node = lval_str(unescaped);
+    reader->pos++;
 
-    xfree(unescaped);
     return node;
 }
 
-bool parse(char* filename, char* str, lenv* env, lval** result, mpc_err_t** parser_error) {
-    mpc_result_t r;
-    if (mpc_parse(filename, str, parser_get(), &r)) {
-        *result = eval(env, parse_tree(r.output));
+/// Read a single expression, the reader is at its first character.
+static lval* read_expr(lreader* reader) {
+    char c = peek(reader, 0);
+
+    if (c == '(') {
+        reader->pos++;
+        return read_list(reader, lval_sexpr(), ')');
+    } else if (c == '{') {
+        reader->pos++;
+        return read_list(reader, lval_qexpr(), '}');
+    } else if (c == '"') {
+        return read_string(reader);
+    } else if (is_symbol_char(c) || is_digit(c)) {
+        return read_symbol_or_number(reader);
+    }
+
+    return NULL;
+}
+
+/**
+ * Read the next expression of a list.
+ *
+ * \param reader    The reader.
+ * \param close     The closing character of the list.
+ *
+ * \returns The expression or `NULL` at the closing character (which isn't
+ *          consumed) or on a syntax error.
+ */
+static lval* read_item(lreader* reader, char close) {
+    skip_space(reader);
+
+    if (peek(reader, 0) == close) {
+        return NULL;
+    }
+
+    lval* expr = read_expr(reader);
+    if (expr == NULL && reader->error == NULL) {
+        char* end = close == ')' ? "')'" : close == '}' ? "'}'" : "end of input";
+        read_error(reader, (char*[]) {"symbol", "number", "string", "comment",
+                                      "'('", "'{'", end, NULL});
+    }
+
+    return expr;
+}
 
-        mpc_ast_delete(r.output);
+static lval* read_list(lreader* reader, lval* node, char close) {
+    lval* expr;
+    while ((expr = read_item(reader, close))) {
+        node = lval_add(node, expr);
+    }
+
+    if (reader->error) {
+        lval_del(node);
+        return NULL;
+    }
+
+    if (close != '\0') {
+        reader->pos++;
+    }
+    return node;
+}
+
+/// Hand a syntax error to the caller or delete it.
+static void pass_error(lreader* reader, mpc_err_t** error) {
+    if (error) {
+        *error = reader->error;
+    } else {
+        mpc_err_delete(reader->error);
+    }
+    reader->error = NULL;
+}
+
+lval* parse_string(char* filename, char* str, mpc_err_t** error) {
+    ASSERT_NOT_NULL(filename);
+    ASSERT_NOT_NULL(str);
+
+    lreader reader = {filename, str, str, str + strlen(str), NULL, {0, 0, 0}};
+    lval* node = read_list(&reader, lval_sexpr(), '\0');
+
+    if (node == NULL) {
+        pass_error(&reader, error);
+    }
+
+    return node;
+}
+
+/**
+ * Map a regular file into memory instead of reading it.
+ *
+ * The whole file is a single chunk then, its symbols and strings are read
+ * straight from the mapping.
+ *
+ * \returns Whether the file has been mapped.
+ */
+static bool stream_map(lstream* stream) {
+#if defined _WIN32
+    UNUSED(stream);
+    return false;
+#else
+    struct stat info;
+    int fd = fileno(stream->file);
+
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        return false;
+    }
+
+    size_t size = (size_t) info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+
+    // The mapping stays valid without the file
+    fclose(stream->file);
+    stream->file = NULL;
+
+    stream->buffer   = mapping;
+    stream->capacity = size;
+    stream->length   = size;
+    stream->end      = size;
+    stream->scan     = size;
+    stream->eof      = true;
+
+    return true;
+#endif
+}
+
+lstream* parse_stream_open(char* filename, mpc_err_t** error) {
+    ASSERT_NOT_NULL(filename);
+
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        if (error) {
+            *error = xmalloc(sizeof(mpc_err_t));
+            (*error)->filename     = strdup(filename);
+            (*error)->failure      = strdup("Unable to open file!");
+            (*error)->expected     = NULL;
+            (*error)->expected_num = 0;
+            (*error)->recieved     = '\0';
+            (*error)->state.pos    = 0;
+            (*error)->state.row    = 0;
+            (*error)->state.col    = 0;
+        }
+        return NULL;
+    }
+
+    lstream* stream = xmalloc(sizeof(lstream));
+    stream->file       = file;
+    stream->length     = 0;
+    stream->end        = 0;
+    stream->eof        = false;
+    stream->scan       = 0;
+    stream->depth      = 0;
+    stream->in_string  = false;
+    stream->in_comment = false;
+
+    // Read files that can't be mapped (like pipes) in blocks
+    if (!stream_map(stream)) {
+        stream->capacity = STREAM_BUFFER_SIZE;
+        stream->buffer   = xmalloc(stream->capacity);
+    }
+
+    stream->reader.filename = strdup(filename);
+    stream->reader.start    = stream->buffer;
+    stream->reader.pos      = stream->buffer;
+    stream->reader.end      = stream->buffer + stream->end;
+    stream->reader.error    = NULL;
+    stream->reader.origin   = (mpc_state_t) {0, 0, 0};
+
+    return stream;
+}
+
+/**
+ * Scan for the end of the next chunk: a point outside of all lists, strings
+ * and comments where no token continues (after a newline or a list).
+ *
+ * \returns Whether the end was found, it's at `stream->scan` then.
+ */
+static bool stream_scan(lstream* stream) {
+    while (stream->scan < stream->length) {
+        char c = stream->buffer[stream->scan++];
 
-        return true;
+        if (stream->in_comment) {
+            stream->in_comment = c != '\n' && c != '\r';
+        } else if (stream->in_string) {
+            if (c == '\\' && stream->scan < stream->length) {
+                stream->scan++;
+            } else if (c == '\\') {
+                // The escaped character isn't read yet
+                stream->scan--;
+                return false;
+            } else {
+                stream->in_string = c != '"';
+            }
+        } else if (c == '"') {
+            stream->in_string = true;
+        } else if (c == ';') {
+            stream->in_comment = true;
+        } else if (c == '(' || c == '{') {
+            stream->depth++;
+        } else if (c == ')' || c == '}') {
+            // Unbalanced lists end the chunk, too: the reader reports them
+            if (--stream->depth <= 0) {
+                stream->depth = 0;
+                return true;
+            }
+        } else if (c == '\n' && stream->depth == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Find the next chunk and make it the reader's source.
+ *
+ * \returns Whether there is a chunk left.
+ */
+static bool stream_next_chunk(lstream* stream) {
+    lreader* reader = &stream->reader;
+
+    // A mapped file is a single chunk
+    if (stream->file == NULL) {
+        return false;
+    }
+
+    // Move on behind the current chunk
+    if (stream->end) {
+        for (char* c = reader->start; c < stream->buffer + stream->end; c++) {
+            if (*c == '\n') {
+                reader->origin.row++;
+                reader->origin.col = 0;
+            } else {
+                reader->origin.col++;
+            }
+        }
+        reader->origin.pos += (int) (stream->buffer + stream->end - reader->start);
+        reader->start = stream->buffer + stream->end;
+    }
+
+    size_t start = (size_t) (reader->start - stream->buffer);
+
+    while (!stream_scan(stream)) {
+        if (stream->eof) {
+            // The rest of the file is the last chunk
+            stream->scan = stream->length;
+            break;
+        }
+
+        // Drop the chunks already read, grow the buffer if it's still full
+        memmove(stream->buffer, stream->buffer + start, stream->length - start);
+        stream->length -= start;
+        stream->scan   -= start;
+        start = 0;
+
+        if (stream->length == stream->capacity) {
+            stream->capacity *= 2;
+            stream->buffer = xrealloc(stream->buffer, stream->capacity);
+        }
+
+        size_t n = fread(stream->buffer + stream->length, 1,
+                         stream->capacity - stream->length, stream->file);
+        stream->length += n;
+        stream->eof = n == 0;
+    }
+
+    stream->end = stream->scan;
+
+    reader->start = stream->buffer + start;
+    reader->pos   = reader->start;
+    reader->end   = stream->buffer + stream->end;
+
+    return stream->end > start;
+}
+
+lval* parse_stream_next(lstream* stream, mpc_err_t** error) {
+    ASSERT_NOT_NULL(stream);
+
+    lreader* reader = &stream->reader;
+
+    while (1) {
+        lval* expr = read_item(reader, '\0');
+        if (expr) {
+            return expr;
+        } else if (reader->error) {
+            pass_error(reader, error);
+            return NULL;
+        }
+
+        // The chunk has been read completely
+        if (!stream_next_chunk(stream)) {
+            return NULL;
+        }
+    }
+}
+
+void parse_stream_close(lstream* stream) {
+    ASSERT_NOT_NULL(stream);
+
+    if (stream->file) {
+        fclose(stream->file);
+        xfree(stream->buffer);
     } else {
-        *parser_error = r.error;
+#if ! defined _WIN32
+        munmap(stream->buffer, stream->length);
+#endif
+    }
+
+    xfree(stream->reader.filename);
+    xfree(stream);
+}
 
+bool parse(char* filename, char* str, lenv* env, lval** result, mpc_err_t** parser_error) {
+    lval* expr = parse_string(filename, str, parser_error);
+    if (expr == NULL) {
         return false;
     }
+
+    *result = eval(env, expr);
+    lalloc_end_eval();
+
+    gc_root_env(env); gc_root(*result);
+    gc_safepoint();
+    gc_unroot(*result); gc_unroot_env(env);
+
+    return true;
 }
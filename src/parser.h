@@ -1,6 +1,11 @@
 /**
  * \file    parser.h
  * \brief   Parsing methods.
+ *
+ * The reader turns source text into #lval objects in a single pass, without
+ * building a syntax tree first. The syntax is described in grammar.ebnf.
+ * Syntax errors are reported as mpc errors (see `mpc_err_string` and
+ * `mpc_err_delete`).
  */
 
 #pragma once
@@ -13,27 +18,69 @@
 
 #include "lval.h"
 
+
+/// A reader reading the expressions of a file one at a time.
+typedef struct lstream lstream;
+
 /**
- * Initialize the parser.
- *  
- * Has to be called before #parser_get is ever invoked!
+ * Read all expressions of a string.
+ *
+ * \param filename  The name of the source, used in errors.
+ * \param str       The source.
+ * \param error     [out] The syntax error, if reading failed. Has to be
+ *                  cleaned up with `mpc_err_delete`! May be `NULL`.
+ *
+ * \returns A S-Expression containing the expressions or `NULL` on a syntax
+ *          error.
  */
+lval* parse_string(char* filename, char* str, mpc_err_t** error);
 
-void parser_init(void);
+/**
+ * Read a number from a string.
+ *
+ * Accepts the numbers of the grammar: digits, optionally followed by a
+ * decimal point and more digits. Unlike in source text, a minus sign may
+ * precede them.
+ *
+ * \param str       The characters, don't have to be terminated.
+ * \param length    The number of characters.
+ *
+ * \returns The number or `NULL` if the string isn't one.
+ */
+lval* parse_number(char* str, size_t length);
 
 /**
- * Get the parser object.
+ * Open a file to read its top-level expressions one at a time.
  *
- * \returns A pointer to the parser object.
+ * Regular files are mapped into memory and read in place. Other files (like
+ * pipes) are read in chunks ending after a line or a list at the top level,
+ * so only the expression being read has to fit in memory, not the file.
+ *
+ * \param filename  The file to read.
+ * \param error     [out] The error, if the file can't be opened. May be `NULL`.
+ *
+ * \returns The stream or `NULL` on an error. Has to be closed with
+ *          #parse_stream_close!
  */
-mpc_parser_t* parser_get(void);
+lstream* parse_stream_open(char* filename, mpc_err_t** error);
 
 /**
- * Delete the parser object.
+ * Read the next top-level expression of a file.
+ *
+ * \param stream    The stream.
+ * \param error     [out] The syntax error, if reading failed. May be `NULL`.
+ *
+ * \returns The expression or `NULL` at the end of the file or on a syntax
+ *          error.
  */
-void parser_cleanup(void);
+lval* parse_stream_next(lstream* stream, mpc_err_t** error);
+
+/**
+ * Close a file opened with #parse_stream_open.
+ *
+ * \param stream    The stream.
+ */
+void parse_stream_close(lstream* stream);
 
 /// Call mpc_err_delete on error!
 bool parse(char* filename, char* str, lenv* env, lval** result, mpc_err_t** parser_error);
-
-lval* parse_tree(mpc_ast_t* tree);
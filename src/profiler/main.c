@@ -8,7 +8,6 @@
 #define WARMUP_RUNS 10
 static double results[RUNS] = {0};
 
-static mpc_parser_t* lispy;
 static lenv* env;
 
 void _parse(char* input) {
@@ -17,8 +16,6 @@ void _parse(char* input) {
 }
 
 void init(void) {
-    parser_init();
-    lispy = parser_get();
     env = lenv_new();
     builtins_init(env);
 
@@ -70,9 +67,7 @@ int main(int argc, char** argv) {
     if (profile) timer = timer_init();
 
     // Prepare command
-    mpc_result_t r;
-    mpc_parse("<profiler>", "fib 10", lispy, &r);
-    lval* command = parse_tree(r.output);
+    lval* command = parse_string("<profiler>", "fib 10", NULL);
 
     // Warmup run
     for (int i = 0; i < WARMUP_RUNS; i++) {
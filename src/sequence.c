@@ -0,0 +1,264 @@
+#include <stdio.h>
+
+#include "utils.h"
+#include "lval.h"
+#include "eval.h"
+#include "sequence.h"
+
+/// The state of a stage or source of a running sequence.
+typedef struct lseq_state {
+    lseq* seq;              ///< The sequence this state belongs to.
+    bool done;              ///< Whether it produced its last item.
+    PRECISION_INT next;     ///< The next integer of a range.
+    size_t index;           ///< The index of the next item of a list.
+    FILE* file;             ///< The file read by a sequence of lines.
+    char* line;             ///< The buffer for the current line.
+    size_t capacity;        ///< The size of the buffer.
+} lseq_state;
+
+struct lseq_iter {
+    size_t count;           ///< The number of stages, including the source.
+    lseq_state states[];    ///< The states, from the outermost stage to the
+                            ///< source.
+};
+
+
+lseq* lseq_new(lseq_kind kind, lval* source, lval* func) {
+    lseq* seq = xmalloc(sizeof(lseq));
+    seq->kind   = kind;
+    seq->source = source;
+    seq->func   = func;
+    seq->start  = 0;
+    seq->end    = 0;
+    seq->step   = 1;
+
+    return seq;
+}
+
+lseq* lseq_range(PRECISION_INT start, PRECISION_INT end, PRECISION_INT step) {
+    lseq* seq = lseq_new(LSEQ_RANGE, NULL, NULL);
+    seq->start = start;
+    seq->end   = end;
+    seq->step  = step;
+
+    return seq;
+}
+
+void lseq_del(lseq* seq) {
+    xfree(seq);
+}
+
+/// Whether a kind of sequence applies a function to another sequence.
+static bool is_stage(lseq_kind kind) {
+    return kind == LSEQ_MAP || kind == LSEQ_FILTER || kind == LSEQ_TAKE_WHILE;
+}
+
+lseq_iter* lseq_iter_new(lval* seq) {
+    ASSERT_NOT_NULL(seq);
+
+    size_t count = 1;
+    for (lseq* stage = seq->seq; is_stage(stage->kind); stage = stage->source->seq) {
+        count++;
+    }
+
+    lseq_iter* iter = xmalloc(sizeof(lseq_iter) + count * sizeof(lseq_state));
+    iter->count = count;
+
+    for (size_t i = 0; i < count; i++) {
+        lseq_state* state = &iter->states[i];
+        state->seq      = i == 0 ? seq->seq : iter->states[i - 1].seq->source->seq;
+        state->done     = false;
+        state->next     = state->seq->start;
+        state->index    = 0;
+        state->file     = NULL;
+        state->line     = NULL;
+        state->capacity = 0;
+    }
+
+    return iter;
+}
+
+void lseq_iter_del(lseq_iter* iter) {
+    ASSERT_NOT_NULL(iter);
+
+    for (size_t i = 0; i < iter->count; i++) {
+        if (iter->states[i].file) {
+            fclose(iter->states[i].file);
+        }
+        if (iter->states[i].line) {
+            xfree(iter->states[i].line);
+        }
+    }
+
+    xfree(iter);
+}
+
+/// Produce the next integer of a range.
+static lval* next_integer(lseq_state* state) {
+    lseq* seq = state->seq;
+    PRECISION_INT value = state->next;
+
+    if (state->done || (seq->step > 0 ? value >= seq->end : value <= seq->end)) {
+        return NULL;
+    }
+
+    // Stop instead of overflowing
+    if (seq->step > 0 ? value > PRECISION_INT_MAX - seq->step
+                      : value < PRECISION_INT_MIN - seq->step) {
+        state->done = true;
+    } else {
+        state->next = value + seq->step;
+    }
+
+    return lval_int(value);
+}
+
+/// Produce the next line of a file, without the line break.
+static lval* next_line(lseq_state* state) {
+    if (state->done) {
+        return NULL;
+    }
+
+    if (state->file == NULL) {
+        char* filename = lval_str_cstr(state->seq->source);
+
+        state->file = fopen(filename, "rb");
+        if (state->file == NULL) {
+            state->done = true;
+            return lval_err("Could not open file '%s'", filename);
+        }
+    }
+
+    // Read in chunks until the line break, the buffer grows by doubling
+    size_t length = 0;
+    while (1) {
+        if (state->capacity - length < 2) {
+            state->capacity = state->capacity ? 2 * state->capacity : 128;
+            state->line = xrealloc(state->line, state->capacity);
+        }
+
+        if (!fgets(state->line + length, (int) (state->capacity - length), state->file)) {
+            break;
+        }
+
+        length += strlen(state->line + length);
+        if (length > 0 && state->line[length - 1] == '\n') {
+            break;
+        }
+    }
+
+    if (length == 0) {
+        state->done = true;
+        return NULL;
+    }
+
+    if (state->line[length - 1] == '\n') {
+        length--;
+    }
+    if (length > 0 && state->line[length - 1] == '\r') {
+        length--;
+    }
+
+    return lval_str_len(state->line, length);
+}
+
+/**
+ * Call the function of a stage to test an item.
+ *
+ * \param env       The environment to call the function in.
+ * \param state     The stage.
+ * \param item      The item (shared).
+ * \param result    [out] Whether the function returned true.
+ *
+ * \returns `NULL` or the error of the function.
+ */
+static lval* test_item(lenv* env, lseq_state* state, lval* item, bool* result) {
+    lval* value = eval_apply(env, state->seq->func, (lval*[]) {lval_ref(item)}, 1);
+
+    if (value->type == LVAL_ERR) {
+        return value;
+    }
+
+    // Conditions are numbers, like the ones of 'if'
+    if (!lval_is_number(value)) {
+        lval* error = lval_err("Sequence stage function returned %s, expected number.",
+                               lval_str_type(value->type));
+        lval_del(value);
+        return error;
+    }
+
+    *result = !lval_is_zero(value);
+    lval_del(value);
+
+    return NULL;
+}
+
+/// Produce the next item of the stage or source `i` of a running sequence.
+static lval* next(lenv* env, lseq_iter* iter, size_t i) {
+    lseq_state* state = &iter->states[i];
+    lval* list;
+    lval* item;
+    lval* error;
+    bool accepted;
+
+    switch (state->seq->kind) {
+        case LSEQ_RANGE:
+            return next_integer(state);
+
+        case LSEQ_LIST:
+            // The items are evaluated like by 1st
+            list = state->seq->source;
+            return state->index < list->count ? eval(env, lval_ref(list->values[state->index++]))
+                                              : NULL;
+
+        case LSEQ_LINES:
+            return next_line(state);
+
+        case LSEQ_MAP:
+            item = next(env, iter, i + 1);
+            if (item == NULL || item->type == LVAL_ERR) {
+                return item;
+            }
+            return eval_apply(env, state->seq->func, &item, 1);
+
+        case LSEQ_FILTER:
+            while ((item = next(env, iter, i + 1)) && item->type != LVAL_ERR) {
+                error = test_item(env, state, item, &accepted);
+                if (error) {
+                    lval_del(item);
+                    return error;
+                } else if (accepted) {
+                    return item;
+                }
+                lval_del(item);
+            }
+            return item;
+
+        case LSEQ_TAKE_WHILE:
+            if (state->done) {
+                return NULL;
+            }
+
+            item = next(env, iter, i + 1);
+            if (item == NULL || item->type == LVAL_ERR) {
+                return item;
+            }
+
+            error = test_item(env, state, item, &accepted);
+            if (error || !accepted) {
+                lval_del(item);
+                state->done = true;
+                return error;
+            }
+            return item;
+    }
+
+    ASSERTF(0, "Invalid sequence kind: %i", state->seq->kind);
+    return NULL;
+}
+
+lval* lseq_iter_next(lenv* env, lseq_iter* iter) {
+    ASSERT_NOT_NULL(iter);
+
+    return next(env, iter, 0);
+}
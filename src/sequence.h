@@ -0,0 +1,114 @@
+/**
+ * \file    sequence.h
+ * \brief   Lazy sequences.
+ *
+ * A sequence describes how to produce items one at a time instead of holding
+ * them: a source (a range of integers, the items of a list or the lines of a
+ * file) and stages applied to each item (mapping, filtering, stopping). Like
+ * every other value, a sequence is never modified after it has been created:
+ * consuming it runs an iterator (see #lseq_iter_new), so it can be consumed
+ * again, starting from its first item.
+ *
+ * An iterator pulls each item through all stages before producing the next
+ * one. A pipeline like `(foldl f z (lazy-filter p (lazy-map g s)))` makes a
+ * single pass and never builds intermediate lists.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stdbool.h>
+    #include <stddef.h>
+#endif
+
+#include "config.h"
+
+
+// Forward declarations
+struct lval;
+struct lenv;
+
+/// The kinds of sequences.
+typedef enum lseq_kind {
+    LSEQ_RANGE,         ///< The integers from `start` up to `end` by `step`.
+    LSEQ_LIST,          ///< The values of the items of a list, `source`.
+    LSEQ_LINES,         ///< The lines of a file, `source` is its name.
+    LSEQ_MAP,           ///< The results of `func` for the items of `source`.
+    LSEQ_FILTER,        ///< The items of `source` `func` returns true for.
+    LSEQ_TAKE_WHILE     ///< The items of `source` until `func` returns false.
+} lseq_kind;
+
+/// A lazy sequence.
+typedef struct lseq {
+    lseq_kind kind;         ///< What the sequence produces.
+    struct lval* source;    ///< The list, the file name or the sequence a
+                            ///< stage is applied to, `NULL` for ranges.
+    struct lval* func;      ///< The function of a stage, `NULL` otherwise.
+    PRECISION_INT start;    ///< The first integer of a range.
+    PRECISION_INT end;      ///< The integer a range stops before.
+    PRECISION_INT step;     ///< The difference between the integers of a
+                            ///< range, not zero.
+} lseq;
+
+/// The state of a running sequence.
+typedef struct lseq_iter lseq_iter;
+
+
+/**
+ * Create a sequence.
+ *
+ * \param kind      The kind of the sequence, not a range (see #lseq_range).
+ * \param source    The source (consumed).
+ * \param func      The function of a stage (consumed), `NULL` otherwise.
+ *
+ * \returns The sequence. Has to be deleted with #lseq_del!
+ */
+lseq* lseq_new(lseq_kind kind, struct lval* source, struct lval* func);
+
+/**
+ * Create a range of integers.
+ *
+ * \param start The first integer.
+ * \param end   The integer to stop before.
+ * \param step  The difference between the integers, not zero. If it's
+ *              negative, the integers count down to `end`.
+ *
+ * \returns The sequence. Has to be deleted with #lseq_del!
+ */
+lseq* lseq_range(PRECISION_INT start, PRECISION_INT end, PRECISION_INT step);
+
+/**
+ * Delete a sequence without dropping the references to its source and
+ * function (see #lval_del).
+ *
+ * \param seq   The sequence to delete.
+ */
+void lseq_del(lseq* seq);
+
+/**
+ * Start consuming a sequence.
+ *
+ * \param seq   The sequence, of type #LVAL_SEQ. It must be kept while the
+ *              iterator runs.
+ *
+ * \returns The iterator. Has to be deleted with #lseq_iter_del!
+ */
+lseq_iter* lseq_iter_new(struct lval* seq);
+
+/**
+ * Produce the next item of a sequence.
+ *
+ * \param env   The environment to call the functions of the stages in.
+ * \param iter  The iterator.
+ *
+ * \returns The item, `NULL` after the last one or an error. After an error,
+ *          the iterator must not be used any more.
+ */
+struct lval* lseq_iter_next(struct lenv* env, lseq_iter* iter);
+
+/**
+ * Stop consuming a sequence and release the resources of the iterator (like
+ * the file read).
+ *
+ * \param iter  The iterator to delete.
+ */
+void lseq_iter_del(lseq_iter* iter);
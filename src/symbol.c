@@ -0,0 +1,28 @@
+#include "utils.h"
+#include "hash.h"
+#include "symbol.h"
+
+
+/// Maps a symbol name to its interned copy.
+static hash_t* symbols = NULL;
+
+
+char* symbol_intern(const char* name) {
+    ASSERT_NOT_NULL(name);
+
+    if (symbols == NULL) {
+        symbols = hash_new();
+    }
+
+    char* interned = hash_get(symbols, (char*) name);
+    if (interned == NULL) {
+        interned = strdup(name);
+        hash_set(symbols, interned, interned);
+    }
+
+    return interned;
+}
+
+size_t symbol_count(void) {
+    return symbols ? hash_size(symbols) : 0;
+}
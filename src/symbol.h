@@ -0,0 +1,34 @@
+/**
+ * \file    symbol.h
+ * \brief   The table of interned symbol names.
+ *
+ * Every distinct symbol name is stored only once. Symbols can be compared
+ * by comparing the pointers to their interned names, which is how #lval_eq
+ * and the environments (see #lenv) compare them.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stddef.h>
+#endif
+
+
+/**
+ * Intern a symbol name.
+ *
+ * Look up a symbol name in the symbol table and add it if it's not yet known.
+ * The returned string is owned by the symbol table and must not be freed or
+ * modified. Calling this function with equal names always returns the same
+ * pointer.
+ *
+ * \param name  The symbol name. Won't be deallocated, you'll have to
+ *              cleanup yourself.
+ *
+ * \returns The interned name.
+ */
+char* symbol_intern(const char* name);
+
+/**
+ * Get the number of interned symbols.
+ */
+size_t symbol_count(void);
@@ -118,6 +118,15 @@
 // TODO: Docs
 bool fcmp(double f1, double f2);
 
+/**
+ * Check whether two floats are exactly equal.
+ *
+ * Like `==` (NaN equals nothing), but written with ordered comparisons, which
+ * -Wfloat-equal accepts. Only for the places that really need an exact
+ * comparison, like zero tests. Evaluates its arguments twice.
+ */
+#define FLOAT_EQ(f1, f2) ((f1) <= (f2) && (f1) >= (f2))
+
 /**
  * Duplicate a string.
  *
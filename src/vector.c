@@ -0,0 +1,621 @@
+#include <math.h>
+#include <stdint.h>
+
+#include "utils.h"
+#include "vector.h"
+
+#if defined __AVX__
+    #include <immintrin.h>
+
+    /// The number of floats in a SIMD register.
+    #define SIMD_FLOATS 4
+
+    typedef __m256d simd;
+
+    #define simd_load(p)        _mm256_loadu_pd(p)
+    #define simd_store(p, x)    _mm256_storeu_pd(p, x)
+    #define simd_set(value)     _mm256_set1_pd(value)
+    #define simd_zero()         _mm256_setzero_pd()
+    #define simd_add(x, y)      _mm256_add_pd(x, y)
+    #define simd_sub(x, y)      _mm256_sub_pd(x, y)
+    #define simd_mul(x, y)      _mm256_mul_pd(x, y)
+    #define simd_div(x, y)      _mm256_div_pd(x, y)
+    #define simd_min(x, y)      _mm256_min_pd(x, y)
+    #define simd_max(x, y)      _mm256_max_pd(x, y)
+    #define simd_or(x, y)       _mm256_or_pd(x, y)
+    #define simd_lt(x, y)       _mm256_cmp_pd(x, y, _CMP_LT_OQ)
+    #define simd_eq(x, y)       _mm256_cmp_pd(x, y, _CMP_EQ_OQ)
+    #define simd_gt(x, y)       _mm256_cmp_pd(x, y, _CMP_GT_OQ)
+    #define simd_bits(mask)     _mm256_movemask_pd(mask)
+#elif defined __SSE2__
+    #include <emmintrin.h>
+
+    /// The number of floats in a SIMD register.
+    #define SIMD_FLOATS 2
+
+    typedef __m128d simd;
+
+    #define simd_load(p)        _mm_loadu_pd(p)
+    #define simd_store(p, x)    _mm_storeu_pd(p, x)
+    #define simd_set(value)     _mm_set1_pd(value)
+    #define simd_zero()         _mm_setzero_pd()
+    #define simd_add(x, y)      _mm_add_pd(x, y)
+    #define simd_sub(x, y)      _mm_sub_pd(x, y)
+    #define simd_mul(x, y)      _mm_mul_pd(x, y)
+    #define simd_div(x, y)      _mm_div_pd(x, y)
+    #define simd_min(x, y)      _mm_min_pd(x, y)
+    #define simd_max(x, y)      _mm_max_pd(x, y)
+    #define simd_or(x, y)       _mm_or_pd(x, y)
+    #define simd_lt(x, y)       _mm_cmplt_pd(x, y)
+    #define simd_eq(x, y)       _mm_cmpeq_pd(x, y)
+    #define simd_gt(x, y)       _mm_cmpgt_pd(x, y)
+    #define simd_bits(mask)     _mm_movemask_pd(mask)
+#endif
+
+#if defined SIMD_FLOATS
+    /// Add up the lanes of a SIMD register.
+    static PRECISION_FLOAT simd_sum(simd x) {
+        PRECISION_FLOAT lanes[SIMD_FLOATS];
+        simd_store(lanes, x);
+
+        PRECISION_FLOAT sum = 0;
+        for (size_t i = 0; i < SIMD_FLOATS; i++) {
+            sum += lanes[i];
+        }
+        return sum;
+    }
+
+    /**
+     * Apply a SIMD operator to the items of two float arrays while whole
+     * registers are left, advancing `i`. `sx` and `sy` are 1 to step through
+     * an array and 0 to repeat its first item.
+     */
+    #define SIMD_MAP(simd_op) \
+        if (n >= SIMD_FLOATS) { \
+            simd first_x = simd_set(x[0]); \
+            simd first_y = simd_set(y[0]); \
+            for (; i + SIMD_FLOATS <= n; i += SIMD_FLOATS) { \
+                simd a = sx ? simd_load(&x[i]) : first_x; \
+                simd b = sy ? simd_load(&y[i]) : first_y; \
+                simd_store(&out[i], simd_op(a, b)); \
+            } \
+        }
+#else
+    #define SIMD_MAP(simd_op)
+#endif
+
+
+// ------------------------------------------------------------------------------
+// Kernels: `sx` and `sy` are 1 to step through an array and 0 to repeat its
+// first item, `n` is the number of results
+
+/// Call a kernel with constant steps, so it's compiled for each of them and
+/// the loops over whole arrays can be vectorized.
+#define CALL_KERNEL(kernel, x, sx, y, sy, out, n) \
+    ((sx) && (sy) ? kernel(x, 1, y, 1, out, n) \
+     : (sx) ? kernel(x, 1, y, 0, out, n) : kernel(x, 0, y, 1, out, n))
+
+/// Define a kernel applying a float operator to each pair of items.
+#define FLOAT_KERNEL(name, simd_op, op) \
+    static inline void name(const PRECISION_FLOAT* x, size_t sx, const PRECISION_FLOAT* y, size_t sy, \
+                     PRECISION_FLOAT* restrict out, size_t n) { \
+        size_t i = 0; \
+        SIMD_MAP(simd_op) \
+        for (; i < n; i++) { \
+            out[i] = x[i * sx] op y[i * sy]; \
+        } \
+    }
+
+FLOAT_KERNEL(float_add, simd_add, +)
+FLOAT_KERNEL(float_sub, simd_sub, -)
+FLOAT_KERNEL(float_mul, simd_mul, *)
+FLOAT_KERNEL(float_div, simd_div, /)
+
+static inline void float_mod(const PRECISION_FLOAT* x, size_t sx, const PRECISION_FLOAT* y, size_t sy,
+                      PRECISION_FLOAT* restrict out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = fmod(x[i * sx], y[i * sy]);
+    }
+}
+
+/// Add integers, returns whether no sum overflows.
+static inline bool int_add(const PRECISION_INT* x, size_t sx, const PRECISION_INT* y, size_t sy,
+                    PRECISION_INT* restrict out, size_t n) {
+    // The sign of a sum differs from both operands' only if it overflows
+    uint64_t overflow = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t a = (uint64_t) x[i * sx];
+        uint64_t b = (uint64_t) y[i * sy];
+        uint64_t r = a + b;
+
+        overflow |= (a ^ r) & (b ^ r);
+        out[i] = (PRECISION_INT) r;
+    }
+
+    return (overflow >> 63) == 0;
+}
+
+/// Subtract integers, returns whether no difference overflows.
+static inline bool int_sub(const PRECISION_INT* x, size_t sx, const PRECISION_INT* y, size_t sy,
+                    PRECISION_INT* restrict out, size_t n) {
+    // Only operands of different signs can overflow, to the sign of `b`
+    uint64_t overflow = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t a = (uint64_t) x[i * sx];
+        uint64_t b = (uint64_t) y[i * sy];
+        uint64_t r = a - b;
+
+        overflow |= (a ^ b) & (a ^ r);
+        out[i] = (PRECISION_INT) r;
+    }
+
+    return (overflow >> 63) == 0;
+}
+
+/// Multiply two integers, returns whether the product overflows.
+static inline bool mul_overflows(PRECISION_INT a, PRECISION_INT b, PRECISION_INT* result) {
+#if defined __GNUC__
+    return __builtin_mul_overflow(a, b, result);
+#else
+    if (a > 0 ? (b > 0 ? a > PRECISION_INT_MAX / b : b < PRECISION_INT_MIN / a)
+              : (b > 0 ? a < PRECISION_INT_MIN / b : (a != 0 && b < PRECISION_INT_MAX / a))) {
+        return true;
+    }
+    *result = a * b;
+    return false;
+#endif
+}
+
+/// Multiply integers, returns whether no product overflows.
+static inline bool int_mul(const PRECISION_INT* x, size_t sx, const PRECISION_INT* y, size_t sy,
+                    PRECISION_INT* restrict out, size_t n) {
+    bool overflow = false;
+
+    for (size_t i = 0; i < n; i++) {
+        overflow |= mul_overflows(x[i * sx], y[i * sy], &out[i]);
+    }
+
+    return !overflow;
+}
+
+/// Divide integers by non-zero divisors, returns whether all are exact.
+static inline bool int_div(const PRECISION_INT* x, size_t sx, const PRECISION_INT* y, size_t sy,
+                    PRECISION_INT* restrict out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        PRECISION_INT a = x[i * sx];
+        PRECISION_INT b = y[i * sy];
+
+        if ((a == PRECISION_INT_MIN && b == -1) || a % b != 0) {
+            return false;
+        }
+        out[i] = a / b;
+    }
+
+    return true;
+}
+
+/// Compute the remainders of integers by non-zero divisors, always exact.
+static inline bool int_mod(const PRECISION_INT* x, size_t sx, const PRECISION_INT* y, size_t sy,
+                    PRECISION_INT* restrict out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        PRECISION_INT b = y[i * sy];
+        out[i] = b == -1 ? 0 : x[i * sx] % b;
+    }
+
+    return true;
+}
+
+
+// ------------------------------------------------------------------------------
+// Vectors
+
+/// The size of the items of a vector.
+#define ITEM_SIZE(integers) ((integers) ? sizeof(PRECISION_INT) : sizeof(PRECISION_FLOAT))
+
+lvec* lvec_new(bool integers, size_t count) {
+    // The items follow the vector in the same allocation
+    lvec* x = xmalloc(sizeof(lvec) + ITEM_SIZE(integers) * count);
+    x->integers = integers;
+    x->count = count;
+
+    if (integers) {
+        x->ints = (PRECISION_INT*) (x + 1);
+    } else {
+        x->floats = (PRECISION_FLOAT*) (x + 1);
+    }
+
+    return x;
+}
+
+lvec* lvec_copy(lvec* x) {
+    ASSERT_NOT_NULL(x);
+
+    lvec* copy = lvec_new(x->integers, x->count);
+    memcpy(copy + 1, x + 1, ITEM_SIZE(x->integers) * x->count);
+
+    return copy;
+}
+
+void lvec_del(lvec* x) {
+    xfree(x);
+}
+
+lvec* lvec_to_floats(lvec* x) {
+    if (!x->integers) {
+        return lvec_copy(x);
+    }
+
+    lvec* floats = lvec_new(false, x->count);
+    for (size_t i = 0; i < x->count; i++) {
+        floats->floats[i] = (PRECISION_FLOAT) x->ints[i];
+    }
+
+    return floats;
+}
+
+lvec* lvec_slice(lvec* x, size_t start, size_t end) {
+    ASSERTF(start <= end && end <= x->count, "Invalid slice [%zu, %zu) of %zu items",
+            start, end, x->count);
+
+    lvec* slice = lvec_new(x->integers, end - start);
+    size_t size = ITEM_SIZE(x->integers);
+    memcpy(slice + 1, (char*) (x + 1) + size * start, size * (end - start));
+
+    return slice;
+}
+
+bool lvec_eq(lvec* x, lvec* y) {
+    if (x->count != y->count) {
+        return false;
+    }
+
+    for (size_t i = 0; i < x->count; i++) {
+        bool equal;
+        if (x->integers && y->integers) {
+            equal = x->ints[i] == y->ints[i];
+        } else {
+            equal = fcmp(x->integers ? (PRECISION_FLOAT) x->ints[i] : x->floats[i],
+                         y->integers ? (PRECISION_FLOAT) y->ints[i] : y->floats[i]);
+        }
+
+        if (!equal) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Whether any item of a vector is zero.
+static bool has_zero(lvec* x) {
+    for (size_t i = 0; i < x->count; i++) {
+        if (x->integers ? x->ints[i] == 0 : FLOAT_EQ(x->floats[i], 0)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+lvec* lvec_arith(char op, lvec* x, lvec* y) {
+    ASSERTF(x->count == y->count || x->count == 1 || y->count == 1,
+            "Can't pair %zu items with %zu items", x->count, y->count);
+
+    if ((op == '/' || op == '%') && has_zero(y)) {
+        return NULL;
+    }
+
+    size_t count = x->count == 1 ? y->count : x->count;
+    size_t sx = x->count == 1 ? 0 : 1;
+    size_t sy = y->count == 1 ? 0 : 1;
+
+    if (x->integers && y->integers) {
+        lvec* result = lvec_new(true, count);
+        bool exact;
+
+        switch (op) {
+            case '+': exact = CALL_KERNEL(int_add, x->ints, sx, y->ints, sy, result->ints, count); break;
+            case '-': exact = CALL_KERNEL(int_sub, x->ints, sx, y->ints, sy, result->ints, count); break;
+            case '*': exact = CALL_KERNEL(int_mul, x->ints, sx, y->ints, sy, result->ints, count); break;
+            case '/': exact = CALL_KERNEL(int_div, x->ints, sx, y->ints, sy, result->ints, count); break;
+            case '%': exact = CALL_KERNEL(int_mod, x->ints, sx, y->ints, sy, result->ints, count); break;
+            default:
+                ASSERTF(0, "Invalid op in lvec_arith: %c", op);
+                exact = false;
+        }
+
+        if (exact) {
+            return result;
+        }
+        lvec_del(result);
+    }
+
+    // Compute with floats
+    lvec* a = x->integers ? lvec_to_floats(x) : x;
+    lvec* b = y->integers ? lvec_to_floats(y) : y;
+    lvec* result = lvec_new(false, count);
+
+    switch (op) {
+        case '+': CALL_KERNEL(float_add, a->floats, sx, b->floats, sy, result->floats, count); break;
+        case '-': CALL_KERNEL(float_sub, a->floats, sx, b->floats, sy, result->floats, count); break;
+        case '*': CALL_KERNEL(float_mul, a->floats, sx, b->floats, sy, result->floats, count); break;
+        case '/': CALL_KERNEL(float_div, a->floats, sx, b->floats, sy, result->floats, count); break;
+        case '%': CALL_KERNEL(float_mod, a->floats, sx, b->floats, sy, result->floats, count); break;
+        default:  ASSERTF(0, "Invalid op in lvec_arith: %c", op);
+    }
+
+    if (a != x) {
+        lvec_del(a);
+    }
+    if (b != y) {
+        lvec_del(b);
+    }
+
+    return result;
+}
+
+lvec* lvec_compare(lvec* x, lvec* y, int orders) {
+    ASSERTF(x->count == y->count || x->count == 1 || y->count == 1,
+            "Can't pair %zu items with %zu items", x->count, y->count);
+
+    size_t count = x->count == 1 ? y->count : x->count;
+    size_t sx = x->count == 1 ? 0 : 1;
+    size_t sy = y->count == 1 ? 0 : 1;
+    lvec* result = lvec_new(true, count);
+    PRECISION_INT* out = result->ints;
+
+    if (x->integers && y->integers) {
+        // The order is 0 for less, 1 for equal and 2 for greater, the bit
+        // of the order in `orders` is the result
+        for (size_t i = 0; i < count; i++) {
+            PRECISION_INT a = x->ints[i * sx];
+            PRECISION_INT b = y->ints[i * sy];
+            out[i] = (orders >> ((a > b) - (a < b) + 1)) & 1;
+        }
+
+        return result;
+    }
+
+    lvec* fx = x->integers ? lvec_to_floats(x) : x;
+    lvec* fy = y->integers ? lvec_to_floats(y) : y;
+    PRECISION_FLOAT* a = fx->floats;
+    PRECISION_FLOAT* b = fy->floats;
+    size_t i = 0;
+
+#if defined SIMD_FLOATS
+    if (count >= SIMD_FLOATS) {
+        simd first_a = simd_set(a[0]);
+        simd first_b = simd_set(b[0]);
+
+        for (; i + SIMD_FLOATS <= count; i += SIMD_FLOATS) {
+            simd va = sx ? simd_load(&a[i]) : first_a;
+            simd vb = sy ? simd_load(&b[i]) : first_b;
+            simd mask = simd_zero();
+
+            if (orders & LVEC_LT) { mask = simd_or(mask, simd_lt(va, vb)); }
+            if (orders & LVEC_EQ) { mask = simd_or(mask, simd_eq(va, vb)); }
+            if (orders & LVEC_GT) { mask = simd_or(mask, simd_gt(va, vb)); }
+
+            int bits = simd_bits(mask);
+            for (size_t lane = 0; lane < SIMD_FLOATS; lane++) {
+                out[i + lane] = (bits >> lane) & 1;
+            }
+        }
+    }
+#endif
+
+    // NaN is neither less, equal nor greater than anything
+    for (; i < count; i++) {
+        PRECISION_FLOAT va = a[i * sx];
+        PRECISION_FLOAT vb = b[i * sy];
+        out[i] = ((orders & LVEC_LT) && va < vb) || ((orders & LVEC_EQ) && FLOAT_EQ(va, vb))
+                 || ((orders & LVEC_GT) && va > vb);
+    }
+
+    if (fx != x) {
+        lvec_del(fx);
+    }
+    if (fy != y) {
+        lvec_del(fy);
+    }
+
+    return result;
+}
+
+bool lvec_int_sum(lvec* x, PRECISION_INT* result) {
+    if (x->count >= 0x80000000u) {
+        return false;
+    }
+
+    // Like the sums of integers (see builtin_op): the upper and lower 32 bits
+    // are added apart, neither sum overflows for less than 2^31 items
+    int64_t high = 0;
+    int64_t low  = 0;
+
+    for (size_t i = 0; i < x->count; i++) {
+        high += x->ints[i] >> 32;
+        low  += x->ints[i] & 0xFFFFFFFF;
+    }
+
+    high += low >> 32;
+    low  &= 0xFFFFFFFF;
+
+    if (high < -0x80000000LL || high > 0x7FFFFFFF) {
+        return false;
+    }
+
+    *result = high * 0x100000000 + low;
+    return true;
+}
+
+PRECISION_FLOAT lvec_float_sum(lvec* x) {
+    if (x->integers) {
+        PRECISION_FLOAT sum = 0;
+        for (size_t i = 0; i < x->count; i++) {
+            sum += (PRECISION_FLOAT) x->ints[i];
+        }
+        return sum;
+    }
+
+    PRECISION_FLOAT* items = x->floats;
+    PRECISION_FLOAT sum = 0;
+    size_t i = 0;
+
+#if defined SIMD_FLOATS
+    // Two registers of partial sums hide the latency of the additions
+    simd sum0 = simd_zero();
+    simd sum1 = simd_zero();
+
+    for (; i + 2 * SIMD_FLOATS <= x->count; i += 2 * SIMD_FLOATS) {
+        sum0 = simd_add(sum0, simd_load(&items[i]));
+        sum1 = simd_add(sum1, simd_load(&items[i + SIMD_FLOATS]));
+    }
+    sum = simd_sum(simd_add(sum0, sum1));
+#endif
+
+    for (; i < x->count; i++) {
+        sum += items[i];
+    }
+
+    return sum;
+}
+
+bool lvec_int_dot(lvec* x, lvec* y, PRECISION_INT* result) {
+    ASSERTF(x->count == y->count, "Can't pair %zu items with %zu items", x->count, y->count);
+
+    bool overflow = false;
+    uint64_t sum_overflow = 0;
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < x->count; i++) {
+        PRECISION_INT product = 0;
+        overflow |= mul_overflows(x->ints[i], y->ints[i], &product);
+
+        uint64_t next = sum + (uint64_t) product;
+        sum_overflow |= (sum ^ next) & ((uint64_t) product ^ next);
+        sum = next;
+    }
+
+    if (overflow || (sum_overflow >> 63) != 0) {
+        return false;
+    }
+
+    *result = (PRECISION_INT) sum;
+    return true;
+}
+
+PRECISION_FLOAT lvec_float_dot(lvec* x, lvec* y) {
+    ASSERTF(x->count == y->count, "Can't pair %zu items with %zu items", x->count, y->count);
+
+    lvec* fx = x->integers ? lvec_to_floats(x) : x;
+    lvec* fy = y->integers ? lvec_to_floats(y) : y;
+    PRECISION_FLOAT* a = fx->floats;
+    PRECISION_FLOAT* b = fy->floats;
+    PRECISION_FLOAT sum = 0;
+    size_t i = 0;
+
+#if defined SIMD_FLOATS
+    simd sum0 = simd_zero();
+    simd sum1 = simd_zero();
+
+    for (; i + 2 * SIMD_FLOATS <= x->count; i += 2 * SIMD_FLOATS) {
+        sum0 = simd_add(sum0, simd_mul(simd_load(&a[i]), simd_load(&b[i])));
+        sum1 = simd_add(sum1, simd_mul(simd_load(&a[i + SIMD_FLOATS]),
+                                       simd_load(&b[i + SIMD_FLOATS])));
+    }
+    sum = simd_sum(simd_add(sum0, sum1));
+#endif
+
+    for (; i < x->count; i++) {
+        sum += a[i] * b[i];
+    }
+
+    if (fx != x) {
+        lvec_del(fx);
+    }
+    if (fy != y) {
+        lvec_del(fy);
+    }
+
+    return sum;
+}
+
+/// Find the smallest or biggest of integers.
+static inline PRECISION_INT int_extreme(const PRECISION_INT* items, size_t n, bool max) {
+    PRECISION_INT value = items[0];
+
+    for (size_t i = 1; i < n; i++) {
+        value = (max ? items[i] > value : items[i] < value) ? items[i] : value;
+    }
+
+    return value;
+}
+
+/// Find the smallest or biggest of floats, NaN never replaces the value found
+/// so far.
+static inline PRECISION_FLOAT float_extreme(const PRECISION_FLOAT* items, size_t n, bool max) {
+    PRECISION_FLOAT value = items[0];
+    size_t i = 1;
+
+#if defined SIMD_FLOATS
+    if (n >= SIMD_FLOATS) {
+        simd extreme = simd_set(value);
+        for (i = 0; i + SIMD_FLOATS <= n; i += SIMD_FLOATS) {
+            simd next = simd_load(&items[i]);
+            extreme = max ? simd_max(next, extreme) : simd_min(next, extreme);
+        }
+
+        PRECISION_FLOAT lanes[SIMD_FLOATS];
+        simd_store(lanes, extreme);
+        for (size_t lane = 0; lane < SIMD_FLOATS; lane++) {
+            value = (max ? lanes[lane] > value : lanes[lane] < value) ? lanes[lane] : value;
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        value = (max ? items[i] > value : items[i] < value) ? items[i] : value;
+    }
+
+    return value;
+}
+
+size_t lvec_extreme(lvec* x, bool max) {
+    ASSERTF(x->count > 0, "No extreme of an empty vector");
+
+    // Find the value first, then its first index. The extremes are inlined
+    // for either direction, their loops don't check it.
+    if (x->integers) {
+        PRECISION_INT value = max ? int_extreme(x->ints, x->count, true)
+                                  : int_extreme(x->ints, x->count, false);
+        size_t i = 0;
+        while (x->ints[i] != value) {
+            i++;
+        }
+        return i;
+    }
+
+    PRECISION_FLOAT value = max ? float_extreme(x->floats, x->count, true)
+                                : float_extreme(x->floats, x->count, false);
+    size_t i = 0;
+
+#if defined SIMD_FLOATS
+    simd target = simd_set(value);
+    for (; i + SIMD_FLOATS <= x->count; i += SIMD_FLOATS) {
+        if (simd_bits(simd_eq(simd_load(&x->floats[i]), target))) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < x->count; i++) {
+        if (FLOAT_EQ(x->floats[i], value)) {
+            return i;
+        }
+    }
+
+    // Only NaN
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * \file    vector.h
+ * \brief   Packed vectors of numbers.
+ *
+ * A vector stores its items unboxed and next to each other: either all of
+ * them are integers (#PRECISION_INT) or all of them are floats
+ * (#PRECISION_FLOAT). The operations work on whole vectors at once, so
+ * numeric data doesn't have to go through a list of #lval objects. Like big
+ * integers, vectors are never modified after they have been created, all
+ * operations return new ones.
+ *
+ * The float kernels use SSE2 or AVX, depending on the instruction set the
+ * code is compiled for, and plain loops otherwise. Integer kernels are plain
+ * loops without branches, compilers vectorize them where the instruction set
+ * allows.
+ *
+ * Integer vectors stay exact as long as all results fit #PRECISION_INT.
+ * Vectors can't hold big integers: if any result overflows, the whole result
+ * is computed with floats. Sums and dot products are reduced in several lanes
+ * at once, float results may differ from adding up the items one by one in
+ * the last bits.
+ */
+#pragma once
+
+#if ! defined MLISP_NOINCLUDE
+    #include <stdbool.h>
+    #include <stddef.h>
+    #include <stdint.h>
+#endif
+
+#include "config.h"
+
+
+/// A packed vector of numbers.
+typedef struct lvec {
+    bool integers;              ///< Whether the items are integers or floats.
+    size_t count;               ///< The number of items.
+    union {
+        PRECISION_INT* ints;    ///< The items of an integer vector.
+        PRECISION_FLOAT* floats;///< The items of a float vector.
+    };
+} lvec;
+
+/// The orders of two items, combined to the orders a comparison accepts
+/// (see #lvec_compare).
+typedef enum lvec_order {
+    LVEC_LT = 1,    ///< The first item is less than the second one.
+    LVEC_EQ = 2,    ///< The items are equal.
+    LVEC_GT = 4     ///< The first item is greater than the second one.
+} lvec_order;
+
+
+/**
+ * Create a vector with uninitialized items.
+ *
+ * \param integers  Whether the items are integers or floats.
+ * \param count     The number of items.
+ *
+ * \returns The vector. Has to be deleted with #lvec_del!
+ */
+lvec* lvec_new(bool integers, size_t count);
+
+/**
+ * Copy a vector.
+ *
+ * \param x The vector to copy.
+ * \returns The copy.
+ */
+lvec* lvec_copy(lvec* x);
+
+/**
+ * Delete a vector.
+ *
+ * \param x The vector to delete.
+ */
+void lvec_del(lvec* x);
+
+/**
+ * Convert the items of a vector to floats.
+ *
+ * \param x The vector.
+ * \returns A new float vector, a copy if `x` is one already.
+ */
+lvec* lvec_to_floats(lvec* x);
+
+/**
+ * Copy a range of a vector's items.
+ *
+ * \param x     The vector.
+ * \param start The index of the first item, not after `end`.
+ * \param end   The index after the last item, not after the last item of `x`.
+ *
+ * \returns The items `x[start..end)`, a new vector.
+ */
+lvec* lvec_slice(lvec* x, size_t start, size_t end);
+
+/**
+ * Check whether two vectors have the same items.
+ *
+ * Integers and floats are compared by value, like numbers (see #lval_eq).
+ */
+bool lvec_eq(lvec* x, lvec* y);
+
+/**
+ * Apply an operator to each pair of items.
+ *
+ * Either vector may have a single item, it is paired with every item of the
+ * other one. Otherwise both must have the same number of items.
+ *
+ * Like with numbers, the result of integers is an integer vector unless a
+ * result overflows or a division has a remainder.
+ *
+ * \param op    The operator: `+`, `-`, `*`, `/` or `%`.
+ * \param x     The first operands.
+ * \param y     The second operands.
+ *
+ * \returns The results, a new vector, or `NULL` if `op` divides by zero.
+ */
+lvec* lvec_arith(char op, lvec* x, lvec* y);
+
+/**
+ * Compare each pair of items.
+ *
+ * The items are paired like by #lvec_arith.
+ *
+ * \param x         The first operands.
+ * \param y         The second operands.
+ * \param orders    The accepted orders, a combination of #lvec_order.
+ *
+ * \returns A new integer vector, 1 where the order of the items is accepted
+ *          and 0 otherwise.
+ */
+lvec* lvec_compare(lvec* x, lvec* y, int orders);
+
+/**
+ * Add up the items of an integer vector.
+ *
+ * \param x             The integer vector.
+ * \param result [out]  The sum, only set if it fits.
+ *
+ * \returns Whether the sum fits #PRECISION_INT.
+ */
+bool lvec_int_sum(lvec* x, PRECISION_INT* result);
+
+/**
+ * Add up the items of a vector as floats.
+ *
+ * \param x The vector.
+ * \returns The sum.
+ */
+PRECISION_FLOAT lvec_float_sum(lvec* x);
+
+/**
+ * Compute the dot product of two integer vectors of the same length.
+ *
+ * \param x             The first integer vector.
+ * \param y             The second integer vector.
+ * \param result [out]  The dot product, only set if it fits.
+ *
+ * \returns Whether no product or partial sum overflows #PRECISION_INT.
+ */
+bool lvec_int_dot(lvec* x, lvec* y, PRECISION_INT* result);
+
+/**
+ * Compute the dot product of two vectors of the same length as floats.
+ *
+ * \param x The first vector.
+ * \param y The second vector.
+ *
+ * \returns The dot product.
+ */
+PRECISION_FLOAT lvec_float_dot(lvec* x, lvec* y);
+
+/**
+ * Find the smallest or the biggest item of a vector.
+ *
+ * \param x     The vector, not empty.
+ * \param max   Whether to find the biggest item.
+ *
+ * \returns The index of the first item with the smallest or biggest value.
+ */
+size_t lvec_extreme(lvec* x, bool max);
@@ -0,0 +1,198 @@
+#include "utils.h"
+#include "alloc.h"
+#include "vm.h"
+#include "gc.h"
+#include "eval.h"
+#include "builtins/builtin.h"
+
+
+/// The value stack, shared by all running code.
+static lval** stack = NULL;
+
+/// The number of values on the stack.
+static size_t stack_size = 0;
+
+/// The number of values the stack can hold.
+static size_t stack_capacity = 0;
+
+
+/// Push a value to the stack.
+static void push(lval* value) {
+    if (stack_size == stack_capacity) {
+        stack_capacity = stack_capacity ? stack_capacity * 2 : 256;
+        stack = xrealloc(stack, LVAL_PTR_SIZE * stack_capacity);
+    }
+
+    stack[stack_size++] = value;
+}
+
+/// Call the function with `count - 1` arguments from the top of the stack.
+static lval* call(lenv* env, size_t count, ltail* tail) {
+    stack_size -= count;
+    lval* func = stack[stack_size];
+
+    // Ensure first element is a function
+    if (func->type != LVAL_FUNC) {
+        char* repr = lval_to_str(env, func);
+        lval* error = lval_err("First element is not a function: %s", repr);
+        xfree(repr);
+
+        for (size_t i = 0; i < count; i++) {
+            lval_del(stack[stack_size + i]);
+        }
+        return error;
+    }
+
+    // Move the arguments from the stack to the argument list
+    lval* args = lval_sexpr_from(&stack[stack_size + 1], count - 1);
+
+    return eval_call(env, func, args, tail);
+}
+
+lval* vm_run(lenv* env, lcode* code, ltail* tail) {
+    size_t base = stack_size;
+    uint32_t* pc = code->ops;
+    lval* value;
+
+    while (1) {
+        uint32_t instr = *pc++;
+
+        switch (LCODE_OP(instr)) {
+            case OP_CONST:
+                value = lval_ref(code->constants[LCODE_ARG(instr)]);
+                break;
+
+            case OP_LOAD:
+                value = lenv_get(env, code->constants[LCODE_ARG(instr)]);
+                break;
+
+            case OP_LOCAL:
+                ASSERTF(env->slots && env->slots[LCODE_ARG(instr)], "unbound slot");
+                value = lval_ref(env->slots[LCODE_ARG(instr)]);
+                break;
+
+            case OP_CALL:
+                value = call(env, LCODE_ARG(instr), NULL);
+                break;
+
+            case OP_TAILCALL:
+                value = call(env, LCODE_ARG(instr), tail);
+
+                // The call is run by the caller
+                if (value == NULL) {
+                    ASSERTF(stack_size == base, "unbalanced stack");
+                    return NULL;
+                }
+                break;
+
+            case OP_IF: {
+                lval* func = stack[stack_size - 2];
+                if (func->type != LVAL_FUNC || func->builtin != builtin_if) {
+                    pc = code->ops + LCODE_ARG(instr);
+                    continue;
+                }
+
+                lval* cond = stack[stack_size - 1];
+                stack_size -= 2;
+                lval_del(func);
+
+                if (!lval_is_number(cond)) {
+                    value = lval_err("Function '%s' passed incorrect argument types. Expected number, got %s.",
+                                     "if", lval_str_type(cond->type));
+                    lval_del(cond);
+                    break;
+                }
+
+                // Skip the jump to the else branch
+                if (!lval_is_zero(cond)) {
+                    pc++;
+                }
+
+                lval_del(cond);
+                continue;
+            }
+
+            case OP_AND:
+            case OP_OR: {
+                bool is_and = LCODE_OP(instr) == OP_AND;
+                lval* func  = stack[stack_size - 2];
+                lval* first = stack[stack_size - 1];
+
+                // Other functions and numbers not deciding the result are left to the call
+                if (func->type != LVAL_FUNC || func->builtin != (is_and ? builtin_and : builtin_or)
+                        || (lval_is_number(first) && lval_is_zero(first) != is_and)) {
+                    continue;
+                }
+
+                stack_size -= 2;
+                lval_del(func);
+
+                // The second operand isn't evaluated after an invalid first one
+                if (!lval_is_number(first)) {
+                    value = lval_err("Function '%s' passed incorrect argument types. Expected number, got %s.",
+                                     is_and ? "and" : "or", lval_str_type(first->type));
+                    lval_del(first);
+                    break;
+                }
+
+                lval_del(first);
+                value = lval_int(!is_and);
+                pc = code->ops + LCODE_ARG(instr);
+                break;
+            }
+
+            case OP_QUOTE: {
+                lval* func = stack[stack_size - 1];
+                if (func->type != LVAL_FUNC || func->builtin != builtin_quote) {
+                    pc = code->ops + LCODE_ARG(instr);
+                    continue;
+                }
+
+                stack_size--;
+                lval_del(func);
+                continue;
+            }
+
+            case OP_JUMP:
+                pc = code->ops + LCODE_ARG(instr);
+                continue;
+
+            case OP_RETURN:
+                ASSERTF(stack_size == base + 1, "unbalanced stack");
+                return stack[--stack_size];
+
+            default:
+                ASSERTF(0, "Invalid opcode: %i", LCODE_OP(instr));
+                return lval_err("Invalid opcode: %i", LCODE_OP(instr));
+        }
+
+        // Errors abort the whole expression
+        if (value->type == LVAL_ERR) {
+            while (stack_size > base) {
+                lval_del(stack[--stack_size]);
+            }
+
+            return value;
+        }
+
+        push(value);
+    }
+}
+
+lval* vm_eval(lenv* env, lval* expr, ltail* tail) {
+    lcode* code = lcode_compile(expr);
+    lval_del(expr);
+
+    lval* result = vm_run(env, code, tail);
+    lcode_del(code);
+
+    return result;
+}
+
+#if defined MLISP_GC
+    void vm_mark_stack(void) {
+        for (size_t i = 0; i < stack_size; i++) {
+            gc_mark(stack[i]);
+        }
+    }
+#endif
@@ -0,0 +1,44 @@
+/**
+ * \file    vm.h
+ * \brief   Runs bytecode produced by the compiler (see compiler.h).
+ */
+#pragma once
+
+#include "lval.h"
+#include "lenv.h"
+#include "compiler.h"
+#include "eval.h"
+
+
+/**
+ * Run compiled code.
+ *
+ * \param env   The environment in which to run the code.
+ * \param code  The code to run. Won't be deallocated.
+ * \param tail  Where to store a call in tail position (see #eval_call) or
+ *              `NULL` to run all calls.
+ *
+ * \returns A #lval containing the result or `NULL` if `tail` has been set.
+ */
+lval* vm_run(lenv* env, lcode* code, ltail* tail);
+
+/**
+ * Compile and run an expression.
+ *
+ * Has the same effect as evaluating the expression with the AST walker
+ * (see #eval_sexpr). Consumes expr.
+ *
+ * \param env   The environment in which to evaluate the expression.
+ * \param expr  The S-Expression to evaluate.
+ * \param tail  Where to store a call in tail position or `NULL`.
+ *
+ * \returns A #lval containing the result or `NULL` if `tail` has been set.
+ */
+lval* vm_eval(lenv* env, lval* expr, ltail* tail);
+
+#if defined MLISP_GC
+    /**
+     * Mark the values on the VM stack as reachable (see #gc_mark).
+     */
+    void vm_mark_stack(void);
+#endif
@@ -0,0 +1,75 @@
+from testhelpers import *
+init()
+
+
+def test_array():
+    with run('array 1 2 3') as r:
+        assert is_array(r, [1, 2, 3])
+
+    with run('array {4 5}') as r:
+        assert is_array(r, [4, 5])
+
+    with run('len (array {})') as r:
+        assert is_integer(r, 0)
+
+    with run('array-list (array 1 2)') as r:
+        assert is_int_list(r, [1, 2])
+
+    with run('repr (array 1 "a" {b})') as r:
+        assert is_string(r, '(array 1 "a" {b})')
+
+
+def test_array_set_push():
+    run_single('def {xs} (foldl array-push (array {}) (range 2000))')
+
+    with run('list (len xs) (nth 0 xs) (nth 1234 xs) (last xs)') as r:
+        assert is_int_list(r, [2000, 0, 1234, 1999])
+
+    # Updates leave the original unchanged
+    run_single('def {ys} (array-set xs 1234 0)')
+    with run('list (nth 1234 xs) (nth 1234 ys) (== xs ys) (== xs (array-set ys 1234 1234))') as r:
+        assert is_int_list(r, [1234, 0, 0, 1])
+
+    with run('array-set xs 2000 0') as r:
+        assert is_error(r, 'Function \'array-set\' passed index 2000 out of range, '
+                           'the array has 2000 items.')
+
+    with run('nth 2000 xs') as r:
+        assert is_error(r, 'Function \'nth\' passed index 2000 out of range, '
+                           'the array has 2000 items.')
+
+
+def test_array_list_functions():
+    run_single('def {xs} (array 1 2 3 4)')
+
+    with run('list (head xs) (tail xs) (cons 0 xs) (join xs (array 5) xs)') as r:
+        assert is_array(r.values[0], [1])
+        assert is_array(r.values[1], [2, 3, 4])
+        assert is_array(r.values[2], [0, 1, 2, 3, 4])
+        assert is_array(r.values[3], [1, 2, 3, 4, 5, 1, 2, 3, 4])
+
+    with run('head (array {})') as r:
+        assert is_error(r, 'Function \'head\' passed empty array.')
+
+    with run('join xs {5}') as r:
+        assert is_error(r, 'Function \'join\' passed incorrect argument types. '
+                           'Expected array, got Q-Expression.')
+
+    # Growing at both ends
+    run_single('def {grow} (lambda {a n} {if (== n 0) {a} {grow (array-push (cons n a) n) (- n 1)}})')
+    with run('array-list (grow (array {}) 3)') as r:
+        assert is_int_list(r, [1, 2, 3, 3, 2, 1])
+
+
+def test_array_slice():
+    run_single('def {xs} (foldl array-push (array {}) (range 100))')
+
+    with run('array-slice xs 40 44') as r:
+        assert is_array(r, [40, 41, 42, 43])
+
+    with run('cons 1 (array-push (array-slice xs 50 50) 2)') as r:
+        assert is_array(r, [1, 2])
+
+    with run('array-slice xs 10 101') as r:
+        assert is_error(r, 'Function \'array-slice\' passed range [10, 101) out of range, '
+                           'the array has 100 items.')
@@ -1,3 +1,5 @@
+import time
+
 from testhelpers import *
 init()
 
@@ -20,7 +22,7 @@ def test_head():
 
     with run('head 1') as r:
         assert is_error(r, 'Function \'head\' passed incorrect argument types. '
-                           'Expected Q-Expression, got number.')
+                           'Expected Q-Expression, got integer.')
 
     with run('head {}') as r:
         assert is_error(r, 'Function \'head\' passed empty list.')
@@ -36,11 +38,18 @@ def test_tail():
 
     with run('tail 1') as r:
         assert is_error(r, 'Function \'tail\' passed incorrect argument types. '
-                           'Expected Q-Expression, got number.')
+                           'Expected Q-Expression, got integer.')
 
     with run('tail {}') as r:
         assert is_error(r, 'Function \'tail\' passed empty list.')
 
+    # Slices share the values, the original list is left untouched
+    run_single('def {shared} {1 2 3 4}')
+    with run('list (tail (tail shared)) (tail shared) shared') as r:
+        assert is_int_list(r.values[0], [3, 4])
+        assert is_int_list(r.values[1], [2, 3, 4])
+        assert is_int_list(r.values[2], [1, 2, 3, 4])
+
 
 def test_eval():
     with run('eval {+ 1 2}') as r:
@@ -52,16 +61,24 @@ def test_eval():
 
     with run('eval 1') as r:
         assert is_error(r, 'Function \'eval\' passed incorrect argument types. '
-                           'Expected Q-Expression, got number.')
+                           'Expected Q-Expression, got integer.')
 
 
 def test_join():
     with run('join {1} {2}') as r:
         assert is_qexpr(r) and is_int_list(r, [1, 2])
 
+    with run('join {} {1} {} {2 3} (tail {4 5})') as r:
+        assert is_qexpr(r) and is_int_list(r, [1, 2, 3, 5])
+
+    run_single('def {shared} {1 2}')
+    with run('list (join (tail shared) shared) shared') as r:
+        assert is_int_list(r.values[0], [2, 1, 2])
+        assert is_int_list(r.values[1], [1, 2])
+
     with run('join 1') as r:
         assert is_error(r, 'Function \'join\' passed incorrect argument types. '
-                           'Expected Q-Expression, got number.')
+                           'Expected Q-Expression, got integer.')
 
 
 def test_cons():
@@ -71,6 +88,12 @@ def test_cons():
         assert r.values[0].values[0].num == 1
         assert r.values[1].num == 2
 
+    run_single('def {shared} {2 3}')
+    with run('list (cons 1 (tail shared)) (cons 1 shared) shared') as r:
+        assert is_int_list(r.values[0], [1, 3])
+        assert is_int_list(r.values[1], [1, 2, 3])
+        assert is_int_list(r.values[2], [2, 3])
+
     with run('cons {1}') as r:
         assert is_error(r, 'Function \'cons\' passed too few arguments. '
                            'Expected 2, got 1.')
@@ -81,7 +104,96 @@ def test_cons():
 
     with run('cons 1 1') as r:
         assert is_error(r, 'Function \'cons\' passed incorrect argument types. '
-                           'Expected Q-Expression, got number.')
+                           'Expected Q-Expression, got integer.')
+
+
+def test_build_list():
+    # Values are added in place after or before a shared list, which
+    # doesn't see them
+    run_single('def {base} (join {1 2} {3})')
+    with run('list (join base {4}) (join base {5 6}) (cons 0 base) (cons 9 base) base') as r:
+        assert is_int_list(r.values[0], [1, 2, 3, 4])
+        assert is_int_list(r.values[1], [1, 2, 3, 5, 6])
+        assert is_int_list(r.values[2], [0, 1, 2, 3])
+        assert is_int_list(r.values[3], [9, 1, 2, 3])
+        assert is_int_list(r.values[4], [1, 2, 3])
+
+    # Building a list one value at a time takes linear time, although the
+    # list is shared with the frame of each call
+    run_single('def {append} (lambda {n acc} {if (== n 0) {acc} {append (- n 1) (join acc (list n))}})')
+    run_single('def {prepend} (lambda {n acc} {if (== n 0) {acc} {prepend (- n 1) (cons n acc)}})')
+
+    def build(func, n):
+        start = time.perf_counter()
+        with run('len (%s %d {})' % (func, n)) as r:
+            assert is_number(r, n)
+        return time.perf_counter() - start
+
+    for func in ('append', 'prepend'):
+        small = min(build(func, 10000) for _ in range(3))
+        large = min(build(func, 40000) for _ in range(3))
+        assert large < 8 * small
+
+
+def test_len_nth():
+    with run('list (len {1 2 3}) (len {}) (nth 1 {1 2 3}) (last {1 2 3})') as r:
+        assert is_int_list(r, [3, 0, 2, 3])
+
+    # Items are evaluated like by 1st
+    with run('list (nth 0 {(+ 1 2)}) (last {x {1 2}})') as r:
+        assert is_number(r.values[0], 3) and is_int_list(r.values[1], [1, 2])
+
+    with run('nth 3 {1 2 3}') as r:
+        assert is_error(r, 'Function \'nth\' passed index 3 out of range, the list has 3 items.')
+
+    with run('last {}') as r:
+        assert is_error(r, 'Function \'last\' passed empty list.')
+
+
+def test_take_drop():
+    with run('list (take 2 {1 2 3}) (drop 2 {1 2 3}) (reverse {1 2 3}) (take 0 {})') as r:
+        assert is_int_list(r.values[0], [1, 2])
+        assert is_int_list(r.values[1], [3])
+        assert is_int_list(r.values[2], [3, 2, 1])
+        assert is_empty(r.values[3])
+
+    with run('drop 4 {1 2 3}') as r:
+        assert is_error(r, 'Function \'drop\' passed index 4 out of range, the list has 3 items.')
+
+    with run('list (elem? 2 {1 2 3}) (elem? 4 {1 2 3}) (elem? {1} {{1} 2})') as r:
+        assert is_int_list(r, [1, 0, 1])
+
+
+def test_map_filter_foldl():
+    with run('map (lambda {x} {* x 2}) {1 2 3}') as r:
+        assert is_qexpr(r) and is_int_list(r, [2, 4, 6])
+
+    with run('filter (lambda {x} {== (% x 2) 0}) {1 2 3 4}') as r:
+        assert is_int_list(r, [2, 4])
+
+    with run('list (foldl - 0 {1 2 3}) (foldl + 0 {})') as r:
+        assert is_int_list(r, [-6, 0])
+
+    # Builtins and partially applied lambdas work as callbacks
+    with run('map ((lambda {a b} {+ a b}) 10) {1 2}') as r:
+        assert is_int_list(r, [11, 12])
+
+    with run('foldl + 10 {1 2}') as r:
+        assert is_number(r, 13)
+
+    with run('map - {1 2}') as r:
+        assert is_int_list(r, [-1, -2])
+
+    with run('map (lambda {x} {/ 1 x}) {1 0}') as r:
+        assert is_error(r, 'Division by zero')
+
+    with run('filter (lambda {x} {x}) {1 {}}') as r:
+        assert is_error(r, 'Function \'filter\' passed a function returning Q-Expression, '
+                           'expected number.')
+
+    with run('map 1 {1}') as r:
+        assert is_error(r, 'Function \'map\' passed incorrect argument types. '
+                           'Expected function, got integer.')
 
 
 def test_lambda():
@@ -128,3 +240,132 @@ def test_repr():
 
     with run('repr ((lambda {x y} {* x y}) 1)') as r:
         assert is_string(r, '(lambda {y} {* x y})')
+
+
+def test_backends():
+    for backend in (lib.EVAL_AST, lib.EVAL_VM):
+        lib.eval_set_backend(backend)
+
+        with run('(lambda {x y} {if (> x y) {x} {y}}) 3 7') as r:
+            assert is_number(r, 7)
+
+        with run('if 0 {1}') as r:
+            assert is_sexpr(r) and is_empty(r)
+
+        with run('if {} {1}') as r:
+            assert is_error(r, 'Function \'if\' passed incorrect argument '
+                               'types. Expected number, got Q-Expression.')
+
+        # 'if' can be rebound
+        with run('(lambda {if} {if 1 {2} {3}}) list') as r:
+            assert is_qexpr(r) and r.count == 3
+
+        # Formals can be rebound in the body and bound in several calls
+        with run('(lambda {x y} {tail (list (= {x} 10) (+ x y))}) 1 2') as r:
+            assert is_qexpr(r) and is_number(r.values[0], 12)
+
+        with run('((lambda {x y ... xs} {join (list x y) xs}) 1) 2 3') as r:
+            assert is_qexpr(r) and r.count == 3
+
+        # Partially applied functions can be called several times
+        run_single('def {from_ten} ((lambda {a b} {- a b}) 10)')
+        with run('list (from_ten 1) (from_ten 2)') as r:
+            assert is_number(r.values[0], 9) and is_number(r.values[1], 8)
+
+        # Calls in tail position run in constant stack
+        run_single('def {countdown} (lambda {n} {if (== n 0) {0} {countdown (- n 1)}})')
+        with run('countdown 200000') as r:
+            assert is_number(r, 0)
+
+        run_single('def {odd} (lambda {n} {if (== n 0) {0} {eval {even (- n 1)}}})')
+        run_single('def {even} (lambda {n} {if (== n 0) {1} {odd (- n 1)}})')
+        with run('even 100001') as r:
+            assert is_number(r, 0)
+
+    lib.eval_set_backend(lib.EVAL_VM)
+
+
+def test_special_forms():
+    for backend in (lib.EVAL_AST, lib.EVAL_VM):
+        lib.eval_set_backend(backend)
+
+        # 'and' and 'or' only evaluate their second operand if needed
+        with run('and 0 (error "not evaluated")') as r:
+            assert is_number(r, 0)
+
+        with run('or 1 (error "not evaluated")') as r:
+            assert is_number(r, 1)
+
+        with run('and 1 (error "evaluated")') as r:
+            assert is_error(r, 'evaluated')
+
+        with run('list (and 1 2) (or 0 0) (or 0 3)') as r:
+            assert is_int_list(r, [1, 0, 1])
+
+        with run('and {} 1') as r:
+            assert is_error(r, 'Function \'and\' passed incorrect argument '
+                               'types. Expected number, got Q-Expression.')
+
+        with run('or 0 {}') as r:
+            assert is_error(r, 'Function \'or\' passed incorrect argument '
+                               'types. Expected number, got Q-Expression.')
+
+        # An invalid first operand fails before the second one is evaluated
+        run_single('def {touched} 0')
+        with run('and "x" (def {touched} 1)') as r:
+            assert is_error(r, 'Function \'and\' passed incorrect argument '
+                               'types. Expected number, got string.')
+
+        with run('or {} (error "second")') as r:
+            assert is_error(r, 'Function \'or\' passed incorrect argument '
+                               'types. Expected number, got Q-Expression.')
+
+        with run('touched') as r:
+            assert is_number(r, 0)
+
+        # Only the selected branch of 'if' is evaluated
+        with run('if 0 {error "not evaluated"} {+ 1 2}') as r:
+            assert is_number(r, 3)
+
+        # 'quote' returns its operand unevaluated
+        with run('repr (quote (+ 1 (* 2 x)))') as r:
+            assert is_string(r, '{+ 1 (* 2 x)}')
+
+        with run('len (quote (nothing defined))') as r:
+            assert is_number(r, 2)
+
+        with run('quote 5') as r:
+            assert is_number(r, 5)
+
+        # 'def' and 'lambda' are still checked by the builtins
+        with run('def {answer} (+ 40 2)') as r:
+            assert is_sexpr(r) and is_empty(r)
+        with run('answer') as r:
+            assert is_number(r, 42)
+
+        with run('def {answer} (error "not defined")') as r:
+            assert is_error(r, 'not defined')
+        with run('answer') as r:
+            assert is_number(r, 42)
+
+        with run('def {answer 1} 2') as r:
+            assert is_error(r)
+
+        with run('lambda {x 1} {x}') as r:
+            assert is_error(r)
+
+        # Rebound special forms are called like any other function
+        with run('(lambda {and} {and 0 1}) list') as r:
+            assert is_int_list(r, [0, 1])
+
+        with run('(lambda {quote} {quote (+ 1 2)}) list') as r:
+            assert is_int_list(r, [3])
+
+        # Special forms can be passed to other functions
+        with run('foldl or 0 {0 0 2}') as r:
+            assert is_number(r, 1)
+
+        with run('quote') as r:
+            assert is_func(r)
+
+    lib.eval_set_backend(lib.EVAL_VM)
@@ -0,0 +1,61 @@
+import os
+import testhelpers
+from testhelpers import *
+init()
+
+
+def get_stats():
+    stats = testhelpers.ffi.new('cache_stats*')
+    lib.cache_get_stats(stats)
+    return stats
+
+
+def load(path):
+    with run('load "%s"' % path) as r:
+        assert is_sexpr(r) and is_empty(r)
+
+
+def test_cache(tmp_path, monkeypatch):
+    monkeypatch.setenv('MLISP_CACHE_DIR', str(tmp_path / 'cache'))
+    lib.cache_set_enabled(True)
+
+    try:
+        source = tmp_path / 'cached.sls'
+        source.write_text('(def {a} {1 2.5 "x\\ty" sym {}})\n(def {b} (+ 1 2))')
+        before = get_stats()
+
+        # Read and save first, then loaded from the cache
+        for _ in range(2):
+            load(source)
+            with run('repr (list a b)') as r:
+                assert is_string(r, '{{1 2.5 "x\\ty" sym {}} 3}')
+
+        stats = get_stats()
+        assert stats.misses - before.misses == 1
+        assert stats.hits - before.hits == 1
+        assert stats.writes - before.writes == 1
+
+        # Changed files are read again
+        source.write_text('(def {b} 4)')
+        load(source)
+        with run('b') as r:
+            assert is_number(r, 4)
+
+        assert get_stats().misses - before.misses == 2
+    finally:
+        lib.cache_set_enabled(False)
+
+
+def test_fifo(tmp_path, monkeypatch):
+    monkeypatch.setenv('MLISP_CACHE_DIR', str(tmp_path / 'cache'))
+    lib.cache_set_enabled(True)
+
+    try:
+        # Opening a FIFO blocks until there's a writer, it's never cached
+        fifo = tmp_path / 'fifo.sls'
+        os.mkfifo(fifo)
+        before = get_stats()
+        assert lib.cache_open(str(fifo).encode()) == testhelpers.ffi.NULL
+        assert get_stats().misses == before.misses
+    finally:
+        lib.cache_set_enabled(False)
@@ -38,6 +38,16 @@ def test_ord():
     with run('<= 1 0') as r:
         assert is_number(r, 0)
 
+    # Integers and floats mixed, neighbouring integers are compared exactly
+    with run('< 1 1.5 2 9007199254740993 9007199254740994') as r:
+        assert is_number(r, 1)
+
+    with run('<= 1 1.0 1 2') as r:
+        assert is_number(r, 1)
+
+    with run('> 3 2.5 2.5') as r:
+        assert is_number(r, 0)
+
 
 def test_eq():
     for op, (res, n_res) in zip(['==', '!='], [(1, 0), (0, 1)]):
@@ -0,0 +1,90 @@
+from testhelpers import *
+init()
+
+
+def test_dict():
+    with run('dict "a" 1 "b" 2') as r:
+        assert is_dict(r, 2)
+
+    with run('dict {}') as r:
+        assert is_dict(r, 0)
+
+    with run('len (dict {1 2 3 4 1 5})') as r:
+        assert is_integer(r, 2)
+
+    with run('dict "a"') as r:
+        assert is_error(r, 'Function \'dict\' passed a key without a value.')
+
+    # Integers and floats with equal values are the same key
+    with run('dict-get (dict 1 "int" 1.0 "float") 1') as r:
+        assert is_string(r, 'float')
+
+    # Float keys are compared exactly, like they are hashed
+    with run('list (len (set 0.3 (+ 0.1 0.2))) (set-has? (set 0.3) (+ 0.1 0.2)) '
+             '(len (set (list 0.3) (list (+ 0.1 0.2)))) (len (set (vec 1 2) (vec 1.0 2.0)))') as r:
+        assert is_int_list(r, [2, 0, 2, 1])
+
+    with run('dict-get (dict 0.3 "a") (+ 0.1 0.2) "missing"') as r:
+        assert is_string(r, 'missing')
+
+    with run('dict-get (dict 0.3 "a") (- 0.5 0.2) "missing"') as r:
+        assert is_string(r, 'a')
+
+
+def test_dict_get_put():
+    run_single('def {ages} (dict "ann" 31 "bob" 42 {1 2} "list")')
+
+    with run('list (dict-get ages "bob") (dict-get ages {1 2}) (dict-get ages "eve" 0)') as r:
+        assert is_number(r.values[0], 42)
+        assert is_string(r.values[1], 'list')
+        assert is_number(r.values[2], 0)
+
+    with run('dict-get ages "eve"') as r:
+        assert is_error(r, 'Function \'dict-get\' passed a key that isn\'t in the dictionary.')
+
+    # Updates leave the original unchanged
+    run_single('def {older} (dict-put ages "ann" 32)')
+    with run('list (dict-get ages "ann") (dict-get older "ann") (len older)') as r:
+        assert is_int_list(r, [31, 32, 3])
+
+    with run('== older (dict-put ages "ann" 32)') as r:
+        assert is_integer(r, 1)
+
+    with run('dict-put {1 2} 1 2') as r:
+        assert is_error(r, 'Function \'dict-put\' passed incorrect argument types. '
+                           'Expected dictionary, got Q-Expression.')
+
+    # Many keys, most of them sharing the first levels of the trie
+    run_single('def {squares} (foldl (lambda {d x} {dict-put d x (* x x)}) (dict {}) (range 5000))')
+    with run('list (len squares) (dict-get squares 4321) (foldl + 0 (dict-keys squares))') as r:
+        assert is_int_list(r, [5000, 4321 * 4321, sum(range(5000))])
+
+
+def test_set():
+    with run('len (set 1 2 1 {1 2} {1 2} "a")') as r:
+        assert is_integer(r, 4)
+
+    with run('set {3 1 2 3}') as r:
+        assert is_set(r, 3)
+
+    run_single('def {seen} (foldl set-add (set {}) {1 2 3 2 1})')
+    with run('list (set-has? seen 2) (set-has? seen 4) (set-has? (set-add seen 4) 4) (len seen)') as r:
+        assert is_int_list(r, [1, 0, 1, 3])
+
+    with run('== (set 1 2 3) (set 3 2 1)') as r:
+        assert is_integer(r, 1)
+
+    with run('set-has? (dict 1 2) 1') as r:
+        assert is_integer(r, 1)
+
+    with run('set-has? {1 2} 1') as r:
+        assert is_error(r, 'Function \'set-has?\' passed incorrect argument types. '
+                           'Expected dictionary or set, got Q-Expression.')
+
+
+def test_dict_keys():
+    with run('dict-keys (dict 1 "a" 2 "b" 3 "c")') as r:
+        assert is_qexpr(r) and sorted(v.num for v in r.values) == [1, 2, 3]
+
+    with run('dict-keys (set {})') as r:
+        assert is_qexpr(r) and is_empty(r)
@@ -0,0 +1,75 @@
+import struct
+import testhelpers
+from testhelpers import *
+init()
+
+
+def image(func, path):
+    result = func(testhelpers.env, str(path).encode())
+    try:
+        return result.type == lib.LVAL_SEXPR and result.count == 0
+    finally:
+        lib.lval_del(result)
+
+
+def test_save_and_load(tmp_path):
+    path = tmp_path / 'env.img'
+    run_single('def {sq} (lambda {x} {* x x})')
+    run_single('def {inc} ((lambda {a b} {+ a b}) 1)')
+    run_single('def {items add} {"a\tb" sym 1.5} +')
+    run_single('def {ints floats} (vec 1 0 2) (vec 0.5 2.5)')
+    run_single('def {odds} (lazy-filter (lambda {x} {% x 2}) (range 7 0 (- 0 1)))')
+    run_single('def {ages names} (dict "ann" 31 "bob" 42) (set "ann" "bob" "ann")')
+    run_single('def {scores} (array-set (array 1 2 3) 1 "two")')
+    assert image(lib.image_save, path)
+
+    reset_env()
+    with run('sq 4') as r:
+        assert is_error(r)
+
+    assert image(lib.image_load, path)
+
+    with run('list (sq 4) (inc 2) (add 1 2)') as r:
+        assert is_int_list(r, [16, 3, 3])
+
+    with run('repr items') as r:
+        assert is_string(r, '{"a\\tb" sym 1.5}')
+
+    with run('list ints floats') as r:
+        assert is_vector(r.values[0], [1, 0, 2], integers=True)
+        assert is_vector(r.values[1], [0.5, 2.5], integers=False)
+
+    with run('realize odds') as r:
+        assert is_int_list(r, [7, 5, 3, 1])
+
+    with run('list (dict-get ages "bob") (set-has? names "ann") (len names)') as r:
+        assert is_int_list(r, [42, 1, 2])
+
+    with run('repr scores') as r:
+        assert is_string(r, '(array 1 "two" 3)')
+
+
+def test_invalid(tmp_path):
+    path = tmp_path / 'invalid.img'
+    assert not image(lib.image_load, path)
+
+    path.write_text('(def {x} 1)')
+    assert not image(lib.image_load, path)
+
+
+def test_invalid_lambda(tmp_path):
+    path = tmp_path / 'lambda.img'
+    run_single('def {sq} (lambda {x} {* x x})')
+    assert image(lib.image_save, path)
+
+    data = bytearray(path.read_bytes())
+    header = struct.calcsize('<8sIIQQQ')
+    _, _, _, records, _, _ = struct.unpack_from('<8sIIQQQ', data)
+    kinds = [struct.unpack_from('<IIQ', data, header + 16 * i) for i in range(records)]
+    number = next(i for i, (kind, _, _) in enumerate(kinds) if kind == 3)
+    offset = next(offset for kind, _, offset in kinds if kind == 11)
+
+    # Replace the body of the lambda by an integer
+    struct.pack_into('<I', data, header + 16 * records + 4 * (offset + 1), number)
+    path.write_bytes(bytes(data))
+    assert not image(lib.image_load, path)
@@ -1,3 +1,5 @@
+import math
+
 from testhelpers import *
 init()
 
@@ -14,6 +16,118 @@ def test_integer():
     with run('% 17 12') as r:
         assert is_number(r, 5)
 
+    # Small integers are shared, computing with them doesn't modify them
+    run_single('def {small} 5')
+    with run('list (+ small 1) (- small) small (* 1000 1000)') as r:
+        assert is_int_list(r, [6, -5, 5, 1000000])
+
+    # Integers stay integers unless a division has a remainder
+    with run('/ 12 4') as r:
+        assert is_integer(r, 3)
+
+    with run('/ 7 2') as r:
+        assert is_float(r, 3.5)
+
+    with run('+ 1 2.0') as r:
+        assert is_float(r, 3)
+
+    with run('repr (list 2 (* 1.0 2) 0.5)') as r:
+        assert is_string(r, '{2 2.0 0.5}')
+
+    # Integers are exact beyond the precision of floats
+    with run('- 9007199254740993 9007199254740992') as r:
+        assert is_integer(r, 1)
+
+    with run('> 9007199254740993 9007199254740992') as r:
+        assert is_integer(r, 1)
+
+    # Results that overflow and literals that don't fit become big integers
+    with run('* 9223372036854775807 2') as r:
+        assert is_integer(r, 2 ** 64 - 2)
+
+    with run('- 1 9223372036854775807 3') as r:
+        assert is_integer(r, -2 ** 63 - 1)
+
+    with run('repr 9223372036854775808') as r:
+        assert is_string(r, '9223372036854775808')
+
+    with run('== 1 1.0') as r:
+        assert is_integer(r, 1)
+
+    # Integers and floats are compared exactly, too
+    with run('list (== 9007199254740993 9007199254740992.0) (!= 9007199254740993 9007199254740992.0) '
+             '(> 9007199254740993 9007199254740992.0) (< 9007199254740992.0 9007199254740993) '
+             '(== 9007199254740992 9007199254740992.0) (< 2 2.5) (> (- 0 2) (- 0 2.5)) (== 1 1.5) '
+             '(== 9223372036854775807 9223372036854775808.0) (< 9223372036854775807 9223372036854775808.0)') as r:
+        assert is_int_list(r, [0, 1, 1, 1, 1, 1, 1, 0, 0, 1])
+
+    # Long sums of integers are only checked for overflows at the end
+    with run('list (+ 9223372036854775807 (- 0 1) 1) (+ 4294967295 4294967297 (- 0 8589934592)) '
+             '(- (- 0 9223372036854775807) 1) (- 4294967296 (- 0 4294967296) 1)') as r:
+        assert r.values[0].type == lib.LVAL_INT and r.values[0].num == 2 ** 63 - 1
+        assert r.values[2].type == lib.LVAL_INT and r.values[2].num == -2 ** 63
+        assert is_int_list(r, [2 ** 63 - 1, 0, -2 ** 63, 2 ** 33 - 1])
+
+    with run('+ 9223372036854775807 1') as r:
+        assert is_integer(r, 2 ** 63)
+
+
+
+def test_big():
+    run_single('def {fact} (lambda {n} {if (== n 0) {1} {* n (fact (- n 1))}})')
+    with run('fact 100') as r:
+        assert is_integer(r, math.factorial(100))
+
+    # Results that fit are plain integers again
+    with run('/ (fact 30) (fact 28)') as r:
+        assert r.type == lib.LVAL_INT and r.num == 30 * 29
+
+    with run('- 9223372036854775808 1') as r:
+        assert r.type == lib.LVAL_INT and r.num == 2 ** 63 - 1
+
+    with run('/ (fact 30) 7') as r:
+        assert is_integer(r, math.factorial(30) // 7)
+
+    with run('/ (+ (fact 30) 1) 2') as r:
+        assert is_float(r)
+
+    with run('list (> (fact 30) (fact 29)) (< (- 0 (fact 30)) 1) (== (fact 25) (fact 25)) (== (fact 25) 1.0) (> (fact 25) 1.5)') as r:
+        assert is_int_list(r, [1, 1, 1, 0, 1])
+
+    # Big integers and floats are compared exactly, too
+    with run('list (== 18446744073709551616 18446744073709551616.0) (== 18446744073709551617 18446744073709551616.0) '
+             '(> 18446744073709551617 18446744073709551616.0) (< (fact 25) 15511210043330986000000000.0) '
+             '(== (fact 25) 15511210043330986000000000.0) (< (- 0 (fact 30)) (- 0 1.5))') as r:
+        assert is_int_list(r, [1, 0, 1, 1, 0, 1])
+
+    with run('% (fact 30) 0') as r:
+        assert is_error(r, 'Division by zero')
+
+    # Schoolbook and Karatsuba multiplication, long division
+    values = [7 ** 20, 3 ** 700 + 11, 5 ** 1500 - 2 ** 900, 13 ** 3000 + 1]
+    for x in values:
+        for y in values:
+            for sx, sy in ((1, 1), (-1, 1), (1, -1)):
+                a, b = sx * x, sy * y
+                with run('list (* %s) (+ %s) (- %s) (/ (* %s) %s) (%% %s)' % (
+                        _args(a, b), _args(a, b), _args(a, b), _args(a, b), _arg(b), _args(a, b))) as r:
+                    quotient = abs(a) // abs(b) * (1 if (a < 0) == (b < 0) else -1)
+                    remainder = abs(a) % abs(b) * (1 if a >= 0 else -1)
+                    assert [v.num for v in r.values] == [a * b, a + b, a - b, a, remainder]
+                    with run('/ %s' % _args(a, b)) as q:
+                        if remainder == 0:
+                            assert is_integer(q, quotient)
+                        else:
+                            assert is_float(q)
+
+
+def _arg(x):
+    return str(x) if x >= 0 else '(- 0 %d)' % -x
+
+
+def _args(x, y):
+    return '%s %s' % (_arg(x), _arg(y))
+
 
 def test_float():
     with run('/ 1 2') as r:
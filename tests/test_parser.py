@@ -0,0 +1,63 @@
+import pytest
+
+from testhelpers import *
+init()
+
+
+def test_atoms():
+    with run('repr {1st 2nd3x abc12 -5 1.5.5 a.b}') as r:
+        assert is_string(r, '{1st 2nd3x abc 12 - 5 1.5 . 5 a.b}')
+
+    with run('repr {"a \\"b\\"" ; comment\n 7}') as r:
+        assert is_string(r, '{"a \\"b\\"" 7}')
+
+
+def test_nesting():
+    with run('list {1 {2 (3)}} (+ 1 2)') as r:
+        assert is_qexpr(r) and r.count == 2
+        assert is_qexpr(r.values[0].values[1])
+        assert is_number(r.values[1], 3)
+
+
+def test_errors():
+    for line in ('(+ 1 2', '{1 2', '1 2)', '"abc', '[1]'):
+        with pytest.raises(ParserError):
+            run_single(line)
+
+
+def test_load(tmp_path):
+    source = tmp_path / 'forms.sls'
+    source.write_text('(def {a} 1) (def {b} {2\n3}) ; comment )\n'
+                      '(def {c} "x\n)y")\n(def {d} (+ a 1))')
+
+    with run('load "%s"' % source) as r:
+        assert is_sexpr(r) and is_empty(r)
+
+    with run('list a b c d') as r:
+        assert is_number(r.values[0], 1)
+        assert is_int_list(r.values[1], [2, 3])
+        assert is_string(r.values[2], 'x\n)y')
+        assert is_number(r.values[3], 2)
+
+    # Expressions before a syntax error have been evaluated
+    source.write_text('(def {e} 5)\n(def {f}')
+
+    with run('load "%s"' % source) as r:
+        assert is_error(r)
+
+    with run('e') as r:
+        assert is_number(r, 5)
+
+
+def test_load_slices(tmp_path):
+    # Strings are unescaped, the last symbol ends with the file
+    source = tmp_path / 'slices.sls'
+    text = '(def {g} "t\\tq\\"\\\\n") (def {h} 4)\n(def {i} h)'
+    source.write_text(text + ' ' * (4096 - len(text) - 1) + 'h')
+
+    with run('load "%s"' % source) as r:
+        assert is_sexpr(r) and is_empty(r)
+
+    with run('list g i') as r:
+        assert is_string(r.values[0], 't\tq"\\n')
+        assert is_number(r.values[1], 4)
@@ -0,0 +1,80 @@
+import testhelpers
+from testhelpers import *
+init()
+
+
+def test_range():
+    with run('range 3') as r:
+        assert is_seq(r)
+
+    with run('realize (range 4)') as r:
+        assert is_int_list(r, [0, 1, 2, 3])
+
+    with run('realize (range 2 5)') as r:
+        assert is_int_list(r, [2, 3, 4])
+
+    with run('realize (range 5 0 (- 0 2))') as r:
+        assert is_int_list(r, [5, 3, 1])
+
+    with run('realize (range 3 3)') as r:
+        assert is_qexpr(r) and is_empty(r)
+
+    with run('range 0 5 0') as r:
+        assert is_error(r, 'Function \'range\' passed step 0.')
+
+    with run('range 1.5') as r:
+        assert is_error(r, 'Function \'range\' passed incorrect argument types. '
+                           'Expected integer, got float.')
+
+
+def test_stages():
+    with run('realize (lazy-map (lambda {x} {* x x}) (range 5))') as r:
+        assert is_int_list(r, [0, 1, 4, 9, 16])
+
+    with run('realize (lazy-filter (lambda {x} {% x 2}) {1 2 3 4 5})') as r:
+        assert is_int_list(r, [1, 3, 5])
+
+    with run('realize (take-while (lambda {x} {< x 4}) (range 100))') as r:
+        assert is_int_list(r, [0, 1, 2, 3])
+
+    with run('realize {1 2}') as r:
+        assert is_int_list(r, [1, 2])
+
+    # A sequence can be consumed again
+    run_single('def {odd-squares} (lazy-map (lambda {x} {* x x}) (lazy-filter (lambda {x} {% x 2}) (range 10)))')
+    with run('list (realize odd-squares) (realize odd-squares)') as r:
+        assert is_int_list(r.values[0], [1, 9, 25, 49, 81])
+        assert is_int_list(r.values[1], [1, 9, 25, 49, 81])
+
+    with run('realize (lazy-filter (lambda {x} {"no"}) (range 3))') as r:
+        assert is_error(r, 'Sequence stage function returned string, expected number.')
+
+    with run('realize (lazy-map (lambda {x} {/ 1 x}) (range 3))') as r:
+        assert is_error(r)
+
+    with run('lazy-map (lambda {x} {x}) 5') as r:
+        assert is_error(r, 'Function \'lazy-map\' passed incorrect argument types. '
+                           'Expected sequence or Q-Expression, got integer.')
+
+
+def test_foldl():
+    # Folding a sequence pulls its items one at a time
+    with run('foldl + 0 (lazy-filter (lambda {x} {== (% x 3) 0}) (lazy-map (lambda {x} {* x 2}) (range 100000)))') as r:
+        assert is_integer(r, sum(x * 2 for x in range(100000) if x * 2 % 3 == 0))
+
+    with run('foldl + 0 (range 0)') as r:
+        assert is_integer(r, 0)
+
+
+def test_lines(tmp_path):
+    path = tmp_path / 'lines.txt'
+    path.write_bytes(b'first\nsecond\r\n\n' + b'x' * 1000 + b'\nlast')
+
+    with run('realize (lines "%s")' % path) as r:
+        assert [v.str for v in r.values] == ['first', 'second', '', 'x' * 1000, 'last']
+
+    with run('foldl (lambda {n s} {+ n (str-len s)}) 0 (lines "%s")' % path) as r:
+        assert is_integer(r, 1015)
+
+    with run('realize (lines "%s")' % (tmp_path / 'missing.txt')) as r:
+        assert is_error(r, 'Could not open file \'%s\'' % (tmp_path / 'missing.txt'))
@@ -14,4 +14,99 @@ def test_string():
 
 def test_comments():
     with run('5 ; this is a comment') as r:
-        assert is_number(r, 5)
\ No newline at end of file
+        assert is_number(r, 5)
+
+def test_concat():
+    with run('concat "foo" "" "bar"') as r:
+        assert is_string(r, 'foobar')
+
+    with run('concat "foo" 1') as r:
+        assert is_error(r, 'Function \'concat\' passed incorrect argument types. '
+                           'Expected string, got integer.')
+
+    # Extending a string doesn't change strings sharing its characters
+    run_single('def {ab} "ab"')
+    run_single('def {abc} (concat ab "c")')
+    with run('list ab abc (concat ab "d") (concat abc "e")') as r:
+        assert [r.values[i].str for i in range(4)] == ['ab', 'abc', 'abd', 'abce']
+
+    run_single('def {repeat} (lambda {s n} {if (== n 0) {s} {repeat (concat s "xy") (- n 1)}})')
+    with run('str-len (repeat "" 1000)') as r:
+        assert is_integer(r, 2000)
+
+
+def test_substr():
+    with run('substr "hello" 1 3') as r:
+        assert is_string(r, 'el')
+
+    with run('substr "hello" 2') as r:
+        assert is_string(r, 'llo')
+
+    with run('list (substr "hello" 5) (substr "hello" 0 0)') as r:
+        assert r.values[0].str == '' and r.values[1].str == ''
+
+    with run('substr "hello" 3 6') as r:
+        assert is_error(r, 'Function \'substr\' passed range [3, 6) out of range, '
+                           'the string has 5 characters.')
+
+    with run('== (substr "hello" 1 3) "el"') as r:
+        assert is_integer(r, 1)
+
+    # Substrings are terminated when they are used as C strings
+    with run('error (substr "hello" 1 3)') as r:
+        assert is_error(r, 'el')
+
+
+def test_split():
+    with run('split "a,b,,c" ","') as r:
+        assert is_qexpr(r) and [r.values[i].str for i in range(r.count)] == ['a', 'b', '', 'c']
+
+    with run('split "a--b--" "--"') as r:
+        assert [r.values[i].str for i in range(r.count)] == ['a', 'b', '']
+
+    with run('split "" ","') as r:
+        assert r.count == 1 and r.values[0].str == ''
+
+    # Given an index, lists are split
+    with run('split 2 {1 2 3 4}') as r:
+        assert is_qexpr(r) and is_int_list(r.values[0], [1, 2]) and is_int_list(r.values[1], [3, 4])
+
+    with run('split 3 {1 2}') as r:
+        assert is_error(r, 'Function \'split\' passed index 3 out of range, the list has 2 items.')
+
+    with run('split "abc" ""') as r:
+        assert is_error(r, 'Function \'split\' passed empty separator.')
+
+
+def test_find():
+    with run('list (find "hello" "l") (find "hello" "lo") (find "hello" "x") (find "hello" "")') as r:
+        assert [r.values[i].num for i in range(4)] == [2, 3, -1, 0]
+
+    with run('list (find "hello" "l" 3) (find "hello" "h" 1) (find "hello" "" 5)') as r:
+        assert [r.values[i].num for i in range(3)] == [3, -1, 5]
+
+    with run('find "hello" "l" 6') as r:
+        assert is_error(r)
+
+
+def test_str_len():
+    with run('list (str-len "hello") (str-len "") (str-len "a\\nb")') as r:
+        assert is_int_list(r, [5, 0, 3])
+
+    with run('str-len 5') as r:
+        assert is_error(r)
+
+
+def test_str_to_num():
+    with run('str->num "42"') as r:
+        assert is_integer(r, 42)
+
+    with run('str->num "-2.5"') as r:
+        assert is_float(r, -2.5)
+
+    with run('str->num "123456789012345678901234567890"') as r:
+        assert r.type == lib.LVAL_BIG
+
+    for text in ['', '-', '1.', '1a', ' 1']:
+        with run('str->num "%s"' % text) as r:
+            assert is_error(r, 'Function \'str->num\' passed a string that isn\'t a number.')
@@ -0,0 +1,132 @@
+import math
+
+from testhelpers import *
+init()
+
+def test_create():
+    with run('vec 1 2 3') as r:
+        assert is_vector(r, [1, 2, 3], integers=True)
+
+    # Any float makes a float vector, big integers are rounded
+    with run('vec {1 2.5 3}') as r:
+        assert is_vector(r, [1, 2.5, 3], integers=False)
+
+    with run('vec 1 9223372036854775808') as r:
+        assert is_vector(r, [1, 2.0 ** 63], integers=False)
+
+    with run('vec {}') as r:
+        assert is_vector(r, [])
+
+    with run('vec 1 {2}') as r:
+        assert is_error(r, 'Function \'vec\' passed incorrect argument types. '
+                           'Expected number, got Q-Expression.')
+
+    with run('repr (list (vec 1 2) (vec 1.0 2.5))') as r:
+        assert is_string(r, '{[1 2] [1.0 2.5]}')
+
+    with run('vec-list (vec 1 2.5)') as r:
+        assert is_qexpr(r) and is_float(r.values[0], 1) and is_float(r.values[1], 2.5)
+
+    with run('list (vec-len (vec 1 2 3)) (vec-get (vec 1 2 3) 2)') as r:
+        assert is_int_list(r, [3, 3])
+
+    with run('vec-get (vec 1 2 3) 3') as r:
+        assert is_error(r, 'Function \'vec-get\' passed index 3 out of range, '
+                           'the vector has 3 items.')
+
+    with run('vec-slice (vec 1 2 3 4) 1 3') as r:
+        assert is_vector(r, [2, 3])
+
+    with run('vec-slice (vec 1 2 3 4) 3 5') as r:
+        assert is_error(r)
+
+    with run('list (== (vec 1 2) (vec 1.0 2.0)) (== (vec 1 2) (vec 1 2 3)) (== (vec 1) 1)') as r:
+        assert is_int_list(r, [1, 0, 0])
+
+
+def test_arithmetic():
+    with run('v+ (vec 1 2 3) (vec 10 20 30)') as r:
+        assert is_vector(r, [11, 22, 33], integers=True)
+
+    # Numbers are paired with every item
+    with run('v- 10 (vec 1 2 3)') as r:
+        assert is_vector(r, [9, 8, 7], integers=True)
+
+    with run('v* (vec 1 2 3) 0.5') as r:
+        assert is_vector(r, [0.5, 1, 1.5], integers=False)
+
+    # Like numbers, integers stay integers unless a division has a remainder
+    with run('v/ (vec 2 4 6) 2') as r:
+        assert is_vector(r, [1, 2, 3], integers=True)
+
+    with run('v/ (vec 1 2 3) 2') as r:
+        assert is_vector(r, [0.5, 1, 1.5], integers=False)
+
+    with run('v% (vec 7 8 9) 4') as r:
+        assert is_vector(r, [3, 0, 1], integers=True)
+
+    with run('v/ (vec 1 2 3) (vec 1 0 1)') as r:
+        assert is_error(r, 'Division by zero')
+
+    # Vectors can't hold big integers, overflows are computed with floats
+    with run('v* (vec 9223372036854775807 2) 2') as r:
+        assert is_vector(r, [2.0 ** 64, 4], integers=False)
+
+    with run('v+ (vec 1 2) (vec 1 2 3)') as r:
+        assert is_error(r, 'Function \'v+\' passed vectors of different lengths: 2 and 3.')
+
+    with run('v+ 1 2') as r:
+        assert is_error(r, 'Function \'v+\' passed incorrect argument types. '
+                           'Expected at least one vector.')
+
+    # Lengths around the width of the SIMD registers
+    for n in range(1, 20):
+        items = ' '.join('%d.5' % i for i in range(n))
+        with run('v- (v* (vec %s) 2.0) (vec %s)' % (items, items)) as r:
+            assert is_vector(r, [i + 0.5 for i in range(n)])
+
+
+def test_compare():
+    with run('v< (vec 1 2 3 4 5) 3') as r:
+        assert is_vector(r, [1, 1, 0, 0, 0], integers=True)
+
+    with run('v>= (vec 1.5 2.5 3.5) (vec 2 2.5 3)') as r:
+        assert is_vector(r, [0, 1, 1])
+
+    with run('list (v== (vec 1 2 3) 2) (v!= (vec 1 2 3) 2) (v> 2 (vec 1 2 3)) (v<= (vec 1 2 3) 2)') as r:
+        assert [v.values for v in r.values] == [[0, 1, 0], [1, 0, 1], [1, 0, 0], [1, 1, 0]]
+
+
+def test_reduce():
+    with run('list (vec-sum (vec 1 2 3)) (vec-dot (vec 1 2 3) (vec 4 5 6))') as r:
+        assert is_int_list(r, [6, 32])
+
+    with run('vec-sum (vec 0.5 1.5 2.5 3.5 4.5)') as r:
+        assert is_float(r, 12.5)
+
+    with run('vec-dot (vec 1 2 3) (vec 0.5 0.5 0.5)') as r:
+        assert is_float(r, 3)
+
+    # Sums of integers are exact
+    with run('vec-sum (vec 9223372036854775807 9223372036854775807 1)') as r:
+        assert is_integer(r, 2 ** 64 - 1)
+
+    with run('vec-dot (vec 4294967296 1) (vec 4294967296 2)') as r:
+        assert is_integer(r, 2 ** 64 + 2)
+
+    with run('list (vec-min (vec 3 1 2)) (vec-max (vec 3 1 2))') as r:
+        assert is_int_list(r, [1, 3])
+
+    with run('vec-max (vec 1.5 9.5 2.5 9.5 0.5)') as r:
+        assert is_float(r, 9.5)
+
+    with run('vec-min (vec {})') as r:
+        assert is_error(r, 'Function \'vec-min\' passed empty vector.')
+
+    # Sums and dot products of many floats
+    items = [float('%.15f' % abs(math.sin(i))) for i in range(1000)]
+    run_single('def {v} (vec %s)' % ' '.join('%.15f' % x for x in items))
+    with run('list (vec-sum v) (vec-dot v v) (vec-max v)') as r:
+        assert abs(r.values[0].num - math.fsum(items)) < 1e-9
+        assert abs(r.values[1].num - math.fsum(x * x for x in items)) < 1e-9
+        assert r.values[2].num == max(items)
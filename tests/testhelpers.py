@@ -2,6 +2,7 @@ import re
 import os
 import platform
 import subprocess
+import sys
 from contextlib import contextmanager
 
 from cffi import FFI
@@ -38,6 +39,10 @@ lib = ffi.dlopen(dll_file)
 # Initialize environment
 env = None
 
+# Big integers are converted from their decimal representation
+if hasattr(sys, 'set_int_max_str_digits'):
+    sys.set_int_max_str_digits(0)
+
 
 def _ptr_to_addr(ptr):
     addr = ffi.cast('int', ptr)
@@ -55,16 +60,30 @@ class lval(object):
         self.type_name = ffi.string(ffi.cast("lval_type", self.type))
         self._repr = '<lval %s>' % self.type_name
 
-        if self.type == lib.LVAL_NUM:
+        if self.type == lib.LVAL_INT:
+            self.num = obj.integer
+            self._repr = '<lval int: %i>' % self.num
+
+        elif self.type == lib.LVAL_BIG:
+            self.num = int(ffi.string(lib.lval_to_str(env, obj)))
+            self._repr = '<lval big: %i>' % self.num
+
+        elif self.type == lib.LVAL_NUM:
             self.num = obj.num
-            self._repr = '<lval num: %i>' % self.num
+            self._repr = '<lval num: %g>' % self.num
+
+        elif self.type == lib.LVAL_VEC:
+            items = obj.vec.ints if obj.vec.integers else obj.vec.floats
+            self.integers = bool(obj.vec.integers)
+            self.values = [items[i] for i in range(obj.vec.count)]
+            self._repr = '<lval vector: %s>' % self
 
         elif self.type == lib.LVAL_ERR:
             self.err = ffi.string(obj.err)
             self._repr = '<lval error: "%s">' % self.err
 
         elif self.type == lib.LVAL_STR:
-            self.str = ffi.string(obj.str)
+            self.str = ffi.string(obj.str, obj.length)
             self._repr = '<lval string: "%s">' % self.str
 
         elif self.type in (lib.LVAL_QEXPR, lib.LVAL_SEXPR):
@@ -85,6 +104,18 @@ class lval(object):
                 self.formals = obj.formals
                 self.body = obj.body
 
+        elif self.type == lib.LVAL_SEQ:
+            self.kind = obj.seq.kind
+
+        elif self.type in (lib.LVAL_DICT, lib.LVAL_SET):
+            self.count = obj.dict.count
+            self._repr = '<lval %s: %s>' % (self.type_name, self)
+
+        elif self.type == lib.LVAL_ARRAY:
+            self.count = obj.array.count
+            self.values = [lval(lib.larray_get(obj.array, i)) for i in range(self.count)]
+            self._repr = '<lval array: %s>' % self
+
         else:
             raise NotImplementedError('Type %s not yet implemented' % self.type_name)
 
@@ -98,7 +129,6 @@ class lval(object):
 # Initialization
 
 def init():
-    lib.parser_init()
     init_env()
 
 
@@ -137,7 +167,7 @@ def run_single(line):
 # Test helpers
 
 def is_number(x, val=None):
-    if not x.type == lib.LVAL_NUM:
+    if not x.type in (lib.LVAL_INT, lib.LVAL_BIG, lib.LVAL_NUM):
         return False
 
     if val:
@@ -146,6 +176,14 @@ def is_number(x, val=None):
         return True
 
 
+def is_integer(x, val=None):
+    return x.type in (lib.LVAL_INT, lib.LVAL_BIG) and is_number(x, val)
+
+
+def is_float(x, val=None):
+    return x.type == lib.LVAL_NUM and is_number(x, val)
+
+
 def is_string(x, val=None):
     if not x.type == lib.LVAL_STR:
         return False
@@ -181,6 +219,39 @@ def is_int_list(x, values):
         return all(values[i] == x.values[i].num for i in range(x.count))
 
 
+def is_vector(x, values=None, integers=None):
+    if not x.type == lib.LVAL_VEC:
+        return False
+
+    if integers is not None and x.integers != integers:
+        return False
+
+    if values is not None:
+        return len(values) == len(x.values) and \
+            all(round(a, 3) == b for a, b in zip(x.values, values))
+    else:
+        return True
+
+
+def is_seq(x):
+    return x.type == lib.LVAL_SEQ
+
+
+def is_dict(x, count=None):
+    return x.type == lib.LVAL_DICT and (count is None or x.count == count)
+
+
+def is_set(x, count=None):
+    return x.type == lib.LVAL_SET and (count is None or x.count == count)
+
+
+def is_array(x, values=None):
+    if not x.type == lib.LVAL_ARRAY:
+        return False
+
+    return values is None or [v.num for v in x.values] == values
+
+
 def is_sexpr(x):
     return x.type == lib.LVAL_SEXPR
 
@@ -199,5 +270,5 @@ def is_func(x, val=None):
         return True
 
 __all__ = ('lib', 'init', 'reset_env', 'run', 'run_single',
-           'is_number', 'is_string', 'is_error', 'is_qexpr', 'is_sexpr',
-           'is_func', 'is_empty', 'is_int_list')
+           'is_number', 'is_integer', 'is_float', 'is_string', 'is_error', 'is_qexpr', 'is_seq', 'is_dict', 'is_set', 'is_array', 'is_sexpr',
+           'is_func', 'is_empty', 'is_int_list', 'is_vector', 'ParserError')